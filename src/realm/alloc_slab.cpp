@@ -253,7 +253,16 @@ SlabAlloc::FreeBlock* SlabAlloc::get_next_block_if_mergeable(SlabAlloc::FreeBloc
 SlabAlloc::FreeList SlabAlloc::find(int size)
 {
     FreeList retval;
-    retval.it = m_block_map.lower_bound(size);
+    if (size < small_block_limit) {
+        retval.size = find_small(size);
+        if (retval.found_something())
+            return retval;
+        // all blocks in the map are larger
+        retval.it = m_block_map.begin();
+    }
+    else {
+        retval.it = m_block_map.lower_bound(size);
+    }
     if (retval.it != m_block_map.end()) {
         retval.size = retval.it->first;
     }
@@ -266,15 +275,53 @@ SlabAlloc::FreeList SlabAlloc::find(int size)
 SlabAlloc::FreeList SlabAlloc::find_larger(FreeList hint, int size)
 {
     int needed_size = size + sizeof(BetweenBlocks) + sizeof(FreeBlock);
+    if (needed_size < small_block_limit) {
+        hint.size = find_small(needed_size);
+        if (hint.found_something())
+            return hint;
+        hint.it = m_block_map.begin();
+    }
+    else if (hint.size < small_block_limit) {
+        hint.it = m_block_map.lower_bound(needed_size);
+    }
     while (hint.it != m_block_map.end() && hint.it->first < needed_size)
         ++hint.it;
     if (hint.it == m_block_map.end())
         hint.size = 0; // indicate "not found"
+    else
+        hint.size = hint.it->first;
     return hint;
 }
 
+int SlabAlloc::find_small(int size) const noexcept
+{
+    size_t ndx = size_t(size) / 8;
+    uint64_t mask = ~uint64_t(0) << (ndx % 64);
+    for (size_t word = ndx / 64; word < num_small_lists / 64; ++word) {
+        uint64_t bits = m_small_lists_used[word] & mask;
+        if (bits)
+            return int((word * 64 + count_trailing_zeros(bits)) * 8);
+        mask = ~uint64_t(0);
+    }
+    return 0;
+}
+
 SlabAlloc::FreeBlock* SlabAlloc::pop_freelist_entry(FreeList list)
 {
+    if (list.size < small_block_limit) {
+        size_t ndx = size_t(list.size) / 8;
+        FreeBlock* retval = m_small_lists[ndx];
+        FreeBlock* header = retval->next;
+        if (header == retval) {
+            m_small_lists[ndx] = nullptr;
+            m_small_lists_used[ndx / 64] &= ~(uint64_t(1) << (ndx % 64));
+        }
+        else {
+            m_small_lists[ndx] = header;
+        }
+        retval->unlink();
+        return retval;
+    }
     FreeBlock* retval = list.it->second;
     FreeBlock* header = retval->next;
     if (header == retval)
@@ -297,6 +344,20 @@ void SlabAlloc::FreeBlock::unlink()
 void SlabAlloc::remove_freelist_entry(FreeBlock* entry)
 {
     int size = bb_before(entry)->block_after_size;
+    if (size < small_block_limit) {
+        size_t ndx = size_t(size) / 8;
+        if (m_small_lists[ndx] == entry) {
+            if (entry->next == entry) {
+                m_small_lists[ndx] = nullptr;
+                m_small_lists_used[ndx / 64] &= ~(uint64_t(1) << (ndx % 64));
+            }
+            else {
+                m_small_lists[ndx] = entry->next;
+            }
+        }
+        entry->unlink();
+        return;
+    }
     auto it = m_block_map.find(size);
     REALM_ASSERT_EX(it != m_block_map.end(), get_file_path_for_assertions());
     auto header = it->second;
@@ -313,6 +374,22 @@ void SlabAlloc::remove_freelist_entry(FreeBlock* entry)
 void SlabAlloc::push_freelist_entry(FreeBlock* entry)
 {
     int size = bb_before(entry)->block_after_size;
+    if (size < small_block_limit) {
+        size_t ndx = size_t(size) / 8;
+        FreeBlock* header = m_small_lists[ndx];
+        m_small_lists[ndx] = entry;
+        if (header) {
+            entry->next = header;
+            entry->prev = header->prev;
+            entry->prev->next = entry;
+            entry->next->prev = entry;
+        }
+        else {
+            m_small_lists_used[ndx / 64] |= uint64_t(1) << (ndx % 64);
+            entry->next = entry->prev = entry;
+        }
+        return;
+    }
     FreeBlock* header;
     auto it = m_block_map.find(size);
     if (it != m_block_map.end()) {
@@ -395,6 +472,8 @@ SlabAlloc::FreeBlock* SlabAlloc::slab_to_entry(const Slab& slab, ref_type ref_st
 void SlabAlloc::clear_freelists()
 {
     m_block_map.clear();
+    std::fill(std::begin(m_small_lists), std::end(m_small_lists), nullptr);
+    std::fill(std::begin(m_small_lists_used), std::end(m_small_lists_used), 0);
 }
 
 void SlabAlloc::rebuild_freelists_from_slab()
@@ -481,6 +560,8 @@ SlabAlloc::FreeBlock* SlabAlloc::grow_slab(int size)
     // Create new slab and add to list of slabs
     m_slabs.emplace_back(ref_end, new_size); // Throws
     const Slab& slab = m_slabs.back();
+    if (m_cfg.huge_pages)
+        util::madvise_huge_pages(slab.addr, slab.size);
     extend_fast_mapping_with_slab(slab.addr);
 
     // build a single block from that entry
@@ -645,7 +726,15 @@ int SlabAlloc::get_committed_file_format_version() const noexcept
     }
     const Header& header = *reinterpret_cast<const Header*>(m_data);
     int slot_selector = ((header.m_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
-    int file_format_version = int(header.m_file_format[slot_selector]);
+    return get_file_format_version(header, slot_selector);
+}
+
+
+int SlabAlloc::get_file_format_version(const Header& header, int slot) noexcept
+{
+    int file_format_version = int(header.m_file_format[slot]);
+    if (file_format_version == file_format_LogPending)
+        file_format_version = int(header.m_reserved);
     return file_format_version;
 }
 
@@ -803,6 +892,10 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     // to open it are required to also use read-only mode, no other process or thread
     // will need to change it either.
     const Header& header = *reinterpret_cast<const Header*>(m_data);
+    if (REALM_UNLIKELY(!cfg.is_shared && (header.m_flags & flags_WriteAheadLog) != 0))
+        throw InvalidDatabase("Realm file has commits in a write-ahead log, which must be applied by opening it "
+                              "with a DB first",
+                              path);
     if (cfg.session_initiator && is_file_on_streaming_form(header) && !cfg.read_only) {
         const StreamingFooter& footer = *(reinterpret_cast<const StreamingFooter*>(m_data + size) - 1);
         // Don't compare file format version fields as they are allowed to differ.
@@ -902,6 +995,8 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     fcg.release(); // Do not close
 #if REALM_ENABLE_ENCRYPTION
     m_realm_file_info = util::get_file_info_for_file(m_file);
+    if (m_realm_file_info)
+        util::set_decrypted_page_budget(*m_realm_file_info, cfg.decrypted_page_budget);
 #endif
     return top_ref;
 }
@@ -910,7 +1005,7 @@ void SlabAlloc::setup_compatibility_mapping(size_t file_size)
 {
     m_sections_in_compatibility_mapping = int(get_section_index(file_size));
     REALM_ASSERT(m_sections_in_compatibility_mapping);
-    m_compatibility_mapping = util::File::Map<char>(get_file(), util::File::access_ReadOnly, file_size);
+    m_compatibility_mapping = map_file(0, file_size);
     // fake that we've only mapped the number of full sections in order
     // to allow additional mappings to start aligned to a section boundary,
     // even though the compatibility mapping may extend further.
@@ -1141,11 +1236,34 @@ inline bool randomly_false_in_debug(bool x)
     live transaction can refer to it any more.
 
  */
+util::File::Map<char> SlabAlloc::map_file(size_t offset, size_t size)
+{
+    util::File::Map<char> map(m_file, offset, File::access_ReadOnly, size, m_cfg.map_flags); // Throws
+    if (m_cfg.random_access)
+        File::advise(map.get_addr(), map.get_size(), File::advice_Random);
+    return map;
+}
+
+void SlabAlloc::advise_access(util::File::Advice advice) noexcept
+{
+    if (advice == File::advice_Normal && m_cfg.random_access)
+        advice = File::advice_Random;
+    std::lock_guard<std::mutex> lock(m_mapping_mutex);
+    if (m_compatibility_mapping.is_attached())
+        File::advise(m_compatibility_mapping.get_addr(), m_compatibility_mapping.get_size(), advice);
+    for (auto& map : m_mappings) {
+        if (map.is_attached())
+            File::advise(map.get_addr(), map.get_size(), advice);
+    }
+}
+
 void SlabAlloc::update_reader_view(size_t file_size)
 {
     std::lock_guard<std::mutex> lock(m_mapping_mutex);
     size_t old_baseline = m_baseline.load(std::memory_order_relaxed);
     if (file_size <= old_baseline) {
+        if (file_size < old_baseline)
+            shrink_reader_view(file_size); // Throws
         return;
     }
     REALM_ASSERT_EX(file_size % 8 == 0, file_size, get_file_path_for_assertions()); // 8-byte alignment required
@@ -1170,7 +1288,7 @@ void SlabAlloc::update_reader_view(size_t file_size)
             // save the old mapping/keep it open
             m_old_mappings.emplace_back(m_youngest_live_version, std::move(m_mappings[mapping_index]));
             m_mappings[mapping_index] =
-                util::File::Map<char>(m_file, section_start_offset, File::access_ReadOnly, section_size);
+                map_file(section_start_offset, section_size);
             m_mapping_version++;
         }
         else { // extension stretches over multiple sections:
@@ -1187,7 +1305,7 @@ void SlabAlloc::update_reader_view(size_t file_size)
                 // save the old mapping/keep it open
                 m_old_mappings.emplace_back(m_youngest_live_version, std::move(m_mappings[mapping_index]));
                 m_mappings[mapping_index] =
-                    util::File::Map<char>(m_file, section_start_offset, File::access_ReadOnly, section_size);
+                    map_file(section_start_offset, section_size);
                 m_mapping_version++;
             }
 
@@ -1212,7 +1330,7 @@ void SlabAlloc::update_reader_view(size_t file_size)
                 size_t section_size =
                     get_section_base(1 + k + m_sections_in_compatibility_mapping) - section_start_offset;
                 m_mappings[k] =
-                    util::File::Map<char>(m_file, section_start_offset, File::access_ReadOnly, section_size);
+                    map_file(section_start_offset, section_size);
             }
 
             // 3. add a final partial mapping if needed
@@ -1222,7 +1340,7 @@ void SlabAlloc::update_reader_view(size_t file_size)
                     get_section_base(num_full_mappings + m_sections_in_compatibility_mapping);
                 size_t section_size = file_size - section_start_offset;
                 util::File::Map<char> mapping;
-                mapping = util::File::Map<char>(m_file, section_start_offset, File::access_ReadOnly, section_size);
+                mapping = map_file(section_start_offset, section_size);
                 m_mappings[num_full_mappings] = std::move(mapping);
             }
         }
@@ -1256,6 +1374,64 @@ void SlabAlloc::update_reader_view(size_t file_size)
     rebuild_translations(requires_new_translation, old_num_sections);
 }
 
+void SlabAlloc::shrink_reader_view(size_t file_size)
+{
+    // Older versions have a smaller size too, but unless a commit has cut off the end of the file since the
+    // baseline was last set, the file still has its full size. What was cut off was free in every version that
+    // can still be read, so the new size of the file, not that of the version, is what is still in use.
+    // The compatibility mapping of files from before file format 10 is never rebuilt
+    if (m_attach_mode != attach_SharedFile || m_sections_in_compatibility_mapping)
+        return;
+    size_t old_baseline = m_baseline.load(std::memory_order_relaxed);
+    size_t new_size = to_size_t(m_file.get_size()) & ~size_t(7); // Throws
+    if (new_size >= old_baseline)
+        return;
+    new_size = std::max(new_size, file_size);
+    REALM_ASSERT_DEBUG(is_free_space_clean());
+
+    auto old_slab_base = align_size_to_section_boundary(old_baseline);
+    size_t old_num_mappings = get_section_index(old_slab_base);
+    REALM_ASSERT(m_mappings.size() == old_num_mappings);
+    auto new_slab_base = align_size_to_section_boundary(new_size);
+    size_t num_mappings = get_section_index(new_slab_base);
+    REALM_ASSERT(num_mappings > 0 && num_mappings <= old_num_mappings);
+
+    // Set up everything that may fail before changing any state
+    size_t last_start = get_section_base(num_mappings - 1);
+    util::File::Map<char> last_mapping;
+    bool remap_last = m_mappings[num_mappings - 1].get_size() != new_size - last_start;
+    if (remap_last)
+        last_mapping = map_file(last_start, new_size - last_start); // Throws
+    std::vector<util::File::Map<char>> next_mapping(num_mappings);                          // Throws
+    m_old_mappings.reserve(m_old_mappings.size() + old_num_mappings - num_mappings + 1); // Throws
+
+    // Other threads may still translate refs through the retired mappings, so they are kept open until the
+    // versions they belong to are released, like mappings that are replaced when the file grows
+    for (size_t k = 0; k < old_num_mappings; ++k) {
+        if (k < num_mappings)
+            next_mapping[k] = std::move(m_mappings[k]);
+        else
+            m_old_mappings.emplace_back(m_youngest_live_version, std::move(m_mappings[k]));
+    }
+    if (remap_last) {
+        m_old_mappings.emplace_back(m_youngest_live_version, std::move(next_mapping[num_mappings - 1]));
+        next_mapping[num_mappings - 1] = std::move(last_mapping);
+    }
+    m_mappings = std::move(next_mapping);
+    m_mapping_version++;
+    m_baseline.store(new_size, std::memory_order_relaxed);
+
+    // Rebase slabs as m_baseline is now smaller than old_slab_base
+    size_t ref_displacement = old_slab_base - new_slab_base;
+    if (ref_displacement > 0) {
+        for (auto& e : m_slabs) {
+            e.ref_end -= ref_displacement;
+        }
+    }
+    rebuild_freelists_from_slab();
+    rebuild_translations(true, old_num_mappings);
+}
+
 size_t SlabAlloc::get_allocated_size() const noexcept
 {
     size_t sz = 0;
@@ -1379,9 +1555,12 @@ size_t SlabAlloc::find_section_in_range(size_t start_pos, size_t free_chunk_size
 }
 
 
-void SlabAlloc::resize_file(size_t new_file_size)
+bool SlabAlloc::resize_file(size_t new_file_size)
 {
     REALM_ASSERT_EX(new_file_size == round_up_to_page_size(new_file_size), get_file_path_for_assertions());
+    // The file may have been extended ahead of time, see DBOptions::file_growth_ahead
+    if (new_file_size <= static_cast<size_t>(m_file.get_size()))
+        return false;
     m_file.prealloc(new_file_size); // Throws
     // resizing is done based on the logical file size. It is ok for the file
     // to actually be bigger, but never smaller.
@@ -1390,6 +1569,7 @@ void SlabAlloc::resize_file(size_t new_file_size)
     bool disable_sync = get_disable_sync_to_disk() || m_cfg.disable_sync;
     if (!disable_sync)
         m_file.sync(); // Throws
+    return true;
 }
 
 #ifdef REALM_DEBUG
@@ -105,6 +105,23 @@ public:
     /// Always initialize the file as if it was a newly
     /// created file and ignore any pre-existing contents. Requires that
     /// Config::session_initiator be true as well.
+    ///
+    /// \var Config::map_flags
+    /// Flags for the mappings of the file, see util::File::map_Populate and
+    /// util::File::map_WillNeed.
+    ///
+    /// \var Config::random_access
+    /// Tell the system that the mappings of the file are accessed at random,
+    /// so that it only reads the pages which are accessed.
+    ///
+    /// \var Config::huge_pages
+    /// Ask for the memory holding the arrays modified by write transactions
+    /// to be backed by transparent huge pages. Only the 2 MB aligned parts of
+    /// each slab are, so small slabs are not.
+    ///
+    /// \var Config::decrypted_page_budget
+    /// The most memory, in bytes, the decrypted pages of an encrypted file
+    /// are kept to, see util::set_decrypted_page_budget(). 0 for no limit.
     struct Config {
         bool is_shared = false;
         bool read_only = false;
@@ -114,6 +131,10 @@ public:
         bool clear_file = false;
         bool disable_sync = false;
         const char* encryption_key = nullptr;
+        int map_flags = 0;
+        bool random_access = false;
+        bool huge_pages = false;
+        size_t decrypted_page_budget = 0;
     };
 
     struct Retry {
@@ -223,11 +244,13 @@ public:
     /// access. In non-transactional mode it is the responsibility of the user
     /// to ensure non-concurrent file mutation.
     ///
-    /// This function will call File::sync().
+    /// This function will call File::sync() if it changes the size of the
+    /// file. Returns false, and does nothing, if the file is already at least
+    /// as big as \a new_file_size.
     ///
     /// It is an error to call this function on an allocator that is not
     /// attached to a file. Doing so will result in undefined behavior.
-    void resize_file(size_t new_file_size);
+    bool resize_file(size_t new_file_size);
 
 #ifdef REALM_DEBUG
     /// Deprecated method, only called from a unit test
@@ -299,9 +322,20 @@ public:
     /// The version parameter is subtly different from the mapping_version obtained
     /// by get_mapping_version() below. The mapping version changes whenever a
     /// ref->ptr translation changes, and is used by Group to enforce re-translation.
+    ///
+    /// A file_size smaller than the current baseline is normally ignored, as it
+    /// belongs to an older version. If a commit has cut off the end of the file
+    /// since (see DBOptions::incremental_compaction_budget), the mappings of the
+    /// part that was cut off are retired and the baseline is lowered to the new
+    /// size of the file.
     void update_reader_view(size_t file_size);
     void purge_old_mappings(uint64_t oldest_live_version, uint64_t youngest_live_version);
 
+    /// Tell the system how the mapped parts of the file are about to be
+    /// accessed, see util::File::advise(). Passing util::File::advice_Normal
+    /// restores the access pattern given by Config::random_access.
+    void advise_access(util::File::Advice) noexcept;
+
     /// Get an ID for the current mapping version. This ID changes whenever any part
     /// of an existing mapping is changed. Such a change requires all refs to be
     /// retranslated to new pointers. The allocator tries to avoid this, and we
@@ -334,6 +368,13 @@ public:
     void note_reader_start(const void* reader_id);
     void note_reader_end(const void* reader_id) noexcept;
 
+    /// The encryption layer's information about the attached file, or null
+    /// if it is not encrypted.
+    util::SharedFileInfo* get_encrypted_file_info() const noexcept
+    {
+        return m_realm_file_info;
+    }
+
     void verify() const override;
 #ifdef REALM_DEBUG
     void enable_debug(bool enable)
@@ -433,11 +474,21 @@ private:
     using FreeListMap = std::map<int, FreeBlock*>; // log(N) addressing for larger blocks
     FreeListMap m_block_map;
 
+    // Free blocks smaller than small_block_limit, which is most of the arrays
+    // copied on write, are kept in freelists indexed directly by size / 8
+    // instead of in m_block_map. A bit is set in m_small_lists_used for each
+    // list which is not empty, so that the smallest list holding blocks of
+    // at least a given size is found by scanning a couple of words.
+    constexpr static int small_block_limit = 1024;
+    constexpr static size_t num_small_lists = small_block_limit / 8;
+    FreeBlock* m_small_lists[num_small_lists] = {};
+    uint64_t m_small_lists_used[num_small_lists / 64] = {};
+
     // abstract notion of a freelist - used to hide whether a freelist
     // is residing in the small blocks or the large blocks structures.
     struct FreeList {
-        int size = 0; // size of every element in the list, 0 if not found
-        FreeListMap::iterator it;
+        int size = 0;             // size of every element in the list, 0 if not found
+        FreeListMap::iterator it; // only used if size >= small_block_limit
         bool found_something()
         {
             return size != 0;
@@ -493,6 +544,9 @@ private:
     // Searching/manipulating freelists
     FreeList find(int size);
     FreeList find_larger(FreeList hint, int size);
+    // size of the smallest blocks in a small list holding blocks of at least
+    // 'size', or 0 if none
+    int find_small(int size) const noexcept;
     FreeBlock* pop_freelist_entry(FreeList list);
     void push_freelist_entry(FreeBlock* entry);
     void remove_freelist_entry(FreeBlock* element);
@@ -518,8 +572,16 @@ private:
     // Values of each used bit in m_flags
     enum {
         flags_SelectBit = 1,
+        // Set while commits newer than the version the header points to are only in the write-ahead log next to
+        // the file (see DBOptions::enable_write_ahead_log), which only DB applies
+        flags_WriteAheadLog = 2,
     };
 
+    // Stored in the selected file format slot while flags_WriteAheadLog is set, with the actual file format version
+    // moved to m_reserved. No version of the core supports it, so cores which do not know the flag refuse to open
+    // the file instead of reading a version that lacks the logged commits.
+    static constexpr uint8_t file_format_LogPending = 0xFF;
+
     // 24 bytes
     struct Header {
         uint64_t m_top_ref[2]; // 2 * 8 bytes
@@ -616,6 +678,10 @@ private:
     void extend_fast_mapping_with_slab(char* address);
     // Prepare the initial mapping for a file which requires use of the compatibility mapping
     void setup_compatibility_mapping(size_t file_size);
+    // Lower the baseline to a file that has been shrunk. Must be called with m_mapping_mutex locked.
+    void shrink_reader_view(size_t file_size);
+    // Map a part of the file as given by m_cfg
+    util::File::Map<char> map_file(size_t offset, size_t size);
 
     const char* m_data = nullptr;
     size_t m_initial_section_size = 0;
@@ -659,6 +725,9 @@ private:
     void throw_header_exception(std::string msg, const Header& header, const std::string& path);
 
     static bool is_file_on_streaming_form(const Header& header);
+    /// The file format version held by the given slot of the header, also while
+    /// it is replaced by file_format_LogPending
+    static int get_file_format_version(const Header& header, int slot) noexcept;
     /// Read the top_ref from the given buffer and set m_file_on_streaming_form
     /// if the buffer contains a file in streaming form
     static ref_type get_top_ref(const char* data, size_t len);
@@ -42,6 +42,7 @@ Searching: The main finding function is:
 
 #include <cmath>
 #include <cstdlib> // size_t
+#include <cstring> // memcpy
 #include <algorithm>
 #include <utility>
 #include <vector>
@@ -58,6 +59,7 @@ Searching: The main finding function is:
 #include <realm/column_fwd.hpp>
 #include <realm/array_direct.hpp>
 #include <realm/array_unsigned.hpp>
+#include <realm/impl/array_writer.hpp>
 
 /*
     MMX: mmintrin.h
@@ -413,6 +415,11 @@ public:
 
     bool minimum(int64_t& result, size_t start = 0, size_t end = size_t(-1), size_t* return_ndx = nullptr) const;
 
+    /// The range of values that can be stored with the current bit width. Every
+    /// element of the array is guaranteed to lie within these bounds.
+    int64_t get_lower_bound() const noexcept;
+    int64_t get_upper_bound() const noexcept;
+
     /// This information is guaranteed to be cached in the array accessor.
     bool is_inner_bptree_node() const noexcept;
 
@@ -600,6 +607,13 @@ public:
 
 #endif
 
+// AVX2 find for the four functions Equal/NotEqual/Less/Greater
+#ifdef REALM_COMPILER_AVX
+    template <class cond, Action action, size_t width, class Callback>
+    bool find_avx2(int64_t value, const char* data, size_t items, QueryState<int64_t>* state, size_t baseindex,
+                   Callback callback) const;
+#endif
+
     template <size_t width>
     inline bool test_zero(uint64_t value) const; // Tests value for 0-elements
 
@@ -1174,6 +1188,16 @@ inline void Array::set_has_refs(bool value) noexcept
     }
 }
 
+inline int64_t Array::get_lower_bound() const noexcept
+{
+    return m_lbound;
+}
+
+inline int64_t Array::get_upper_bound() const noexcept
+{
+    return m_ubound;
+}
+
 inline bool Array::get_context_flag() const noexcept
 {
     return m_context_flag;
@@ -1205,7 +1229,7 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 {
     REALM_ASSERT(is_attached());
 
-    if (only_if_modified && m_alloc.is_read_only(m_ref))
+    if (only_if_modified && m_alloc.is_read_only(m_ref) && !out.must_rewrite(m_ref))
         return m_ref;
 
     if (!deep || !m_has_refs)
@@ -1216,7 +1240,7 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 
 inline ref_type Array::write(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out, bool only_if_modified)
 {
-    if (only_if_modified && alloc.is_read_only(ref))
+    if (only_if_modified && alloc.is_read_only(ref) && !out.must_rewrite(ref))
         return ref;
 
     Array array(alloc);
@@ -1704,6 +1728,29 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
     // finder cannot handle this bitwidth
     REALM_ASSERT_3(m_width, !=, 0);
 
+#if defined(REALM_COMPILER_AVX)
+    // Prefer AVX2 if the payload spans at least two AVX2 chunks (2 x 256 bits), so that at least one aligned chunk
+    // is guaranteed. Unlike SSE, this also covers Less-than comparison for 64-bit values.
+    if (m_width >= 8 && (end - start2) * bitwidth / 8 >= 2 * sizeof(Avx2Chunk) && sseavx<2>()) {
+        // Search the area before the first 32-byte boundary with compare()
+        const char* const a = static_cast<char*>(round_up(m_data + start2 * bitwidth / 8, sizeof(Avx2Chunk)));
+        const char* const b = static_cast<char*>(round_down(m_data + end * bitwidth / 8, sizeof(Avx2Chunk)));
+
+        if (!compare<cond, action, bitwidth, Callback>(value, start2, (a - m_data) * 8 / no0(bitwidth), baseindex,
+                                                       state, callback))
+            return false;
+
+        // Search aligned area with AVX2
+        if (!find_avx2<cond, action, bitwidth, Callback>(value, a, (b - a) / sizeof(Avx2Chunk), state,
+                                                         baseindex + (a - m_data) * 8 / no0(bitwidth), callback))
+            return false;
+
+        // Search remainder with compare()
+        return compare<cond, action, bitwidth, Callback>(value, (b - m_data) * 8 / no0(bitwidth), end, baseindex,
+                                                         state, callback);
+    }
+#endif
+
 #if defined(REALM_COMPILER_SSE)
     // Only use SSE if payload is at least one SSE chunk (128 bits) in size. Also note taht SSE doesn't support
     // Less-than comparison for 64-bit values.
@@ -2232,6 +2279,56 @@ REALM_FORCEINLINE bool Array::find_sse_intern(__m128i* action_data, __m128i* dat
 }
 #endif // REALM_COMPILER_SSE
 
+#ifdef REALM_COMPILER_AVX
+// 'items' is the number of 32-byte AVX2 chunks starting at 'data', which must lie on an element boundary.
+template <class cond, Action action, size_t width, class Callback>
+bool Array::find_avx2(int64_t value, const char* data, size_t items, QueryState<int64_t>* state, size_t baseindex,
+                      Callback callback) const
+{
+    // Broadcast the search value into every element of a chunk. The leaf is little endian, so the lowest width / 8
+    // bytes of 'value' have the same layout as an element of the leaf.
+    Avx2Chunk search;
+    const size_t element_bytes = no0(width / 8);
+    for (size_t i = 0; i < sizeof(Avx2Chunk); i += element_bytes)
+        memcpy(search.bytes + i, &value, element_bytes);
+
+    for (size_t i = 0; i < items; ++i) {
+        const char* chunk = data + i * sizeof(Avx2Chunk);
+        uint64_t resmask;
+
+        if (std::is_same<cond, Equal>::value || std::is_same<cond, NotEqual>::value)
+            resmask = avx2_cmpeq_mask<width>(chunk, &search);
+        else if (std::is_same<cond, Greater>::value)
+            resmask = avx2_cmpgt_mask<width>(chunk, &search);
+        else
+            resmask = avx2_cmpgt_mask<width>(&search, chunk); // Less
+
+        if (std::is_same<cond, NotEqual>::value)
+            resmask = ~resmask & 0xffffffffULL;
+
+        size_t s = i * sizeof(Avx2Chunk) * 8 / no0(width);
+
+        while (resmask != 0) {
+            // One bit per matching element, which is all the 'count' aggregate needs
+            uint64_t upper = lower_bits<width / 8>() << (no0(width / 8) - 1);
+            uint64_t pattern = resmask & upper;
+            if (find_action_pattern<action, Callback>(s + baseindex, pattern, state, callback))
+                break;
+
+            size_t idx = first_set_bit64(resmask) * 8 / no0(width);
+            s += idx;
+            if (!find_action<action, Callback>(s + baseindex, get<width>(s + (data - m_data) * 8 / no0(width)),
+                                               state, callback))
+                return false;
+            resmask >>= (idx + 1) * no0(width) / 8;
+            ++s;
+        }
+    }
+
+    return true;
+}
+#endif // REALM_COMPILER_AVX
+
 template <class cond, Action action, class Callback>
 bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t baseindex,
                           QueryState<int64_t>* state, Callback callback) const
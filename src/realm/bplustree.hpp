@@ -184,6 +184,21 @@ public:
         return true;
     }
 
+    // Reattach the root accessor in place after a commit, where the root may
+    // have moved but is still of the same kind (leaf or inner node) as the
+    // one this accessor was last used with. Like Array::update_from_parent(),
+    // returns false if the tree is known to be unchanged.
+    bool update_from_parent(size_t old_baseline) noexcept
+    {
+        ref_type new_ref = m_parent->get_child_ref(m_ndx_in_parent);
+        if (new_ref == m_root->get_ref() && new_ref < old_baseline)
+            return false;
+        m_root->init_from_ref(new_ref);
+        invalidate_leaf_cache();
+        m_size = m_root->get_tree_size();
+        return true;
+    }
+
     void set_parent(ArrayParent* parent, size_t ndx_in_parent)
     {
         m_parent = parent;
@@ -428,6 +443,61 @@ public:
         }
     }
 
+    // Get the first position `n` for which `before(get(n), n)` is false, where `before` is true for all positions
+    // before it and false for all after it. Every descent of the tree caches the leaf it ends in, and the first
+    // and last entry of that leaf tell if the result is within it. So the tree is descended O(log(size / leaf
+    // size)) times, and the rest of the search is done on the cached leaf.
+    template <class Func>
+    size_t partition_point(Func before) const
+    {
+        size_t lo = 0;
+        size_t hi = m_size;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            T value = get(mid);
+            if (!(m_cached_leaf_begin <= mid && mid < m_cached_leaf_end)) {
+                // The root is a leaf, so no position takes a descent
+                if (before(value, mid))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+                continue;
+            }
+            size_t leaf_begin = m_cached_leaf_begin;
+            if (before(value, mid)) {
+                lo = mid + 1;
+                size_t last = std::min(hi, m_cached_leaf_end) - 1;
+                if (last == mid)
+                    continue;
+                if (before(m_leaf_cache.get(last - leaf_begin), last)) {
+                    lo = last + 1;
+                    continue;
+                }
+                hi = last;
+            }
+            else {
+                hi = mid;
+                size_t first = std::max(lo, leaf_begin);
+                if (first == mid)
+                    continue;
+                if (!before(m_leaf_cache.get(first - leaf_begin), first)) {
+                    hi = first;
+                    continue;
+                }
+                lo = first + 1;
+            }
+            // The result is within the cached leaf
+            while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (before(m_leaf_cache.get(mid - leaf_begin), mid))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+        }
+        return lo;
+    }
+
     std::vector<T> get_all() const
     {
         std::vector<T> all_values;
@@ -84,7 +84,10 @@ public:
         return m_sub_tree_depth;
     }
 
-    bool traverse(ClusterTree::TraverseFunction func, int64_t) const;
+    bool traverse(ClusterTree::TraverseFunction func, ClusterTree::SubtreeFilter filter, int64_t) const;
+    void get_leaf_positions(std::vector<ClusterTree::LeafPosition>& positions, ClusterTree::SubtreeFilter filter,
+                            int64_t) const;
+    bool get_zone_map(ColKey col_key, ClusterTree::ZoneMap& zone) const;
     void update(ClusterTree::UpdateFunction func, int64_t);
 
     size_t node_size() const override
@@ -687,12 +690,15 @@ size_t ClusterNodeInner::update_sub_tree_size()
     return sub_tree_size;
 }
 
-bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, int64_t key_offset) const
+bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, ClusterTree::SubtreeFilter filter,
+                                int64_t key_offset) const
 {
     auto sz = node_size();
 
     for (unsigned i = 0; i < sz; i++) {
         ref_type ref = _get_child_ref(i);
+        if (!filter(ref))
+            continue;
         char* header = m_alloc.translate(ref);
         bool child_is_leaf = !Array::get_is_inner_bptree_node_from_header(header);
         MemRef mem(header, ref, m_alloc);
@@ -707,7 +713,7 @@ bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, int64_t key_
         else {
             ClusterNodeInner node(m_alloc, m_tree_top);
             node.init(mem);
-            if (node.traverse(func, offs)) {
+            if (node.traverse(func, filter, offs)) {
                 return true;
             }
         }
@@ -715,6 +721,42 @@ bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, int64_t key_
     return false;
 }
 
+void ClusterNodeInner::get_leaf_positions(std::vector<ClusterTree::LeafPosition>& positions,
+                                          ClusterTree::SubtreeFilter filter, int64_t key_offset) const
+{
+    auto sz = node_size();
+
+    for (unsigned i = 0; i < sz; i++) {
+        ref_type ref = _get_child_ref(i);
+        if (!filter(ref))
+            continue;
+        char* header = m_alloc.translate(ref);
+        bool child_is_leaf = !Array::get_is_inner_bptree_node_from_header(header);
+        int64_t offs = (m_keys.is_attached() ? m_keys.get(i) : i << m_shift_factor) + key_offset;
+        if (child_is_leaf) {
+            positions.push_back({ref, offs});
+        }
+        else {
+            ClusterNodeInner node(m_alloc, m_tree_top);
+            node.init(MemRef(header, ref, m_alloc));
+            node.get_leaf_positions(positions, filter, offs);
+        }
+    }
+}
+
+bool ClusterNodeInner::get_zone_map(ColKey col_key, ClusterTree::ZoneMap& zone) const
+{
+    auto sz = node_size();
+
+    for (unsigned i = 0; i < sz; i++) {
+        ClusterTree::ZoneMap child_zone;
+        if (!m_tree_top.find_zone_map(_get_child_ref(i), col_key, child_zone))
+            return false;
+        zone.merge(child_zone);
+    }
+    return true;
+}
+
 void ClusterNodeInner::update(ClusterTree::UpdateFunction func, int64_t key_offset)
 {
     auto sz = node_size();
@@ -1744,6 +1786,7 @@ void Cluster::remove_backlinks(ObjKey origin_key, ColKey origin_col_key, const s
 ClusterTree::ClusterTree(Table* owner, Allocator& alloc)
     : m_owner(owner)
     , m_alloc(alloc)
+    , m_zone_map_cache(new ZoneMapCache)
 {
 }
 
@@ -1805,6 +1848,7 @@ void ClusterTree::init_from_ref(ref_type ref)
     new_root->set_parent(&m_owner->m_top, Table::top_position_for_cluster_tree);
     m_root = std::move(new_root);
     m_size = m_root->get_tree_size();
+    refresh_zone_maps();
 }
 
 void ClusterTree::init_from_parent()
@@ -1818,6 +1862,8 @@ bool ClusterTree::update_from_parent(size_t old_baseline) noexcept
     bool was_updated = m_root->update_from_parent(old_baseline);
     if (was_updated) {
         m_size = m_root->get_tree_size();
+        // The tree is not frozen, so no other thread uses the zone maps. They are rebuilt as queries need them.
+        m_zone_map_cache->entries.clear();
     }
     return was_updated;
 }
@@ -1830,6 +1876,9 @@ void ClusterTree::clear(CascadeState& state)
         if (StringIndex* index = m_owner->get_search_index(col_key)) {
             index->clear();
         }
+        if (OrderedIndex* index = m_owner->get_ordered_index(col_key)) {
+            index->clear();
+        }
     }
 
     if (state.m_group) {
@@ -1871,6 +1920,7 @@ Obj ClusterTree::insert(ObjKey k, const FieldValues& values)
               [](auto& a, auto& b) { return a.col_key.get_index().val < b.col_key.get_index().val; });
 
     insert_fast(k, init_values, state);
+    Obj obj(get_table_ref(), state.mem, k, state.index);
 
     // Update index
     auto value = init_values.begin();
@@ -1923,6 +1973,9 @@ Obj ClusterTree::insert(ObjKey k, const FieldValues& values)
                     break;
             }
         }
+        if (OrderedIndex* index = table->get_ordered_index(col_key)) {
+            index->insert(k, obj.get_any(col_key));
+        }
         return false;
     };
     get_owner()->for_each_public_column(insert_in_column);
@@ -1939,7 +1992,7 @@ Obj ClusterTree::insert(ObjKey k, const FieldValues& values)
         }
     }
 
-    return Obj(get_table_ref(), state.mem, k, state.index);
+    return obj;
 }
 
 bool ClusterTree::is_valid(ObjKey k) const
@@ -1995,6 +2048,9 @@ void ClusterTree::erase(ObjKey k, CascadeState& state)
         if (StringIndex* index = m_owner->get_search_index(col_key)) {
             index->erase(k);
         }
+        if (OrderedIndex* index = m_owner->get_ordered_index(col_key)) {
+            index->erase(k, get(k).get_any(col_key));
+        }
     }
 
     size_t root_size = m_root->erase(k, state);
@@ -2037,12 +2093,208 @@ bool ClusterTree::get_leaf(ObjKey key, ClusterNode::IteratorState& state) const
 
 bool ClusterTree::traverse(TraverseFunction func) const
 {
+    auto all = [](ref_type) { return true; };
+    return traverse(func, all);
+}
+
+bool ClusterTree::traverse(TraverseFunction func, SubtreeFilter filter) const
+{
+    if (!filter(m_root->get_ref())) {
+        return false;
+    }
     if (m_root->is_leaf()) {
         return func(static_cast<Cluster*>(m_root.get()));
     }
     else {
-        return static_cast<ClusterNodeInner*>(m_root.get())->traverse(func, 0);
+        return static_cast<ClusterNodeInner*>(m_root.get())->traverse(func, filter, 0);
+    }
+}
+
+size_t ClusterTree::warm_up(ColKey col_key) const
+{
+    // Translating a ref is what reads the array into memory, and decrypts it
+    // for encrypted files
+    class Handler : public Array::MemUsageHandler {
+    public:
+        size_t size = 0;
+        void handle(ref_type, size_t, size_t used) override
+        {
+            size += used;
+        }
+    } handler;
+
+    if (!col_key) {
+        m_root->report_memory_usage(handler);
+        return handler.size;
+    }
+    traverse([&](const Cluster* cluster) {
+        ref_type ref = cluster->get_as_ref(col_key.get_index().val + Cluster::s_first_col_index);
+        if (ref) {
+            Array leaf(m_alloc);
+            leaf.init_from_ref(ref);
+            leaf.report_memory_usage(handler);
+        }
+        return false;
+    });
+    return handler.size;
+}
+
+void ClusterTree::get_leaf_positions(std::vector<LeafPosition>& positions) const
+{
+    auto all = [](ref_type) { return true; };
+    get_leaf_positions(positions, all);
+}
+
+void ClusterTree::get_leaf_positions(std::vector<LeafPosition>& positions, SubtreeFilter filter) const
+{
+    if (!filter(m_root->get_ref())) {
+        return;
+    }
+    if (m_root->is_leaf()) {
+        positions.push_back({m_root->get_ref(), 0});
+    }
+    else {
+        static_cast<ClusterNodeInner*>(m_root.get())->get_leaf_positions(positions, filter, 0);
+    }
+}
+
+namespace {
+
+template <class LeafType>
+void add_to_zone_map(const LeafType& leaf, ClusterTree::ZoneMap& zone)
+{
+    size_t sz = leaf.size();
+    for (size_t i = 0; i < sz; i++) {
+        auto value = leaf.get(i);
+        if (value)
+            zone.add(*value);
+        else
+            zone.null_count++;
+    }
+}
+
+template <>
+void add_to_zone_map(const ArrayInteger& leaf, ClusterTree::ZoneMap& zone)
+{
+    // An empty leaf keeps the empty zone, which no condition can match
+    if (leaf.size() == 0)
+        return;
+    int64_t min;
+    int64_t max;
+    if (leaf.minimum(min) && leaf.maximum(max)) {
+        zone.add(min);
+        zone.add(max);
+    }
+}
+
+template <>
+void add_to_zone_map(const ArrayTimestamp& leaf, ClusterTree::ZoneMap& zone)
+{
+    size_t sz = leaf.size();
+    for (size_t i = 0; i < sz; i++) {
+        Timestamp value = leaf.get(i);
+        if (value.is_null())
+            zone.null_count++;
+        else
+            zone.add(value.get_seconds());
+    }
+}
+
+} // anonymous namespace
+
+bool ClusterTree::get_zone_map(ref_type ref, ColKey col_key, ZoneMap& zone) const
+{
+    // Nodes in the writable part of the file may change
+    if (!m_alloc.is_read_only(ref) || col_key.get_attrs().test(col_attr_List))
+        return false;
+
+    if (find_zone_map(ref, col_key, zone))
+        return true;
+
+    char* header = m_alloc.translate(ref);
+    MemRef mem(header, ref, m_alloc);
+    ZoneMap new_zone;
+    if (Array::get_is_inner_bptree_node_from_header(header)) {
+        // Not reading the subtree here keeps the cost of a query that stops early proportional to the part of
+        // the table it visits
+        ClusterNodeInner node(m_alloc, *this);
+        node.init(mem);
+        if (!node.get_zone_map(col_key, new_zone))
+            return false;
+    }
+    else {
+        Cluster leaf(0, m_alloc, *this);
+        leaf.init(mem);
+        bool nullable = col_key.get_attrs().test(col_attr_Nullable);
+        switch (col_key.get_type()) {
+            case col_type_Int:
+                if (nullable) {
+                    ArrayIntNull arr(m_alloc);
+                    leaf.init_leaf(col_key, &arr);
+                    add_to_zone_map(arr, new_zone);
+                }
+                else {
+                    ArrayInteger arr(m_alloc);
+                    leaf.init_leaf(col_key, &arr);
+                    add_to_zone_map(arr, new_zone);
+                }
+                break;
+            case col_type_Timestamp: {
+                ArrayTimestamp arr(m_alloc);
+                leaf.init_leaf(col_key, &arr);
+                add_to_zone_map(arr, new_zone);
+                break;
+            }
+            default:
+                return false;
+        }
     }
+
+    std::lock_guard<std::mutex> lock(m_zone_map_cache->mutex);
+    m_zone_map_cache->entries[std::make_pair(ref, col_key.value)] = {new_zone, m_zone_map_cache->epoch};
+    zone = new_zone;
+    return true;
+}
+
+bool ClusterTree::find_zone_map(ref_type ref, ColKey col_key, ZoneMap& zone) const
+{
+    std::lock_guard<std::mutex> lock(m_zone_map_cache->mutex);
+    auto it = m_zone_map_cache->entries.find(std::make_pair(ref, col_key.value));
+    if (it == m_zone_map_cache->entries.end())
+        return false;
+    it->second.epoch = m_zone_map_cache->epoch;
+    zone = it->second.zone;
+    return true;
+}
+
+void ClusterTree::refresh_zone_maps()
+{
+    std::lock_guard<std::mutex> lock(m_zone_map_cache->mutex);
+    auto& entries = m_zone_map_cache->entries;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.epoch == m_zone_map_cache->epoch)
+            ++it;
+        else
+            it = entries.erase(it);
+    }
+    m_zone_map_cache->epoch++;
+}
+
+ClusterTree::LeafPosition ClusterTree::get_leaf_position(size_t ndx) const
+{
+    REALM_ASSERT(ndx < m_size);
+    ClusterNode::State state;
+    ObjKey k = m_root->get(ndx, state);
+    Cluster leaf(0, m_alloc, *this);
+    leaf.init(state.mem);
+    return {state.mem.get_ref(), k.value - leaf.get_key_value(state.index)};
+}
+
+bool ClusterTree::visit_leaf(const LeafPosition& position, TraverseFunction func) const
+{
+    Cluster leaf(position.key_offset, m_alloc, *this);
+    leaf.init(MemRef(m_alloc.translate(position.ref), position.ref, m_alloc));
+    return func(&leaf);
 }
 
 void ClusterTree::update(UpdateFunction func)
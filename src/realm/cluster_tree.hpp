@@ -22,14 +22,47 @@
 #include <realm/obj.hpp>
 #include <realm/util/function_ref.hpp>
 
+#include <limits>
+#include <map>
+#include <mutex>
+
 namespace realm {
 
 class ClusterTree {
 public:
     class ConstIterator;
     class Iterator;
+    struct LeafPosition {
+        ref_type ref;
+        int64_t key_offset;
+    };
+    // Summary of the values of an integer column, or of the seconds of a timestamp column, in a subtree
+    struct ZoneMap {
+        int64_t min = std::numeric_limits<int64_t>::max();
+        int64_t max = std::numeric_limits<int64_t>::min();
+        size_t null_count = 0;
+
+        void add(int64_t value)
+        {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        // True if the zone summarises no rows at all
+        bool empty() const noexcept
+        {
+            return min > max && null_count == 0;
+        }
+        void merge(const ZoneMap& other)
+        {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            null_count += other.null_count;
+        }
+    };
     using TraverseFunction = util::FunctionRef<bool(const Cluster*)>;
     using UpdateFunction = util::FunctionRef<void(Cluster*)>;
+    // Return false to skip the subtree at the given ref
+    using SubtreeFilter = util::FunctionRef<bool(ref_type)>;
 
     ClusterTree(Table* owner, Allocator& alloc);
     static MemRef create_empty_cluster(Allocator& alloc);
@@ -138,6 +171,30 @@ public:
     // Visit all leaves and call the supplied function. Stop when function returns true.
     // Not allowed to modify the tree
     bool traverse(TraverseFunction func) const;
+    // Visit the leaves of the subtrees accepted by filter. The filter is called for the root and for each
+    // child node before it is visited.
+    bool traverse(TraverseFunction func, SubtreeFilter filter) const;
+    // Collect the positions of all leaves in key order. As long as the tree is not modified, the leaves can
+    // then be visited individually, in any order and from any thread.
+    void get_leaf_positions(std::vector<LeafPosition>& positions) const;
+    void get_leaf_positions(std::vector<LeafPosition>& positions, SubtreeFilter filter) const;
+    // Get the position of the leaf holding the object at the given index, descending the tree only along the
+    // path to it
+    LeafPosition get_leaf_position(size_t ndx) const;
+    // Get the zone map of an integer or timestamp column for the subtree at ref. Zone maps are only available
+    // for subtrees in the read-only part of the file. The zone map of a leaf is computed on first request. The
+    // one of an inner node is made from the zone maps of its children once they all exist, so it is only
+    // available after queries have reached each of them. Zone maps are kept as long as the subtree is part of
+    // the tree. Returns false if not available.
+    bool get_zone_map(ref_type ref, ColKey col_key, ZoneMap& zone) const;
+    // Drop all zone maps. Must be called when the tree is detached, as the accessor may be reused for a tree of
+    // another file, where the same refs hold other nodes.
+    void clear_zone_maps() noexcept
+    {
+        m_zone_map_cache->entries.clear();
+    }
+    // Call the supplied function on the leaf found at the given position
+    bool visit_leaf(const LeafPosition& position, TraverseFunction func) const;
     // Visit all leaves and call the supplied function. The function can modify the leaf.
     void update(UpdateFunction func);
 
@@ -146,6 +203,8 @@ public:
     {
         m_root->dump_objects(0, "");
     }
+    // Read all arrays of the column, or of the whole tree if col_key is null, and return their total size
+    size_t warm_up(ColKey col_key) const;
     void verify() const;
 
 private:
@@ -158,6 +217,24 @@ private:
     std::unique_ptr<ClusterNode> m_root;
     size_t m_size = 0;
 
+    // Zone maps are keyed by the ref of the node they summarise. The space of a read-only node is not reused
+    // before the version we are refreshing from is released, so entries used since the last refresh are still
+    // valid after the next one. All others are discarded. The mutex is only needed by frozen trees, which can
+    // be queried from several threads but are never refreshed.
+    struct ZoneMapCache {
+        struct Entry {
+            ZoneMap zone;
+            uint64_t epoch;
+        };
+        std::mutex mutex;
+        std::map<std::pair<ref_type, int64_t>, Entry> entries;
+        uint64_t epoch = 0;
+    };
+    std::unique_ptr<ZoneMapCache> m_zone_map_cache;
+
+    bool find_zone_map(ref_type ref, ColKey col_key, ZoneMap& zone) const;
+    void refresh_zone_maps();
+
     void replace_root(std::unique_ptr<ClusterNode> leaf);
 
     std::unique_ptr<ClusterNode> create_root_from_mem(Allocator& alloc, MemRef mem);
@@ -19,11 +19,13 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <exception>
 #include <fcntl.h>
 #include <realm/db.hpp>
 #include <iostream>
 #include <mutex>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 #include <random>
 
@@ -38,6 +40,7 @@
 #include <realm/replication.hpp>
 #include <realm/table_view.hpp>
 #include <realm/impl/simulated_failure.hpp>
+#include <realm/impl/write_ahead_log.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 
 #ifndef _WIN32
@@ -78,7 +81,14 @@ const uint16_t relaxed_sync_threshold = 50;
 //  9      Fair write transactions requires an additional condition variable,
 //         `write_fairness`
 // 10      Introducing SharedInfo::history_schema_version.
-const uint_fast16_t g_shared_info_version = 10;
+// 11      Introducing SharedInfo::unsynced_commits in place of `filler_1`, set
+//         while the latest version was committed by group commit without
+//         being synced.
+// 12      Introducing SharedInfo::write_ahead_log in place of half of
+//         `filler_2`, which must match across all session participants.
+// 13      Introducing SharedInfo::shared_growmutex, held while the size of the
+//         database file is changed.
+const uint_fast16_t g_shared_info_version = 13;
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -493,20 +503,30 @@ struct alignas(8) DB::SharedInfo {
     /// Cleared by the daemon when it decides to exit.
     uint8_t daemon_ready = 0; // Offset 42
 
-    uint8_t filler_1; // Offset 43
+    /// Set (1) when the latest version was committed by group commit without
+    /// being synced to disk. The next commit which is synced must then sync
+    /// the whole file, and not only the parts of the file it wrote to.
+    /// Guarded by the write mutex.
+    uint8_t unsynced_commits = 0; // Offset 43
 
     /// Stores a history schema version (as returned by
     /// Replication::get_history_schema_version()). Must match across all
     /// session participants.
     uint16_t history_schema_version; // Offset 44
 
-    uint16_t filler_2; // Offset 46
+    /// Set (1) when the session uses a write-ahead log. Must match across all
+    /// session participants.
+    uint8_t write_ahead_log = 0; // Offset 46
+
+    uint8_t filler_2 = 0; // Offset 47
 
     InterprocessMutex::SharedPart shared_writemutex; // Offset 48
 #ifdef REALM_ASYNC_DAEMON
     InterprocessMutex::SharedPart shared_balancemutex;
 #endif
     InterprocessMutex::SharedPart shared_controlmutex;
+    // Held while the size of the database file is changed, see DB::grow_file()
+    InterprocessMutex::SharedPart shared_growmutex;
     // FIXME: windows pthread support for condvar not ready
     InterprocessCondVar::SharedPart room_to_write;
     InterprocessCondVar::SharedPart work_to_do;
@@ -548,6 +568,7 @@ DB::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht, int hsv
     , shared_balancemutex() // Throws
 #endif
     , shared_controlmutex() // Throws
+    , shared_growmutex()    // Throws
 {
     durability = static_cast<uint16_t>(dura); // durability level is fixed from creation
     REALM_ASSERT(!util::int_cast_has_overflow<decltype(history_type)>(ht + 0));
@@ -607,10 +628,13 @@ DB::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht, int hsv
             std::is_same<decltype(sync_agent_present), uint8_t>::value &&
             offsetof(SharedInfo, daemon_started) == 41 && std::is_same<decltype(daemon_started), uint8_t>::value &&
             offsetof(SharedInfo, daemon_ready) == 42 && std::is_same<decltype(daemon_ready), uint8_t>::value &&
-            offsetof(SharedInfo, filler_1) == 43 && std::is_same<decltype(filler_1), uint8_t>::value &&
+            offsetof(SharedInfo, unsynced_commits) == 43 &&
+            std::is_same<decltype(unsynced_commits), uint8_t>::value &&
             offsetof(SharedInfo, history_schema_version) == 44 &&
-            std::is_same<decltype(history_schema_version), uint16_t>::value && offsetof(SharedInfo, filler_2) == 46 &&
-            std::is_same<decltype(filler_2), uint16_t>::value && offsetof(SharedInfo, shared_writemutex) == 48 &&
+            std::is_same<decltype(history_schema_version), uint16_t>::value &&
+            offsetof(SharedInfo, write_ahead_log) == 46 &&
+            std::is_same<decltype(write_ahead_log), uint8_t>::value && offsetof(SharedInfo, filler_2) == 47 &&
+            std::is_same<decltype(filler_2), uint8_t>::value && offsetof(SharedInfo, shared_writemutex) == 48 &&
             std::is_same<decltype(shared_writemutex), InterprocessMutex::SharedPart>::value,
         "Caught layout change requiring SharedInfo file format bumping");
 #ifndef _WIN32
@@ -760,6 +784,20 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
     m_lockfile_prefix = m_coordination_dir + "/access_control";
     SlabAlloc& alloc = m_alloc;
     m_alloc.set_read_only(false);
+    m_can_defer_sync = options.durability == Durability::Full && !m_key;
+    m_group_commit = options.enable_group_commit && m_can_defer_sync;
+    bool use_wal = options.enable_write_ahead_log && m_can_defer_sync;
+    m_wal_checkpoint_size = options.write_ahead_log_checkpoint_size;
+    m_compaction_budget = options.incremental_compaction_budget;
+    m_file_growth_ahead = options.file_growth_ahead;
+    m_file_growth_factor = options.file_growth_factor;
+    if (options.prefault == DBOptions::Prefault::WillNeed)
+        m_map_flags = util::File::map_WillNeed;
+    else if (options.prefault == DBOptions::Prefault::Populate)
+        m_map_flags = util::File::map_Populate;
+    m_advise_random_access = options.advise_random_access;
+    m_use_huge_pages = options.use_huge_pages;
+    m_decrypted_page_budget = options.decrypted_page_budget;
 
 #if REALM_METRICS
     if (options.enable_metrics) {
@@ -964,6 +1002,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             m_balancemutex.set_shared_part(info->shared_balancemutex, m_lockfile_prefix, "balance");
 #endif
         m_controlmutex.set_shared_part(info->shared_controlmutex, m_lockfile_prefix, "control");
+        m_growmutex.set_shared_part(info->shared_growmutex, m_lockfile_prefix, "grow");
 
         // even though fields match wrt alignment and size, there may still be incompatibilities
         // between implementations, so lets ask one of the mutexes if it thinks it'll work.
@@ -982,19 +1021,25 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
             // we need a thread-local copy of the number of ringbuffer entries in order
             // to later detect concurrent expansion of the ringbuffer.
-            m_local_max_entry = info->readers.get_num_entries();
+            uint_fast32_t num_entries = info->readers.get_num_entries();
 
             // We need to map the info file once more for the readers part
             // since that part can be resized and as such remapped which
             // could move our mutexes (which we don't want to risk moving while
             // they are locked)
-            size_t reader_info_size = sizeof(SharedInfo) + info->readers.compute_required_space(m_local_max_entry);
+            size_t reader_info_size = sizeof(SharedInfo) + info->readers.compute_required_space(num_entries);
             m_reader_map.map(m_file, File::access_ReadWrite, reader_info_size, File::map_NoSync);
             File::UnmapGuard fug_2(m_reader_map);
+            publish_reader_info(num_entries); // Throws
 
             // proceed to initialize versioning and other metadata information related to
             // the database. Also create the database if we're beginning a new session
             bool begin_new_session = (info->num_participants == 0);
+
+            // A session which used a write-ahead log may have ended without checkpointing it
+            if (begin_new_session && !m_key && options.durability != Durability::MemOnly)
+                recover_from_log(path); // Throws
+
             SlabAlloc::Config cfg;
             cfg.session_initiator = begin_new_session;
             cfg.is_shared = true;
@@ -1012,6 +1057,10 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             cfg.clear_file = (options.durability == Durability::MemOnly && begin_new_session);
 
             cfg.encryption_key = m_key;
+            cfg.map_flags = m_map_flags;
+            cfg.random_access = m_advise_random_access;
+            cfg.huge_pages = m_use_huge_pages;
+            cfg.decrypted_page_budget = m_decrypted_page_budget;
             ref_type top_ref;
             try {
                 top_ref = alloc.attach_file(path, cfg); // Throws
@@ -1068,6 +1117,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
                 case 8:
                 case 9:
                 case 10:
+                case 11:
                     file_format_ok = true;
                     break;
             }
@@ -1142,6 +1192,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
                 }
 
                 info->file_format_version = uint_fast8_t(target_file_format_version);
+                info->write_ahead_log = uint8_t(use_wal);
 
                 // Initially there is a single version in the file
                 info->number_of_versions = 1;
@@ -1161,6 +1212,9 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
                 // use the same durability setting for the same Realm file.
                 if (Durability(info->durability) != options.durability)
                     throw LogicError(LogicError::mixed_durability);
+                // The same goes for the use of a write-ahead log
+                if (bool(info->write_ahead_log) != use_wal)
+                    throw LogicError(LogicError::mixed_durability);
 
                 // History type must be consistent across a session. An
                 // inconsistency is a logic error, as the user is required to
@@ -1202,6 +1256,11 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
                 // we shall instead simply check that there is agreement, and
                 // throw the same kind of exception, as would have been thrown
                 // with a bumped SharedInfo file format version, if there isn't.
+                // The one exception is a file format raised by a commit of the
+                // session (see low_level_commit()), which need not have reached
+                // the file header yet.
+                if (info->file_format_version == 11 && target_file_format_version == 10)
+                    current_file_format_version = target_file_format_version = 11;
                 if (info->file_format_version != target_file_format_version) {
                     std::stringstream ss;
                     ss << "File format version deosn't match: " << info->file_format_version << " "
@@ -1249,6 +1308,9 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
 // std::cerr << "daemon should be ready" << std::endl;
 #endif // REALM_ASYNC_DAEMON
 
+            if (use_wal)
+                m_wal = std::make_unique<_impl::WriteAheadLog>(path + ".wal"); // Throws
+
             // make our presence noted:
             ++info->num_participants;
 
@@ -1391,10 +1453,16 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
         // local lock blocking any transaction from starting (and stopping)
         std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
 
-        // We should be the only transaction active - otherwise back out
-        if (m_transaction_count != 0)
+        // We should be the only transaction active - otherwise back out. The read lock on the durable version is
+        // not held by a transaction.
+        if (m_transaction_count != (m_holds_durable_read_lock ? 1 : 0))
             return false;
 
+        // Versions committed without syncing must be made durable before the file is replaced, as the write-ahead
+        // log would otherwise be applied to the new file after a crash. No other writer can be active.
+        if (info->unsynced_commits)
+            sync_deferred_commits(); // Throws
+
         // group::write() will throw if the file already exists.
         // To prevent this, we have to remove the file (should it exist)
         // before calling group::write().
@@ -1408,6 +1476,11 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
         // Compact by writing a new file holding only live data, then renaming the new file
         // so it becomes the database file, replacing the old one in the process.
         try {
+            // The whole file is read in order
+            m_alloc.advise_access(File::advice_Sequential);
+            auto restore_advice = util::make_scope_exit([&]() noexcept {
+                m_alloc.advise_access(File::advice_Normal);
+            });
             File file;
             file.open(tmp_path, File::access_ReadWrite, File::create_Must, 0);
             int incr = bump_version_number ? 1 : 0;
@@ -1425,6 +1498,8 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
             }
             throw;
         }
+        // The new file may have the same version as the old one
+        m_free_space_state.reset();
         {
             SharedInfo* r_info = m_reader_map.get_addr();
             Ringbuffer::ReadCount& rc = const_cast<Ringbuffer::ReadCount&>(r_info->readers.get_last());
@@ -1435,6 +1510,8 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
         // When someone attaches to the new database file, they *must* *not* see and
         // reuse any existing memory mapping of the stale file.
         tr->close();
+        // The file must not be extended in the background while it is replaced
+        std::lock_guard<InterprocessMutex> grow_lock(m_growmutex); // Throws
         m_alloc.detach();
 
 #ifdef _WIN32
@@ -1451,6 +1528,10 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
         cfg.no_create = true;
         cfg.clear_file = false;
         cfg.encryption_key = write_key;
+        cfg.map_flags = m_map_flags;
+        cfg.random_access = m_advise_random_access;
+        cfg.huge_pages = m_use_huge_pages;
+        cfg.decrypted_page_budget = m_decrypted_page_budget;
         ref_type top_ref;
         top_ref = m_alloc.attach_file(m_db_path, cfg);
         info->number_of_versions = 1;
@@ -1476,7 +1557,13 @@ size_t DB::get_allocated_size() const
 
 DB::~DB() noexcept
 {
-    close();
+    // Open transactions keep the DB alive, so closing can only fail at the checkpoint of the write-ahead log. The
+    // log is then applied when the file is opened again.
+    try {
+        close();
+    }
+    catch (...) {
+    }
 
     if (m_replication) {
         m_replication->register_db(nullptr);
@@ -1487,12 +1574,20 @@ void DB::release_all_read_locks() noexcept
 {
     std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
     SharedInfo* r_info = m_reader_map.get_addr();
-    for (auto& read_lock: m_local_locks_held) {
-        --m_transaction_count;
-        const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
-        atomic_double_dec(r.count);
+    uint_fast32_t num_entries = m_local_max_entry;
+    for (uint_fast32_t index = 0; index < num_entries; ++index) {
+        // Read locks released concurrently find the count cleared, and leave the entry alone
+        uint32_t count = local_read_count(index).exchange(0);
+        const Ringbuffer::ReadCount& r = r_info->readers.get(index);
+        for (uint32_t i = 0; i < count; ++i) {
+            --m_transaction_count;
+            atomic_double_dec(r.count);
+        }
     }
-    m_local_locks_held.clear();
+    // Read locks whose release was under way must be released from the ringbuffer before the caller leaves the
+    // session and unmaps it. Such a release is only a few instructions away from completion.
+    while (m_reader_info_users.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::yield();
 }
 
 // Note: close() and close_internal() may be called from the DB::~DB().
@@ -1512,9 +1607,27 @@ void DB::close_internal(std::unique_lock<InterprocessMutex> lock, bool allow_ope
         std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
         if (m_write_transaction_open)
             throw LogicError(LogicError::wrong_transact_state);
-        if (!allow_open_read_transactions && m_transaction_count)
+        // The read lock on the durable version is not held by a transaction
+        int transaction_count = m_transaction_count - (m_holds_durable_read_lock ? 1 : 0);
+        if (!allow_open_read_transactions && transaction_count)
             throw LogicError(LogicError::wrong_transact_state);
     }
+    // Finishes syncing of any outstanding asynchronous commits
+    stop_sync_thread();
+    // Reported once the DB is closed
+    std::exception_ptr checkpoint_error;
+    if (m_wal) {
+        // Leave the database file up to date. If this fails, the log is applied when the file is opened again.
+        try {
+            if (m_wal->size() > 0)
+                checkpoint(); // Throws
+        }
+        catch (...) {
+            checkpoint_error = std::current_exception();
+        }
+        m_wal.reset();
+    }
+    m_free_space_state.reset();
     SharedInfo* info = m_file_map.get_addr();
     {
         bool is_sync_agent = m_replication ? m_replication->is_sync_agent() : false;
@@ -1530,6 +1643,7 @@ void DB::close_internal(std::unique_lock<InterprocessMutex> lock, bool allow_ope
             info->sync_agent_present = 0; // Set to false
         }
         release_all_read_locks();
+        m_holds_durable_read_lock = false;
         --info->num_participants;
         bool end_of_session = info->num_participants == 0;
         // std::cerr << "closing" << std::endl;
@@ -1564,11 +1678,16 @@ void DB::close_internal(std::unique_lock<InterprocessMutex> lock, bool allow_ope
         // may
         // interleave which is not permitted on Windows. It is permitted on *nix.
         m_file_map.unmap();
+        m_local_max_entry = 0;
+        m_reader_info = nullptr;
         m_reader_map.unmap();
+        m_retired_reader_maps.clear();
         m_file.unlock();
         // info->~SharedInfo(); // DO NOT Call destructor
         m_file.close();
     }
+    if (checkpoint_error)
+        std::rethrow_exception(checkpoint_error);
 }
 
 bool DB::has_changed(TransactionRef tr)
@@ -1612,26 +1731,36 @@ void Transaction::set_transact_stage(DB::TransactStage stage) noexcept
         size_t num_objects = m_total_rows;
         size_t num_available_versions = static_cast<size_t>(db->get_number_of_versions());
         size_t num_decrypted_pages = realm::util::get_num_decrypted_pages();
+        metrics::EncryptedFileStats file_stats;
+#if REALM_ENABLE_ENCRYPTION
+        if (util::SharedFileInfo* info = db->m_alloc.get_encrypted_file_info()) {
+            util::decrypted_file_stats_t stats = util::get_decrypted_file_stats(*info);
+            file_stats.page_hits = size_t(stats.hits);
+            file_stats.page_decryptions = size_t(stats.decryptions);
+            file_stats.page_evictions = size_t(stats.evictions);
+            file_stats.decrypted_size = stats.memory_size;
+        }
+#endif
 
         if (stage == DB::transact_Reading) {
             if (m_transact_stage == DB::transact_Writing) {
                 m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions,
-                                                 num_decrypted_pages);
+                                                 num_decrypted_pages, file_stats);
             }
             m_metrics->start_read_transaction();
         }
         else if (stage == DB::transact_Writing) {
             if (m_transact_stage == DB::transact_Reading) {
                 m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions,
-                                                num_decrypted_pages);
+                                                num_decrypted_pages, file_stats);
             }
             m_metrics->start_write_transaction();
         }
         else if (stage == DB::transact_Ready) {
             m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions,
-                                            num_decrypted_pages);
+                                            num_decrypted_pages, file_stats);
             m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions,
-                                             num_decrypted_pages);
+                                             num_decrypted_pages, file_stats);
         }
     }
 #endif
@@ -1830,90 +1959,82 @@ void DB::upgrade_file_format(bool allow_file_format_upgrade, int target_file_for
 
 void DB::release_read_lock(ReadLockInfo& read_lock) noexcept
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    bool found_match = false;
-    // simple linear search and move-last-over if a match is found.
-    // common case should have only a modest number of transactions in play..
-    for (size_t j = 0; j < m_local_locks_held.size(); ++j) {
-        if (m_local_locks_held[j].m_version == read_lock.m_version) {
-            m_local_locks_held[j] = m_local_locks_held.back();
-            m_local_locks_held.pop_back();
-            found_match = true;
-            break;
+    // Announce the release before taking it from the local count, so that close() either finds the count cleared
+    // here, or waits for the release to finish before it unmaps the ringbuffer (see release_all_read_locks())
+    enter_reader_info();
+    // The count is zero if someone called close() and all locks where released. The DB may not be detached yet,
+    // as close() releases the read locks before it leaves the session.
+    std::atomic<uint32_t>& local_count = local_read_count(read_lock.m_reader_idx);
+    uint32_t count = local_count.load(std::memory_order_relaxed);
+    do {
+        if (count == 0) {
+            leave_reader_info();
+            return;
         }
-    }
-    if (!found_match) {
-        REALM_ASSERT(!is_attached());
-        // it's OK, someone called close() and all locks where released
-        return;
-    }
+    } while (!local_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
     --m_transaction_count;
-    SharedInfo* r_info = m_reader_map.get_addr();
+    SharedInfo* r_info = m_reader_info.load(std::memory_order_acquire);
     const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
     atomic_double_dec(r.count); // <-- most of the exec time spent here
+    leave_reader_info();
 }
 
 
 void DB::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     REALM_ASSERT_RELEASE(is_attached());
-    if (version_id.version == std::numeric_limits<version_type>::max()) {
-        for (;;) {
-            SharedInfo* r_info = m_reader_map.get_addr();
-            read_lock.m_reader_idx = r_info->readers.last();
-            if (grow_reader_mapping(read_lock.m_reader_idx)) { // Throws
-                // remapping takes time, so retry with a fresh entry
-                continue;
-            }
-            r_info = m_reader_map.get_addr();
-            const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
-            // if the entry is stale and has been cleared by the cleanup process,
-            // we need to start all over again. This is extremely unlikely, but possible.
-            if (!atomic_double_inc_if_even(r.count)) // <-- most of the exec time spent here!
-                continue;
-            read_lock.m_version = r.version;
-            read_lock.m_top_ref = to_size_t(r.current_top);
-            read_lock.m_file_size = to_size_t(r.filesize);
-            m_local_locks_held.emplace_back(read_lock);
-            ++m_transaction_count;
-            // REALM_ASSERT(m_alloc.matches_section_boundary(read_lock.m_file_size));
-            REALM_ASSERT(read_lock.m_file_size > read_lock.m_top_ref);
-            return;
-        }
-    }
-
+    // Growing the mapping may fail, even though it is rarely needed
+    using _impl::SimulatedFailure;
+    SimulatedFailure::trigger(SimulatedFailure::shared_group__grow_reader_mapping); // Throws
+    bool latest = version_id.version == std::numeric_limits<version_type>::max();
     for (;;) {
-        SharedInfo* r_info = m_reader_map.get_addr();
-        read_lock.m_reader_idx = version_id.index;
-        if (grow_reader_mapping(read_lock.m_reader_idx)) { // Throws
-            // remapping takes time, so retry with a fresh entry
+        enter_reader_info();
+        SharedInfo* r_info = m_reader_info.load(std::memory_order_seq_cst);
+        read_lock.m_reader_idx = latest ? r_info->readers.last() : version_id.index;
+        if (read_lock.m_reader_idx >= m_local_max_entry.load(std::memory_order_acquire)) {
+            // Only growing the mapping requires the lock. Remapping takes time, so retry with a fresh entry. The
+            // mapping we used may be unmapped by the growth.
+            leave_reader_info();
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            grow_reader_mapping(read_lock.m_reader_idx); // Throws
             continue;
         }
-        r_info = m_reader_map.get_addr();
+        auto leave = util::make_scope_exit([&]() noexcept {
+            leave_reader_info();
+        });
+        r_info = m_reader_info.load(std::memory_order_acquire);
         const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
 
-        // if the entry is stale and has been cleared by the cleanup process,
-        // the requested version is no longer available
-        while (!atomic_double_inc_if_even(r.count)) { // <-- most of the exec time spent here!
-            // we failed to lock the version. This could be because the version
-            // is being cleaned up, but also because the cleanup is probing for access
-            // to it. If it's being probed, the tail ptr of the ringbuffer will point
-            // to it. If so we retry. If the tail ptr points somewhere else, the entry
-            // has been cleaned up.
-            if (&r_info->readers.get_oldest() != &r)
-                throw BadVersion();
+        if (latest) {
+            // if the entry is stale and has been cleared by the cleanup process,
+            // we need to start all over again. This is extremely unlikely, but possible.
+            if (!atomic_double_inc_if_even(r.count)) // <-- most of the exec time spent here!
+                continue;
         }
-        // we managed to lock an entry in the ringbuffer, but it may be so old that
-        // the version doesn't match the specific request. In that case we must release and fail
-        if (r.version != version_id.version) {
-            atomic_double_dec(r.count); // <-- release
-            throw BadVersion();
+        else {
+            // if the entry is stale and has been cleared by the cleanup process,
+            // the requested version is no longer available
+            while (!atomic_double_inc_if_even(r.count)) { // <-- most of the exec time spent here!
+                // we failed to lock the version. This could be because the version
+                // is being cleaned up, but also because the cleanup is probing for access
+                // to it. If it's being probed, the tail ptr of the ringbuffer will point
+                // to it. If so we retry. If the tail ptr points somewhere else, the entry
+                // has been cleaned up.
+                if (&r_info->readers.get_oldest() != &r)
+                    throw BadVersion();
+            }
+            // we managed to lock an entry in the ringbuffer, but it may be so old that
+            // the version doesn't match the specific request. In that case we must release and fail
+            if (r.version != version_id.version) {
+                atomic_double_dec(r.count); // <-- release
+                throw BadVersion();
+            }
         }
         read_lock.m_version = r.version;
         read_lock.m_top_ref = to_size_t(r.current_top);
         read_lock.m_file_size = to_size_t(r.filesize);
-        m_local_locks_held.emplace_back(read_lock);
+        local_read_count(read_lock.m_reader_idx).fetch_add(1, std::memory_order_relaxed);
         ++m_transaction_count;
         // REALM_ASSERT(m_alloc.matches_section_boundary(read_lock.m_file_size));
         REALM_ASSERT(read_lock.m_file_size > read_lock.m_top_ref);
@@ -1926,10 +2047,14 @@ bool DB::do_try_begin_write()
     // In the non-blocking case, we will only succeed if there is no contention for
     // the write mutex. For this case we are trivially fair and can ignore the
     // fairness machinery.
+    m_local_writers++;
     bool got_the_lock = m_writemutex.try_lock();
     if (got_the_lock) {
         finish_begin_write();
     }
+    else {
+        leave_local_writers();
+    }
     return got_the_lock;
 }
 
@@ -1942,7 +2067,17 @@ void DB::do_begin_write()
     // We use a ticketing scheme to ensure fairness wrt performing write transactions.
     // (But cannot do that on Windows until we have interprocess condition variables there)
     uint32_t my_ticket = info->next_ticket.fetch_add(1, std::memory_order_relaxed);
-    m_writemutex.lock(); // Throws
+    // Tell the current writer that a commit of ours will follow, see low_level_commit()
+    m_local_writers++;
+    m_local_writers_waiting++;
+    try {
+        m_writemutex.lock(); // Throws
+    }
+    catch (...) {
+        m_local_writers_waiting--;
+        leave_local_writers();
+        throw;
+    }
 
     // allow for comparison even after wrap around of ticket numbering:
     int32_t diff = int32_t(my_ticket - info->next_served);
@@ -1992,6 +2127,7 @@ void DB::do_begin_write()
     // In doing so, we may bypass other waiters, hence the condition for yielding
     // should take this situation into account by comparing with '>' instead of '!='
     info->next_served = my_ticket;
+    m_local_writers_waiting--;
     finish_begin_write();
 }
 
@@ -2000,8 +2136,13 @@ void DB::finish_begin_write()
     SharedInfo* info = m_file_map.get_addr();
     if (info->commit_in_critical_phase) {
         m_writemutex.unlock();
+        leave_local_writers();
         throw std::runtime_error("Crash of other process detected, session restart required");
     }
+    // Another session participant may have raised the file format, see low_level_commit(). While the file is
+    // upgraded to the format of the session, the format of this DB stays behind on purpose.
+    if (info->file_format_version == 11 && m_file_format_version == 10)
+        m_file_format_version = 11;
 
 #ifdef REALM_ASYNC_DAEMON
     if (info->durability == static_cast<uint16_t>(Durability::Async)) {
@@ -2025,17 +2166,60 @@ void DB::finish_begin_write()
 
 void DB::do_end_write() noexcept
 {
+    if (m_group_commit)
+        sync_group_commits();
+
     SharedInfo* info = m_file_map.get_addr();
     info->next_served++;
     m_pick_next_writer.notify_all();
 
-    std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
-    m_write_transaction_open = false;
-    m_writemutex.unlock();
+    {
+        // wait_for_durable() relies on the write lock staying with this DB while it holds m_header_mutex
+        std::lock_guard<std::mutex> header_lock(m_header_mutex);
+        std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
+        m_write_transaction_open = false;
+        m_writemutex.unlock();
+    }
+    leave_local_writers();
 }
 
 
-Replication::version_type DB::do_commit(Transaction& transaction)
+void DB::sync_group_commits() noexcept
+{
+    version_type pending;
+    {
+        std::lock_guard<std::mutex> lock(m_durable_mutex);
+        pending = m_group_sync_pending;
+        if (pending <= m_durable_version || pending <= m_group_sync_failed)
+            return;
+    }
+    // A waiting writer takes the versions over, and syncs them together with its own commit
+    if (m_local_writers_waiting > 0)
+        return;
+    try {
+        std::lock_guard<std::mutex> header_lock(m_header_mutex);
+        sync_deferred_commits(); // Throws
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(m_durable_mutex);
+        m_group_sync_failed = pending;
+        m_group_sync_error = std::current_exception();
+        m_durable_changed.notify_all();
+    }
+}
+
+
+void DB::leave_local_writers() noexcept
+{
+    if (--m_local_writers == 0) {
+        // Threads in wait_for_durable() may now have to sync themselves
+        std::lock_guard<std::mutex> lock(m_durable_mutex);
+        m_durable_changed.notify_all();
+    }
+}
+
+
+Replication::version_type DB::do_commit(Transaction& transaction, CommitSync sync)
 {
     version_type current_version;
     {
@@ -2052,7 +2236,7 @@ Replication::version_type DB::do_commit(Transaction& transaction)
         // must call Replication::abort_transact().
         new_version = repl->prepare_commit(current_version); // Throws
         try {
-            low_level_commit(new_version, transaction); // Throws
+            low_level_commit(new_version, transaction, sync); // Throws
         }
         catch (...) {
             repl->abort_transact();
@@ -2061,12 +2245,384 @@ Replication::version_type DB::do_commit(Transaction& transaction)
         repl->finalize_commit();
     }
     else {
-        low_level_commit(new_version, transaction); // Throws
+        low_level_commit(new_version, transaction, sync); // Throws
     }
     return new_version;
 }
 
 
+void DB::wait_for_durable(version_type version)
+{
+    if (!m_group_commit)
+        return;
+
+    bool retry = false;
+    for (;;) {
+        {
+            // The writer that was waiting for the write lock when `version` was committed makes it durable when it
+            // commits or releases the write lock, unless it leaves that to the next waiting writer in turn, see
+            // sync_group_commits(). The wait is bounded, as that writer may be busy for long, or even be waiting
+            // for this thread.
+            std::unique_lock<std::mutex> lock(m_durable_mutex);
+            m_durable_changed.wait_for(lock, std::chrono::milliseconds(100), [&] {
+                return m_durable_version >= version || m_group_sync_failed >= version ||
+                       (m_local_writers == 0 && !retry);
+            });
+            if (m_durable_version >= version)
+                return;
+            if (m_group_sync_failed >= version)
+                std::rethrow_exception(m_group_sync_error);
+        }
+
+        // Taking the write lock again could make this thread wait for a writer which waits for it
+        if (try_sync_deferred_commits()) // Throws
+            return;
+        retry = true;
+    }
+}
+
+
+bool DB::try_sync_deferred_commits()
+{
+    {
+        std::lock_guard<std::mutex> header_lock(m_header_mutex);
+        bool local_writer;
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            local_writer = m_write_transaction_open;
+        }
+        if (local_writer) {
+            // The write lock is held by a thread of this DB, which can neither release it nor write the header
+            // while we hold m_header_mutex. No other participant can change the header meanwhile either.
+            REALM_ASSERT(!m_wal);
+            version_type version = sync_latest_version(); // Throws
+            if (m_holds_durable_read_lock) {
+                // Versions the writer commits without syncing must not overwrite the version now on disk
+                ReadLockInfo read_lock;
+                grab_read_lock(read_lock, VersionID()); // Throws
+                release_read_lock(m_durable_read_lock);
+                m_durable_read_lock = read_lock;
+            }
+            set_durable_version(version);
+            return true;
+        }
+    }
+
+    if (!do_try_begin_write())
+        return false;
+    auto end_write = util::make_scope_exit([&]() noexcept {
+        do_end_write();
+    });
+    std::lock_guard<std::mutex> header_lock(m_header_mutex);
+    sync_deferred_commits(); // Throws
+    return true;
+}
+
+
+std::future<DB::version_type> DB::register_async_commit(version_type version)
+{
+    std::promise<version_type> promise;
+    auto future = promise.get_future();
+    std::lock_guard<std::mutex> lock(m_durable_mutex);
+    if (m_durable_version >= version) {
+        promise.set_value(version);
+        return future;
+    }
+    m_async_commits.emplace_back(version, std::move(promise));
+    if (!m_sync_thread.joinable())
+        m_sync_thread.start([this] {
+            run_sync_thread();
+        });
+    m_durable_changed.notify_all();
+    return future;
+}
+
+
+void DB::sync_deferred_commits()
+{
+    version_type version = sync_latest_version(); // Throws
+    release_durable_read_lock();
+    set_durable_version(version);
+}
+
+
+DB::version_type DB::sync_latest_version()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    version_type version;
+    ref_type top_ref;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        SharedInfo* r_info = m_reader_map.get_addr();
+        if (grow_reader_mapping(r_info->readers.last())) // Throws
+            r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& r = r_info->readers.get_last();
+        version = r.version;
+        top_ref = ref_type(r.current_top);
+    }
+
+    if (info->unsynced_commits) {
+        util::File& file = m_alloc.get_file();
+        if (!get_disable_sync_to_disk())
+            file.sync(); // Throws
+        write_header(file, top_ref, m_file_format_version); // Throws
+        // The log must only be emptied once the header points to the latest version
+        if (m_wal)
+            m_wal->reset(); // Throws
+        info->unsynced_commits = 0;
+    }
+    return version;
+}
+
+
+void DB::write_header(util::File& file, ref_type top_ref, int file_format_version)
+{
+    // Same as GroupWriter::commit(), but for a version that has already been written. Encryption is not in use when
+    // commits are deferred, so the header can be mapped directly.
+    bool disable_sync = get_disable_sync_to_disk();
+    using Header = SlabAlloc::Header;
+    util::File::Map<Header> map(file, util::File::access_ReadWrite, sizeof(Header)); // Throws
+    Header& header = *map.get_addr();
+    unsigned new_flags = (header.m_flags ^ SlabAlloc::flags_SelectBit) & ~unsigned(SlabAlloc::flags_WriteAheadLog);
+    int old_slot = ((header.m_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+    int new_slot = 1 - old_slot;
+    int old_file_format_version = SlabAlloc::get_file_format_version(header, old_slot);
+    // A file format version of zero means that it has not been decided yet
+    if (file_format_version == 0)
+        file_format_version = old_file_format_version;
+    header.m_file_format[new_slot] = uint8_t(file_format_version);
+    header.m_top_ref[new_slot] = top_ref;
+    if (!disable_sync)
+        map.sync(); // Throws
+    header.m_flags = uint8_t(new_flags);
+    if (!disable_sync)
+        map.sync(); // Throws
+
+    // The old slot is no longer selected, so it does not matter when this reaches the disk
+    header.m_file_format[old_slot] = uint8_t(old_file_format_version);
+    header.m_reserved = 0;
+}
+
+
+void DB::set_log_pending(util::File& file, bool pending)
+{
+    using Header = SlabAlloc::Header;
+    util::File::Map<Header> map(file, util::File::access_ReadWrite, sizeof(Header)); // Throws
+    Header& header = *map.get_addr();
+    unsigned flags = header.m_flags;
+    int slot = ((flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+    bool marked = (header.m_file_format[slot] == SlabAlloc::file_format_LogPending);
+    if (((flags & SlabAlloc::flags_WriteAheadLog) != 0) == pending && marked == pending)
+        return;
+    bool disable_sync = get_disable_sync_to_disk();
+    if (pending) {
+        // The flag alone would not stop cores which do not know it, so the file format version is replaced by one
+        // that no core supports. The actual version must be on disk before it is.
+        if (!marked) {
+            header.m_reserved = header.m_file_format[slot];
+            if (!disable_sync)
+                map.sync(); // Throws
+            header.m_file_format[slot] = SlabAlloc::file_format_LogPending;
+        }
+        header.m_flags = uint8_t(flags | SlabAlloc::flags_WriteAheadLog);
+    }
+    else {
+        header.m_file_format[slot] = uint8_t(SlabAlloc::get_file_format_version(header, slot));
+        header.m_reserved = 0;
+        header.m_flags = uint8_t(flags & ~unsigned(SlabAlloc::flags_WriteAheadLog));
+    }
+    if (!disable_sync)
+        map.sync(); // Throws
+}
+
+
+bool DB::is_log_pending(util::File& file)
+{
+    using Header = SlabAlloc::Header;
+    util::File::Map<Header> map(file, util::File::access_ReadOnly, sizeof(Header)); // Throws
+    return (map.get_addr()->m_flags & SlabAlloc::flags_WriteAheadLog) != 0;
+}
+
+
+void DB::recover_from_log(const std::string& path)
+{
+    if (!File::exists(path))
+        return;
+    std::string log_path = path + ".wal";
+    std::unique_ptr<_impl::WriteAheadLog> log;
+    if (File::exists(log_path))
+        log = std::make_unique<_impl::WriteAheadLog>(log_path); // Throws
+    File file(path, File::mode_Update); // Throws
+    bool has_header = file.get_size() >= File::SizeType(sizeof(SlabAlloc::Header));
+
+    // The file is marked before anything is written to the log, and the mark is only cleared once the header points
+    // to the latest commit. A log next to a file without the mark was left by another file, like one this file was
+    // replaced by, or by a checkpoint which did not get to empty it. Applying it would write over live data.
+    if (!has_header || !is_log_pending(file)) {
+        if (log && log->size() > 0)
+            log->reset(); // Throws
+        return;
+    }
+    if (!log || log->size() == 0) {
+        // The session may have ended between marking the file and logging its first commit
+        set_log_pending(file, false); // Throws
+        return;
+    }
+
+    // The changes of each record are written again in the order they were committed. All of them were made to space
+    // which was free in the version the header points to.
+    ref_type top_ref = 0;
+    int file_format_version = 0;
+    size_t num_records = log->replay([&](const _impl::WriteAheadLog::Record& record) {
+        if (uint64_t(file.get_size()) < record.file_size)
+            file.prealloc(size_t(record.file_size)); // Throws
+        for (auto& change : record.changes) {
+            file.seek(File::SizeType(change.first));
+            file.write(change.second.data(), change.second.size()); // Throws
+        }
+        top_ref = record.top_ref;
+        file_format_version = record.file_format_version;
+    }); // Throws
+
+    if (num_records > 0) {
+        if (!get_disable_sync_to_disk())
+            file.sync(); // Throws
+        write_header(file, top_ref, file_format_version); // Throws
+    }
+    else {
+        set_log_pending(file, false); // Throws
+    }
+    log->reset(); // Throws
+}
+
+
+void DB::release_durable_read_lock() noexcept
+{
+    if (m_holds_durable_read_lock) {
+        release_read_lock(m_durable_read_lock);
+        m_holds_durable_read_lock = false;
+    }
+}
+
+
+void DB::set_durable_version(version_type version)
+{
+    std::lock_guard<std::mutex> lock(m_durable_mutex);
+    m_durable_version = version;
+    auto it = std::partition(m_async_commits.begin(), m_async_commits.end(),
+                             [&](auto& entry) { return entry.first > version; });
+    for (auto i = it; i != m_async_commits.end(); ++i)
+        i->second.set_value(i->first);
+    m_async_commits.erase(it, m_async_commits.end());
+    m_durable_changed.notify_all();
+}
+
+
+void DB::checkpoint()
+{
+    do_begin_write(); // Throws
+    auto end_write = util::make_scope_exit([&]() noexcept {
+        do_end_write();
+    });
+    std::lock_guard<std::mutex> header_lock(m_header_mutex);
+    sync_deferred_commits(); // Throws
+}
+
+
+void DB::request_checkpoint()
+{
+    std::lock_guard<std::mutex> lock(m_durable_mutex);
+    m_checkpoint_requested = true;
+    if (!m_sync_thread.joinable())
+        m_sync_thread.start([this] {
+            run_sync_thread();
+        });
+    m_durable_changed.notify_all();
+}
+
+
+void DB::grow_file(size_t size)
+{
+    // File::prealloc() must not run concurrently with a commit changing the size of the file. Commits only take
+    // this lock if they must extend the file themselves, so writers are not held up while the file is extended.
+    std::lock_guard<InterprocessMutex> lock(m_growmutex); // Throws
+    if (m_alloc.is_attached() && m_alloc.resize_file(size)) // Throws
+        m_background_file_extensions++;
+}
+
+
+void DB::request_file_growth(size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_durable_mutex);
+    m_file_growth_target = std::max(m_file_growth_target, size);
+    if (!m_sync_thread.joinable())
+        m_sync_thread.start([this] {
+            run_sync_thread();
+        });
+    m_durable_changed.notify_all();
+}
+
+
+void DB::run_sync_thread()
+{
+    std::unique_lock<std::mutex> lock(m_durable_mutex);
+    for (;;) {
+        m_durable_changed.wait(lock, [&] {
+            return m_stop_sync_thread || m_checkpoint_requested || !m_async_commits.empty() ||
+                   m_file_growth_target;
+        });
+        // Commits made before the thread was asked to stop are still synced, but the file is not extended
+        size_t growth_target = m_stop_sync_thread ? 0 : m_file_growth_target;
+        m_file_growth_target = 0;
+        if (growth_target) {
+            lock.unlock();
+            try {
+                grow_file(growth_target); // Throws
+            }
+            catch (...) {
+                // The commits extend the file themselves
+            }
+            lock.lock();
+        }
+        if (m_async_commits.empty() && !m_checkpoint_requested) {
+            if (m_stop_sync_thread)
+                return;
+            continue;
+        }
+        m_checkpoint_requested = false;
+
+        // Everything committed until the write lock is ours is synced at once
+        lock.unlock();
+        try {
+            checkpoint(); // Throws
+        }
+        catch (...) {
+            // A failed checkpoint of the write-ahead log is retried by the next commit or when closing
+            lock.lock();
+            for (auto& entry : m_async_commits)
+                entry.second.set_exception(std::current_exception());
+            m_async_commits.clear();
+            continue;
+        }
+        lock.lock();
+    }
+}
+
+
+void DB::stop_sync_thread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_durable_mutex);
+        if (!m_sync_thread.joinable())
+            return;
+        m_stop_sync_thread = true;
+        m_durable_changed.notify_all();
+    }
+    m_sync_thread.join();
+    m_stop_sync_thread = false;
+}
+
+
 DB::version_type Transaction::commit_and_continue_as_read()
 {
     if (!is_attached())
@@ -2111,20 +2667,51 @@ bool DB::grow_reader_mapping(uint_fast32_t index)
     if (index >= m_local_max_entry) {
         // handle mapping expansion if required
         SharedInfo* r_info = m_reader_map.get_addr();
-        m_local_max_entry = r_info->readers.get_num_entries();
-        REALM_ASSERT(index < m_local_max_entry);
-        size_t info_size = sizeof(SharedInfo) + r_info->readers.compute_required_space(m_local_max_entry);
-        // std::cout << "Growing reader mapping to " << infosize << std::endl;
-        m_reader_map.remap(m_file, util::File::access_ReadWrite, info_size); // Throws
+        uint_fast32_t entries = r_info->readers.get_num_entries();
+        REALM_ASSERT(index < entries);
+        map_reader_info(entries); // Throws
         return true;
     }
     return false;
 }
 
 
+void DB::map_reader_info(uint_fast32_t entries)
+{
+    size_t info_size = sizeof(SharedInfo) + m_reader_map.get_addr()->readers.compute_required_space(entries);
+    // std::cout << "Growing reader mapping to " << infosize << std::endl;
+    util::File::Map<SharedInfo> map(m_file, util::File::access_ReadWrite, info_size); // Throws
+    m_retired_reader_maps.push_back(std::move(m_reader_map));                          // Throws
+    m_reader_map = std::move(map);
+    publish_reader_info(entries); // Throws
+    // A thread announcing itself after this point loads the new mapping, so if none is announced now, the replaced
+    // mappings can no longer be in use. Otherwise they are unmapped by a later growth.
+    if (m_reader_info_users.load(std::memory_order_seq_cst) == 0)
+        m_retired_reader_maps.clear();
+}
+
+
+void DB::publish_reader_info(uint_fast32_t entries)
+{
+    for (int chunk = 0; size_t(32) * ((size_t(1) << chunk) - 1) < entries; ++chunk) {
+        if (!m_local_read_counts[chunk])
+            m_local_read_counts[chunk] = std::make_unique<std::atomic<uint32_t>[]>(size_t(32) << chunk); // Throws
+    }
+    m_reader_info.store(m_reader_map.get_addr(), std::memory_order_seq_cst);
+    m_local_max_entry.store(entries, std::memory_order_release);
+}
+
+
+std::atomic<uint32_t>& DB::local_read_count(uint_fast32_t index) noexcept
+{
+    size_t i = size_t(index) / 32 + 1;
+    int chunk = log2(i);
+    return m_local_read_counts[chunk][index - size_t(32) * ((size_t(1) << chunk) - 1)];
+}
+
+
 DB::version_type DB::get_version_of_latest_snapshot()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     // As get_version_of_latest_snapshot() may be called outside of the write
     // mutex, another thread may be performing changes to the ringbuffer
     // concurrently. It may even cleanup and recycle the current entry from
@@ -2134,13 +2721,23 @@ DB::version_type DB::get_version_of_latest_snapshot()
     while (1) {
         uint_fast32_t index;
         SharedInfo* r_info;
-        do {
+        for (;;) {
             // make sure that the index we are about to dereference falls within
             // the portion of the ringbuffer that we have mapped - if not, extend
             // the mapping to fit.
-            r_info = m_reader_map.get_addr();
+            enter_reader_info();
+            r_info = m_reader_info.load(std::memory_order_seq_cst);
             index = r_info->readers.last();
-        } while (grow_reader_mapping(index)); // throws
+            if (index < m_local_max_entry.load(std::memory_order_acquire))
+                break;
+            leave_reader_info();
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            grow_reader_mapping(index); // throws
+        }
+        auto leave = util::make_scope_exit([&]() noexcept {
+            leave_reader_info();
+        });
+        r_info = m_reader_info.load(std::memory_order_acquire);
 
         // now (double) increment the read count so that no-one cleans up the entry
         // while we read it.
@@ -2157,9 +2754,27 @@ DB::version_type DB::get_version_of_latest_snapshot()
 }
 
 
-void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
+void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction, CommitSync sync)
 {
     SharedInfo* info = m_file_map.get_addr();
+    // With group commit, syncing is left to the next writer if one is already waiting for the write lock. Asynchronous
+    // commits leave it to the sync thread. With a write-ahead log, the database file is only synced by checkpoints.
+    bool defer_sync = false;
+    if (m_wal)
+        defer_sync = true;
+    else if (sync == CommitSync::group)
+        defer_sync = m_group_commit && m_local_writers_waiting > 0;
+    else if (sync == CommitSync::background)
+        defer_sync = m_can_defer_sync;
+    if (defer_sync) {
+        // The current version is the one found on disk after a crash until a later version is synced, so it must
+        // not be overwritten
+        std::lock_guard<std::mutex> header_lock(m_header_mutex);
+        if (!m_holds_durable_read_lock) {
+            grab_read_lock(m_durable_read_lock, VersionID()); // Throws
+            m_holds_durable_read_lock = true;
+        }
+    }
 
     // Version of oldest snapshot currently (or recently) bound in a transaction
     // of the current session.
@@ -2196,14 +2811,31 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
     // info->readers.dump();
     GroupWriter out(transaction, Durability(info->durability)); // Throws
     out.set_versions(new_version, oldest_version);
+    out.set_write_ahead_log(m_wal.get());
+    out.set_file_size_mutex(&m_growmutex);
+    // If the commit fails, the free lists are read from the file by the next one
+    out.set_free_space_state(std::move(m_free_space_state));
+    out.set_compaction_budget(m_compaction_budget);
     ref_type new_top_ref;
     // Recursively write all changed arrays to end of file
     {
         // protect against race with any other DB trying to attach to the file
         std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
-        new_top_ref = out.write_group();                         // Throws
+        // A file format raised by this commit, see Table::add_ordered_index(), is adopted by the whole session
+        // before any of the commit reaches the file, so that no participant goes on committing the previous one
+        int file_format_version = transaction.get_file_format_version();
+        if (file_format_version > info->file_format_version) {
+            info->file_format_version = uint8_t(file_format_version);
+            m_file_format_version = file_format_version;
+        }
+        new_top_ref = out.write_group(); // Throws
     }
+    // Room to keep at the end of the file, see DBOptions::file_growth_ahead
+    size_t logical_file_size = out.get_logical_file_size();
+    size_t growth_room = std::max(m_file_growth_ahead, size_t(double(logical_file_size) * m_file_growth_factor));
     {
+        // The header is written and the new version published while wait_for_durable() cannot sync the file
+        std::lock_guard<std::mutex> header_lock(m_header_mutex);
         // protect access to shared variables and m_reader_mapping from here
         std::lock_guard<std::recursive_mutex> lock_guard(m_mutex);
         m_free_space = out.get_free_space_size();
@@ -2214,7 +2846,36 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
         switch (Durability(info->durability)) {
             case Durability::Full:
             case Durability::Unsafe:
+                if (m_wal) {
+                    // Until the next checkpoint the file lacks the latest commits, so it must not be read without
+                    // the log
+                    if (!info->unsynced_commits)
+                        set_log_pending(m_alloc.get_file(), true); // Throws
+                    out.commit_to_log(new_top_ref); // Throws
+                    info->unsynced_commits = 1;
+                    break;
+                }
+                if (defer_sync) {
+                    info->unsynced_commits = 1;
+                    break;
+                }
+                if (info->unsynced_commits) {
+                    // The versions committed without syncing wrote to parts of the file that this commit may not
+                    // have touched. A single sync of the file makes all of them durable.
+                    if (!get_disable_sync_to_disk())
+                        m_alloc.get_file().sync(); // Throws
+                    info->unsynced_commits = 0;
+                }
                 out.commit(new_top_ref); // Throws
+                if (m_compaction_budget && !m_key) {
+                    // The file may now be shorter. The commit is already durable, so if cutting the file fails,
+                    // it just stays longer until a later commit tries again.
+                    try {
+                        out.shrink_file(growth_room); // Throws
+                    }
+                    catch (const std::system_error&) {
+                    }
+                }
                 break;
             case Durability::MemOnly:
             case Durability::Async:
@@ -2238,14 +2899,14 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
             SharedInfo* r_info = m_reader_map.get_addr();
             if (r_info->readers.is_full()) {
                 // buffer expansion
+                // Grown geometrically, so that a version kept alive across many commits only causes a few remaps
                 uint_fast32_t entries = r_info->readers.get_num_entries();
-                entries = entries + 32;
+                entries = entries + std::max(uint_fast32_t(32), entries / 2);
                 size_t new_info_size = sizeof(SharedInfo) + r_info->readers.compute_required_space(entries);
                 // std::cout << "resizing: " << entries << " = " << new_info_size << std::endl;
-                m_file.prealloc(new_info_size);                                          // Throws
-                m_reader_map.remap(m_file, util::File::access_ReadWrite, new_info_size); // Throws
+                m_file.prealloc(new_info_size); // Throws
+                map_reader_info(entries);       // Throws
                 r_info = m_reader_map.get_addr();
-                m_local_max_entry = entries;
                 r_info->readers.expand_to(entries);
             }
             Ringbuffer::ReadCount& r = r_info->readers.get_next();
@@ -2260,6 +2921,11 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
         // can safely proceed once the writemutex has been lifted.
         info->commit_in_critical_phase = 0;
     }
+    m_free_space_state = out.release_free_space_state();
+    if (out.extended_file())
+        m_commit_file_extensions++;
+    if (growth_room && out.get_file_size() < logical_file_size + growth_room / 2)
+        request_file_growth(util::round_up_to_page_size(logical_file_size + growth_room));
     {
         // protect against concurrent updates to the .lock file.
         // must release m_mutex before this point to obey lock order
@@ -2269,6 +2935,26 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
 
         m_new_commit_available.notify_all();
     }
+
+    if (m_wal) {
+        // The version is durable once it is in the log
+        set_durable_version(new_version);
+        if (m_wal->size() >= m_wal_checkpoint_size)
+            request_checkpoint();
+    }
+    else if (!defer_sync) {
+        // Synced directly, or as far as the durability level asks for
+        {
+            std::lock_guard<std::mutex> header_lock(m_header_mutex);
+            release_durable_read_lock();
+        }
+        set_durable_version(new_version);
+    }
+    else if (sync == CommitSync::group) {
+        // Left to the writer waiting for the write lock, see sync_group_commits()
+        std::lock_guard<std::mutex> lock(m_durable_mutex);
+        m_group_sync_pending = new_version;
+    }
 }
 
 #ifdef REALM_DEBUG
@@ -2305,16 +2991,25 @@ std::vector<std::pair<std::string, bool>> DB::get_core_files(const std::string&
     std::vector<std::pair<std::string, bool>> files;
     files.emplace_back(std::make_pair(realm_path, false));
     files.emplace_back(std::make_pair(realm_path + ".management", true));
+    // The write-ahead log only exists if it has been enabled
+    if (File::exists(realm_path + ".wal"))
+        files.emplace_back(std::make_pair(realm_path + ".wal", false));
     return files;
 }
 
+namespace realm {
+
 // FIXME: Extend to provide recycling of transaction objects?
 void TransactionDeleter(Transaction* t)
 {
+    // The last reference to a shared transaction is gone, so it can be ended
+    t->m_shared = false;
     t->close();
     delete t;
 }
 
+} // namespace realm
+
 TransactionRef DB::start_read(VersionID version_id)
 {
     if (!is_attached())
@@ -2341,6 +3036,35 @@ TransactionRef DB::start_frozen(VersionID version_id)
     return TransactionRef(tr, TransactionDeleter);
 }
 
+TransactionRef DB::start_shared_frozen(VersionID version_id)
+{
+    if (!is_attached())
+        throw LogicError(LogicError::wrong_transact_state);
+    bool latest = version_id.version == std::numeric_limits<version_type>::max();
+    version_type version = latest ? get_version_of_latest_snapshot() : version_id.version;
+    std::lock_guard<std::mutex> lock(m_shared_frozen_mutex);
+    auto it = m_shared_frozen.find(version);
+    if (it != m_shared_frozen.end()) {
+        if (TransactionRef tr = it->second.lock())
+            return tr;
+    }
+
+    TransactionRef tr = start_frozen(version_id); // Throws
+    for (auto i = m_shared_frozen.begin(); i != m_shared_frozen.end();) {
+        if (i->second.expired())
+            i = m_shared_frozen.erase(i);
+        else
+            ++i;
+    }
+    // The latest version may have moved on to one which is already shared since it was looked up
+    auto& shared = m_shared_frozen[tr->get_version_of_current_transaction().version]; // Throws
+    if (TransactionRef existing = shared.lock())
+        return existing;
+    tr->m_shared = true;
+    shared = tr;
+    return tr;
+}
+
 Transaction::Transaction(DBRef _db, SlabAlloc* alloc, DB::ReadLockInfo& rli, DB::TransactStage stage)
     : Group(alloc)
     , db(_db)
@@ -2356,6 +3080,8 @@ Transaction::Transaction(DBRef _db, SlabAlloc* alloc, DB::ReadLockInfo& rli, DB:
 
 void Transaction::close()
 {
+    if (m_shared)
+        return;
     if (m_transact_stage == DB::transact_Writing) {
         rollback();
     }
@@ -2366,7 +3092,7 @@ void Transaction::close()
 
 void Transaction::end_read()
 {
-    if (m_transact_stage == DB::transact_Ready)
+    if (m_transact_stage == DB::transact_Ready || m_shared)
         return;
     if (m_transact_stage == DB::transact_Writing)
         throw LogicError(LogicError::wrong_transact_state);
@@ -2468,7 +3194,7 @@ DB::version_type Transaction::commit()
     // before committing, allow any accessors at group level or below to sync
     flush_accessors_for_commit();
 
-    DB::version_type new_version = db->do_commit(*this); // Throws
+    DB::version_type new_version = db->do_commit(*this, DB::CommitSync::group); // Throws
 
     // We need to set m_read_lock in order for wait_for_change to work.
     // To set it, we grab a readlock on the latest available snapshot
@@ -2480,12 +3206,44 @@ DB::version_type Transaction::commit()
 
     db->do_end_write();
 
+    DBRef db_ref = db; // Released by do_end_read()
     do_end_read();
     m_read_lock = lock_after_commit;
 
+    db_ref->wait_for_durable(new_version); // Throws
+
     return new_version;
 }
 
+std::future<DB::version_type> Transaction::commit_async()
+{
+    if (!is_attached())
+        throw LogicError(LogicError::wrong_transact_state);
+    if (m_transact_stage != DB::transact_Writing)
+        throw LogicError(LogicError::wrong_transact_state);
+
+    REALM_ASSERT(is_attached());
+
+    // before committing, allow any accessors at group level or below to sync
+    flush_accessors_for_commit();
+
+    DB::version_type new_version = db->do_commit(*this, DB::CommitSync::background); // Throws
+    // Registered while the write lock is held, so that the sync thread cannot miss the commit
+    std::future<DB::version_type> durable = db->register_async_commit(new_version); // Throws
+
+    VersionID version_id = VersionID(); // Latest available snapshot
+    DB::ReadLockInfo lock_after_commit;
+    db->grab_read_lock(lock_after_commit, version_id);
+    db->release_read_lock(lock_after_commit);
+
+    db->do_end_write();
+
+    do_end_read();
+    m_read_lock = lock_after_commit;
+
+    return durable;
+}
+
 void Transaction::commit_and_continue_writing()
 {
     if (!is_attached())
@@ -2548,13 +3306,17 @@ TransactionRef DB::start_write(bool nonblocking)
     else {
         do_begin_write();
     }
+    bool attached;
     {
         std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
-        if (!is_attached()) {
-            do_end_write();
-            throw LogicError(LogicError::wrong_transact_state);
-        }
-        m_write_transaction_open = true;
+        attached = is_attached();
+        if (attached)
+            m_write_transaction_open = true;
+    }
+    if (!attached) {
+        // Not under m_mutex, as do_end_write() takes m_header_mutex
+        do_end_write();
+        throw LogicError(LogicError::wrong_transact_state);
     }
     ReadLockInfo read_lock;
     Transaction* tr;
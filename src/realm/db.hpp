@@ -19,9 +19,14 @@
 #ifndef REALM_GROUP_SHARED_HPP
 #define REALM_GROUP_SHARED_HPP
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <cstdint>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <realm/util/features.h>
 #include <realm/util/thread.hpp>
 #include <realm/util/interprocess_condvar.hpp>
@@ -38,6 +43,8 @@ namespace realm {
 
 namespace _impl {
 class WriteLogCollector;
+class WriteAheadLog;
+struct FreeSpaceState;
 }
 
 class Transaction;
@@ -137,6 +144,9 @@ public:
     /// to control release as follows:
     ///  * explicitly close() transactions at earliest time possible and
     ///  * explicitly nullify any DBRefs you may have.
+    /// If the write-ahead log cannot be applied to the database file, the DB
+    /// is still closed, and the error is thrown afterwards. The log is then
+    /// applied when the file is opened again.
     void close(bool allow_open_read_transactions = false);
 
     bool is_attached() const noexcept;
@@ -224,6 +234,15 @@ public:
     // an invalid TransactionRef is returned.
     TransactionRef start_write(bool nonblocking = false);
 
+    /// Get a frozen transaction on the specified version (the latest by
+    /// default) which is shared with all other callers asking for the same
+    /// version while it is in use. They share a single read lock and the same
+    /// table accessors, so only the first of them pays for setting them up. As
+    /// the other callers may still use it, close() and end_read() do nothing on
+    /// a shared frozen transaction. It is released when the last reference to
+    /// it is dropped.
+    TransactionRef start_shared_frozen(VersionID = VersionID());
+
 
     // report statistics of last commit done on THIS DB.
     // The free space reported is what can be expected to be freed
@@ -235,6 +254,15 @@ public:
     // Notice that we will always have two live versions - the current and the
     // previous.
     void get_stats(size_t& free_space, size_t& used_space, util::Optional<size_t&> locked_space = util::none) const;
+
+    struct FileGrowthStats {
+        // Number of commits which had to extend the file themselves
+        uint64_t commit_extensions = 0;
+        // Number of times the file was extended ahead of the commits, see DBOptions::file_growth_ahead
+        uint64_t background_extensions = 0;
+    };
+    // report how often the file was extended by commits done on THIS DB, and by its background thread.
+    FileGrowthStats get_file_growth_stats() const noexcept;
     //@}
 
     enum TransactStage {
@@ -367,7 +395,7 @@ protected:
 
 private:
     std::recursive_mutex m_mutex;
-    int m_transaction_count = 0;
+    std::atomic<int> m_transaction_count{0};
     SlabAlloc m_alloc;
     Replication* m_replication = nullptr;
     struct SharedInfo;
@@ -384,11 +412,23 @@ private:
     size_t m_free_space = 0;
     size_t m_locked_space = 0;
     size_t m_used_space = 0;
-    uint_fast32_t m_local_max_entry = 0; // highest version observed by this DB
-    std::vector<ReadLockInfo> m_local_locks_held; // tracks all read locks held by this DB
     util::File m_file;
     util::File::Map<SharedInfo> m_file_map; // Never remapped, provides access to everything but the ringbuffer
     util::File::Map<SharedInfo> m_reader_map; // provides access to ringbuffer, remapped as needed when it grows
+    // Read locks are grabbed and released without holding m_mutex, unless the ringbuffer has grown beyond what is
+    // mapped. This requires that the mappings of the ringbuffer stay valid while they are used when it is remapped,
+    // so the replaced mappings are only unmapped once no thread uses m_reader_info without the mutex. The address
+    // of the current mapping is published before the number of entries it covers.
+    std::atomic<SharedInfo*> m_reader_info{nullptr};
+    std::atomic<uint_fast32_t> m_local_max_entry{0}; // number of ringbuffer entries covered by m_reader_info
+    std::vector<util::File::Map<SharedInfo>> m_retired_reader_maps;
+    // Number of threads using m_reader_info without holding m_mutex, see enter_reader_info(). close() waits for
+    // them before it unmaps the ringbuffer.
+    std::atomic<uint32_t> m_reader_info_users{0};
+    // Number of read locks held by this DB on each entry of the ringbuffer. The counts are kept in chunks which are
+    // never moved or freed while the DB exists. Chunk n holds the counts of 32 << n entries.
+    static constexpr int s_num_read_count_chunks = 32;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_local_read_counts[s_num_read_count_chunks];
     bool m_wait_for_change_enabled = true; // Initially wait_for_change is enabled
     bool m_write_transaction_open = false;
     std::string m_lockfile_path;
@@ -396,12 +436,14 @@ private:
     std::string m_db_path;
     std::string m_coordination_dir;
     const char* m_key;
-    int m_file_format_version = 0;
+    // Raised while the session goes on when a commit changes the file format, see low_level_commit()
+    std::atomic<int> m_file_format_version{0};
     util::InterprocessMutex m_writemutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessMutex m_balancemutex;
 #endif
     util::InterprocessMutex m_controlmutex;
+    util::InterprocessMutex m_growmutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessCondVar m_room_to_write;
     util::InterprocessCondVar m_work_to_do;
@@ -410,6 +452,66 @@ private:
     util::InterprocessCondVar m_new_commit_available;
     util::InterprocessCondVar m_pick_next_writer;
     std::function<void(int, int)> m_upgrade_callback;
+    // Frozen transactions handed out by start_shared_frozen() by version. They are not kept alive by the DB, as
+    // each of them holds a reference to it.
+    std::mutex m_shared_frozen_mutex;
+    std::map<version_type, std::weak_ptr<Transaction>> m_shared_frozen;
+
+    // Whether syncing commits to disk can be left to a later point, which requires Durability::Full and no
+    // encryption
+    bool m_can_defer_sync = false;
+    // Group commit, see DBOptions::enable_group_commit
+    bool m_group_commit = false;
+    // Number of threads of this DB waiting in do_begin_write()
+    std::atomic<int> m_local_writers_waiting{0};
+    // Number of threads of this DB waiting for or holding the write lock. When it drops to zero, no writer of this
+    // DB is left to sync the versions committed by group commit, see wait_for_durable().
+    std::atomic<int> m_local_writers{0};
+    // Held by a writer of this DB while it writes the header of the database file or changes the read lock on the
+    // durable version, and while it releases the write lock. This lets wait_for_durable() sync the file while
+    // another thread of this DB holds the write lock. Must be locked before m_mutex.
+    std::mutex m_header_mutex;
+    // Read lock on the latest durable version, held while later versions committed by this DB are not yet
+    // durable. It prevents the space used by the durable version from being reused. Guarded by the write mutex
+    // and m_header_mutex.
+    ReadLockInfo m_durable_read_lock;
+    bool m_holds_durable_read_lock = false;
+    // Latest version committed by this DB known to be durable
+    std::mutex m_durable_mutex;
+    std::condition_variable m_durable_changed;
+    version_type m_durable_version = 0;
+    // Latest version committed by group commit without syncing, and the latest such version which the writer it
+    // was left to failed to sync, with the reason. Guarded by m_durable_mutex.
+    version_type m_group_sync_pending = 0;
+    version_type m_group_sync_failed = 0;
+    std::exception_ptr m_group_sync_error;
+    // Versions committed by Transaction::commit_async() which are not yet durable, and the promises to fulfill
+    // once they are. The background sync thread is started by the first of them. Guarded by m_durable_mutex.
+    std::vector<std::pair<version_type, std::promise<version_type>>> m_async_commits;
+    util::Thread m_sync_thread;
+    bool m_stop_sync_thread = false;
+    // Write-ahead log, see DBOptions::enable_write_ahead_log. Only used with the write lock held.
+    std::unique_ptr<_impl::WriteAheadLog> m_wal;
+    uint64_t m_wal_checkpoint_size = 0;
+    // See DBOptions::incremental_compaction_budget
+    size_t m_compaction_budget = 0;
+    // Set when the sync thread must checkpoint the write-ahead log. Guarded by m_durable_mutex.
+    bool m_checkpoint_requested = false;
+    // Settings for the mappings of the file, see DBOptions::prefault
+    int m_map_flags = 0;
+    bool m_advise_random_access = false;
+    bool m_use_huge_pages = false;
+    size_t m_decrypted_page_budget = 0;
+    // See DBOptions::file_growth_ahead
+    size_t m_file_growth_ahead = 0;
+    double m_file_growth_factor = 0;
+    // Size the sync thread must extend the file to, or zero. Guarded by m_durable_mutex.
+    size_t m_file_growth_target = 0;
+    std::atomic<uint64_t> m_commit_file_extensions{0};
+    std::atomic<uint64_t> m_background_file_extensions{0};
+    // Free lists of the version last committed through this DB, see GroupWriter::set_free_space_state(). Only used
+    // with the write lock held.
+    std::unique_ptr<_impl::FreeSpaceState> m_free_space_state;
 
     std::shared_ptr<metrics::Metrics> m_metrics;
     /// Attach this DB instance to the specified database file.
@@ -495,16 +597,76 @@ private:
     /// return true if write transaction can commence, false otherwise.
     bool do_try_begin_write();
     void do_begin_write();
-    version_type do_commit(Transaction&);
+
+    // When a commit is synced to disk
+    enum class CommitSync {
+        immediate, // Before the commit returns
+        group,     // By the next writer if one is waiting for the write lock, see wait_for_durable()
+        background // By the background sync thread, see register_async_commit()
+    };
+    version_type do_commit(Transaction&, CommitSync sync = CommitSync::immediate);
     void do_end_write() noexcept;
+    // Wait until `version` is durable, making it durable if no other writer does so soon. Never waits for the
+    // write lock.
+    void wait_for_durable(version_type version);
+    void leave_local_writers() noexcept;
+    // Sync the versions left to this writer by group commit, unless another writer of this DB is waiting to take
+    // them over. Must be called with the write lock held.
+    void sync_group_commits() noexcept;
+    // Sync the versions committed without syncing if it can be done without waiting for the write lock. Return
+    // false if another session participant holds the write lock.
+    bool try_sync_deferred_commits();
+    // Get a future which is ready once `version` is durable. Must be called with the write lock held.
+    std::future<version_type> register_async_commit(version_type version);
+    // Sync the versions committed without syncing, and make the latest version durable. Must be called with the
+    // write lock held, and m_header_mutex unless no other thread of this DB can be writing.
+    void sync_deferred_commits();
+    // Sync the file and point its header to the latest version if it does not already. Return that version.
+    version_type sync_latest_version();
+    // Record that all versions up to `version` are durable
+    void set_durable_version(version_type version);
+    void release_durable_read_lock() noexcept;
+    // Take the write lock and sync the versions committed without syncing, emptying the write-ahead log
+    void checkpoint();
+    void request_checkpoint();
+    // Extend the file to at least `size` bytes, holding only the lock on changes of the file size
+    void grow_file(size_t size);
+    void request_file_growth(size_t size);
+    void run_sync_thread();
+    void stop_sync_thread();
+    // Apply the records left in the write-ahead log of the database file at `path` by a session which did not
+    // checkpoint it, if the file is marked as having commits pending in the log. A log next to an unmarked file is
+    // emptied instead. Must be called by the session initiator before attaching the file.
+    static void recover_from_log(const std::string& path);
+    // Point the file header at `top_ref`, the same way GroupWriter::commit() does for a new version. Also clears the
+    // mark of a pending write-ahead log.
+    static void write_header(util::File& file, ref_type top_ref, int file_format_version);
+    // Mark in the file header whether commits are pending in the write-ahead log, by setting
+    // SlabAlloc::flags_WriteAheadLog and replacing the file format version (see SlabAlloc::file_format_LogPending)
+    static void set_log_pending(util::File& file, bool pending);
+    static bool is_log_pending(util::File& file);
 
     // make sure the given index is within the currently mapped area.
     // if not, expand the mapped area. Returns true if the area is expanded.
     bool grow_reader_mapping(uint_fast32_t index);
+    // Map the first `entries` entries of the ringbuffer. The current mapping is kept until no thread can still use
+    // it. Must be called with m_mutex held.
+    void map_reader_info(uint_fast32_t entries);
+    void publish_reader_info(uint_fast32_t entries);
+    // Bracket the use of m_reader_info without holding m_mutex. The mapping loaded in between stays valid.
+    void enter_reader_info() noexcept
+    {
+        m_reader_info_users.fetch_add(1, std::memory_order_seq_cst);
+    }
+    void leave_reader_info() noexcept
+    {
+        m_reader_info_users.fetch_sub(1, std::memory_order_release);
+    }
+    std::atomic<uint32_t>& local_read_count(uint_fast32_t index) noexcept;
 
     // Must be called only by someone that has a lock on the write
     // mutex.
-    void low_level_commit(uint_fast64_t new_version, Transaction& transaction);
+    void low_level_commit(uint_fast64_t new_version, Transaction& transaction, CommitSync sync);
 
     void do_async_commits();
 
@@ -535,6 +697,14 @@ inline void DB::get_stats(size_t& free_space, size_t& used_space, util::Optional
     }
 }
 
+inline DB::FileGrowthStats DB::get_file_growth_stats() const noexcept
+{
+    FileGrowthStats stats;
+    stats.commit_extensions = m_commit_file_extensions;
+    stats.background_extensions = m_background_file_extensions;
+    return stats;
+}
+
 
 class Transaction : public Group {
 public:
@@ -563,6 +733,12 @@ public:
     size_t get_commit_size() const;
 
     DB::version_type commit();
+    /// Commit without waiting for the new version to be synced to disk, which
+    /// is done by a background thread of the DB. The returned future is ready
+    /// once the version is durable. Commits are only deferred in
+    /// Durability::Full without encryption, otherwise the future is ready
+    /// immediately.
+    std::future<DB::version_type> commit_async();
     void rollback();
     void end_read();
 
@@ -642,9 +818,12 @@ private:
 
     DB::ReadLockInfo m_read_lock;
     DB::TransactStage m_transact_stage = DB::transact_Ready;
+    // Handed out by DB::start_shared_frozen(), so it is only ended when the last reference to it is dropped
+    bool m_shared = false;
 
     friend class DB;
     friend class DisableReplication;
+    friend void TransactionDeleter(Transaction*);
 };
 
 class DisableReplication {
@@ -872,6 +1051,8 @@ inline bool Transaction::promote_to_write(O* observer, bool nonblocking)
         VersionID version = VersionID();                                              // Latest
         m_history = repl->_get_history_write();
         bool history_updated = internal_advance_read(observer, version, *m_history, true); // Throws
+        // A commit may have changed the file format since this transaction started
+        set_file_format_version(db->get_file_format_version());
 
         REALM_ASSERT(repl); // Presence of `repl` follows from the presence of `hist`
         DB::version_type current_version = m_read_lock.m_version;
@@ -101,6 +101,81 @@ struct DBOptions {
     /// is exceeded without being consumed, only the most recent entries will be stored.
     size_t metrics_buffer_size;
 
+    /// If \a enable_group_commit is set to `true`, a write transaction
+    /// committed while other threads of the same DB are waiting to start a
+    /// write transaction is not synced to disk on its own. The next commit
+    /// which is not followed by a waiting writer syncs the file once for all
+    /// the commits before it. Transaction::commit() still only returns once
+    /// the committed version is durable, and throws if syncing it fails.
+    /// This only affects Durability::Full without encryption.
+    bool enable_group_commit = false;
+
+    /// If \a enable_write_ahead_log is set to `true`, a commit appends the
+    /// parts of the database file it wrote to a log file next to it (named
+    /// by appending ".wal" to the path of the database file), and syncs
+    /// only the log. This replaces syncing every part of the database file
+    /// that was written with a single sequential write. The database file is
+    /// synced and the log emptied by a background thread once the log has
+    /// grown beyond \a write_ahead_log_checkpoint_size bytes, and when the DB
+    /// is closed. If the process crashes before that, the log is applied when
+    /// the file is opened again. All session participants must use the same
+    /// setting. This only affects Durability::Full without encryption.
+    bool enable_write_ahead_log = false;
+    size_t write_ahead_log_checkpoint_size = 16 * 1024 * 1024;
+
+    /// If \a incremental_compaction_budget is not zero, commits move arrays
+    /// from the end of the file to free space before it, when at least a
+    /// quarter of the file is free. Each commit examines and moves arrays
+    /// making up at most this many bytes, continuing where the previous
+    /// commit stopped. Free space at the end of the file is given back to
+    /// the file system by the next commit which syncs the file. Unlike
+    /// DB::compact(), this does not require the DB to be the only session
+    /// participant.
+    size_t incremental_compaction_budget = 0;
+
+    /// If \a file_growth_ahead is not zero, the database file is extended
+    /// ahead of the data by a background thread of the DB, so that commits
+    /// find room at the end of the file which is already allocated on disk,
+    /// instead of extending and syncing the file themselves. After a commit
+    /// leaving less than half of the room, the file is extended to
+    /// \a file_growth_ahead bytes beyond the data, or by
+    /// \a file_growth_factor times the size of the data if that is more.
+    /// See DB::get_file_growth_stats() for how often commits still had to
+    /// extend the file.
+    size_t file_growth_ahead = 0;
+    double file_growth_factor = 0;
+
+    /// How the parts of the database file mapped into memory are read in.
+    /// By default, each page is read on the first access to it, which shows
+    /// up as latency spikes after the file is opened and after it has grown.
+    /// With Prefault::WillNeed, the system is asked to start reading newly
+    /// mapped parts in the background. With Prefault::Populate, they are
+    /// read before mapping them returns. Ignored for encrypted files.
+    enum class Prefault { None, WillNeed, Populate };
+    Prefault prefault = Prefault::None;
+
+    /// If \a advise_random_access is `true`, the system is told that the
+    /// database file is accessed at random, so that it does not read ahead
+    /// of the pages which are accessed. DB::compact() tells it that the file
+    /// is read sequentially while it copies it, regardless.
+    bool advise_random_access = false;
+
+    /// If \a use_huge_pages is `true`, the memory holding the data changed
+    /// by write transactions is backed by transparent huge pages where the
+    /// system supports it. This only applies to the 2 MB aligned parts of
+    /// that memory, so small write transactions are unaffected.
+    bool use_huge_pages = false;
+
+    /// If \a decrypted_page_budget is not zero, the memory holding the
+    /// decrypted pages of an encrypted file is kept to at most this many
+    /// bytes. The page reclaimer, which runs once a second, releases the
+    /// pages which went unaccessed the longest, once no transaction which
+    /// could still refer to them is left. If DBs of the same file in a
+    /// process give different budgets, the smallest applies. When metrics are
+    /// enabled, each metrics::TransactionInfo reports the decrypted pages of
+    /// the file. Ignored for files which are not encrypted.
+    size_t decrypted_page_budget = 0;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating SharedGroupOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
@@ -29,6 +29,7 @@
 #include <realm/util/file_mapper.hpp>
 #include <realm/util/memory_stream.hpp>
 #include <realm/util/miscellaneous.hpp>
+#include <realm/util/scope_exit.hpp>
 #include <realm/util/thread.hpp>
 #include <realm/impl/destroy_guard.hpp>
 #include <realm/utilities.hpp>
@@ -301,7 +302,7 @@ int Group::get_committed_file_format_version() const noexcept
 }
 
 
-int Group::get_target_file_format_version_for_session(int /* current_file_format_version */,
+int Group::get_target_file_format_version_for_session(int current_file_format_version,
                                                       int /* requested_history_type */) noexcept
 {
     // Note: This function is responsible for choosing the target file format
@@ -316,6 +317,11 @@ int Group::get_target_file_format_version_for_session(int /* current_file_format
     // Please see Group::get_file_format_version() for information about the
     // individual file format versions.
 
+    // Version 11 is only chosen by the commit adding the first ordered index to
+    // a file, see Table::add_ordered_index(), so that files without ordered
+    // indexes can still be opened by cores that do not know version 11.
+    if (current_file_format_version == 11)
+        return 11;
     return 10;
 }
 
@@ -482,6 +488,7 @@ void Group::open(ref_type top_ref, const std::string& file_path)
             file_format_ok = (top_ref == 0);
             break;
         case 10:
+        case 11:
             file_format_ok = true;
             break;
     }
@@ -1114,6 +1121,15 @@ void Group::write(File& file, const char* encryption_key, uint_fast64_t version_
     }
     File::Streambuf streambuf(&file, buffer_size);
 
+    // All of the data is read in order. The mappings of a DB are shared with other transactions, so it is left to
+    // DB::compact() to give the hint for those.
+    if (!m_is_shared)
+        m_alloc.advise_access(File::advice_Sequential);
+    auto restore_advice = util::make_scope_exit([&]() noexcept {
+        if (!m_is_shared)
+            m_alloc.advise_access(File::advice_Normal);
+    });
+
     std::ostream out(&streambuf);
     out.exceptions(std::ios_base::failbit | std::ios_base::badbit);
     write(out, encryption_key != 0, version_number, write_history);
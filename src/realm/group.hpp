@@ -813,6 +813,11 @@ private:
     ///  10 Memory mapping changes which require special treatment of large files
     ///     of preceeding versions.
     ///
+    ///  11 Ordered indexes, stored in an optional 13th entry of the top array
+    ///     of tables. A file of version 10 is changed to version 11 by the
+    ///     commit which adds its first ordered index, and is not upgraded
+    ///     otherwise.
+    ///
     /// IMPORTANT: When introducing a new file format version, be sure to review
     /// the file validity checks in Group::open() and SharedGroup::do_open, the file
     /// format selection logic in
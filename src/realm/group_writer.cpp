@@ -17,6 +17,7 @@
  **************************************************************************/
 
 #include <algorithm>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <iostream>
@@ -24,7 +25,9 @@
 
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/safe_int_ops.hpp>
+#include <realm/util/worker_pool.hpp>
 #include <realm/group_writer.hpp>
+#include <realm/impl/write_ahead_log.hpp>
 #include <realm/db.hpp>
 #include <realm/alloc_slab.hpp>
 #include <realm/disable_sync_to_disk.hpp>
@@ -34,6 +37,9 @@ using namespace realm;
 using namespace realm::util;
 using namespace realm::metrics;
 
+constexpr size_t GroupWriter::parallel_write_threshold;
+constexpr unsigned GroupWriter::max_write_threads;
+
 // Class controlling a memory mapped window into a file
 class GroupWriter::MapWindow {
 public:
@@ -163,6 +169,8 @@ GroupWriter::GroupWriter(Group& group, Durability dura)
     , m_durability(dura)
 {
     m_map_windows.reserve(num_map_windows);
+    // The copies would have to go through the encryption barriers one page at a time
+    m_defer_writes = !m_alloc.get_file().get_encryption_key();
 #if REALM_IOS
     m_window_alignment = 1 * 1024 * 1024; // 1M
 #else
@@ -267,9 +275,14 @@ size_t GroupWriter::get_file_size() const noexcept
     return sz;
 }
 
+size_t GroupWriter::get_logical_file_size() const noexcept
+{
+    return to_size_t(m_group.m_top.get(2) / 2);
+}
+
 void GroupWriter::sync_all_mappings()
 {
-    if (m_durability == Durability::Unsafe)
+    if (!syncs_mappings())
         return;
     for (const auto& window : m_map_windows) {
         window->sync();
@@ -292,7 +305,7 @@ GroupWriter::MapWindow* GroupWriter::get_window(ref_type start_ref, size_t size)
     }
     // no window found, make room for a new one at the top
     if (m_map_windows.size() == num_map_windows) {
-        if (m_durability != Durability::Unsafe)
+        if (syncs_mappings())
             m_map_windows.back()->sync();
         m_map_windows.pop_back();
     }
@@ -317,11 +330,14 @@ ref_type GroupWriter::write_group()
 #endif
 
     read_in_freelist();
-    // Now, 'm_size_map' holds all free elements candidate for recycling
+    // Now, 'm_free_space->size_map' holds all free elements candidate for recycling
+
+    if (m_compaction_budget && is_shared)
+        prepare_compaction();
 
     Array& top = m_group.m_top;
 #if REALM_ALLOC_DEBUG
-    std::cout << "    In-file freelist after merge:  " << m_size_map.size() << std::endl;
+    std::cout << "    In-file freelist after merge:  " << m_free_space->size_map.size() << std::endl;
     std::cout << "    Allocating file space for data:" << std::endl;
 #endif
 
@@ -355,8 +371,10 @@ ref_type GroupWriter::write_group()
         }
     }
 
+    flush_deferred_writes();
+
 #if REALM_ALLOC_DEBUG
-    std::cout << "    Freelist size after allocations: " << m_size_map.size() << std::endl;
+    std::cout << "    Freelist size after allocations: " << m_free_space->size_map.size() << std::endl;
 #endif
 
     // We now have a bit of a chicken-and-egg problem. We need to write the
@@ -365,7 +383,7 @@ ref_type GroupWriter::write_group()
     // calculate an upper bound on the amount af space required for all of the
     // remaining arrays and allocate the space as one big chunk. This way we can
     // finalize the free-lists before writing them to the file.
-    size_t max_free_list_size = m_size_map.size();
+    size_t max_free_list_size = m_free_space->chunks.size();
 
     // We need to add to the free-list any space that was freed during the
     // current transaction, but to avoid clobering the previous version, we
@@ -383,7 +401,6 @@ ref_type GroupWriter::write_group()
     std::cout << "/" << free_read_only_size << std::endl;
 #endif
     max_free_list_size += free_read_only_size;
-    max_free_list_size += m_not_free_in_file.size();
     // The final allocation of free space (i.e., the call to
     // reserve_free_space() below) may add extra entries to the free-lists.
     // We reserve room for the worst case scenario, which is as follows:
@@ -503,6 +520,14 @@ ref_type GroupWriter::write_group()
     m_free_lengths.set(reserve_ndx, value_9);   // Throws
     m_free_space_size += rest;
 
+    // Keep the free lists in the same state for the next commit
+    erase_from_size_map(reserve_pos, reserve_size);
+    m_free_space->chunks.erase(reserve_pos);
+    m_free_space->size_map.emplace(rest, size_t(end_ref));                                // Throws
+    m_free_space->chunks.emplace(size_t(end_ref), _impl::FreeSpaceState::Chunk{rest, 0}); // Throws
+    m_free_space->version = m_current_version;
+    m_free_space->free_positions_ref = free_positions_ref;
+
     // The free-list now have their final form, so we can write them to the file
     // char* start_addr = m_file_map.get_addr() + reserve_ref;
     MapWindow* window = get_window(reserve_ref, end_ref - reserve_ref);
@@ -517,6 +542,8 @@ ref_type GroupWriter::write_group()
     // Write top
     write_array_at(window, top_ref, top.get_header(), top_byte_size); // Throws
     window->encryption_write_barrier(start_addr, used);
+    if (m_log)
+        note_written(reserve_ref, used);
     // Return top_ref so that it can be saved in lock file used for coordination
     return top_ref;
 }
@@ -524,31 +551,63 @@ ref_type GroupWriter::write_group()
 
 void GroupWriter::read_in_freelist()
 {
-    FreeList free_in_file;
-
     bool is_shared = m_group.m_is_shared;
     size_t limit = m_free_lengths.size();
     REALM_ASSERT_RELEASE_EX(m_free_positions.size() == limit, limit, m_free_positions.size());
     REALM_ASSERT_RELEASE_EX(!is_shared || m_free_versions.size() == limit, limit, m_free_versions.size());
-
-    if (limit) {
-        auto limit_version = is_shared ? m_readlock_version : 0;
+    auto limit_version = is_shared ? m_readlock_version : 0;
+
+    // The free lists kept from the previous commit are only of use if no other
+    // writer has committed since. Version zero is never kept, as the free
+    // chunks of the file are locked in that case.
+    bool reuse = m_free_space && is_shared && limit_version > 0 &&
+                 m_free_space->version == uint64_t(m_group.m_top.get(6) / 2) &&
+                 m_free_space->free_positions_ref == m_free_positions.get_ref();
+    if (reuse) {
+        release_locked_chunks();
+    }
+    else {
+        // A stale compaction cursor only decides where the search continues,
+        // so it is kept even if another writer has changed the file.
+        std::vector<size_t> cursor;
+        if (m_free_space)
+            cursor = std::move(m_free_space->compaction_cursor);
+        m_free_space = std::make_unique<_impl::FreeSpaceState>(); // Throws
+        m_free_space->compaction_cursor = std::move(cursor);
+        auto& chunks = m_free_space->chunks;
         for (size_t idx = 0; idx < limit; ++idx) {
             size_t ref = size_t(m_free_positions.get(idx));
             size_t size = size_t(m_free_lengths.get(idx));
-
+            uint64_t version = 0;
             if (is_shared) {
-                uint64_t version = m_free_versions.get(idx);
+                version = m_free_versions.get(idx);
                 // Entries that are freed in still alive versions are not candidates for merge or allocation
                 if (version >= limit_version) {
-                    m_not_free_in_file.emplace_back(ref, size, version);
+                    chunks.emplace_hint(chunks.end(), ref, _impl::FreeSpaceState::Chunk{size, version}); // Throws
+                    m_free_space->locked.emplace(version, ref);                                        // Throws
                     continue;
                 }
+                version = 0;
             }
-
-            free_in_file.emplace_back(ref, size, 0);
+            REALM_ASSERT_RELEASE_EX(!(size & 7), size);
+            REALM_ASSERT_RELEASE_EX(!(ref & 7), ref);
+            // Combine with the previous chunk if they are adjacent and both free
+            if (!chunks.empty()) {
+                auto& prev = *chunks.rbegin();
+                if (prev.first + prev.second.size == ref && prev.second.released_at_version == 0) {
+                    prev.second.size += size;
+                    continue;
+                }
+            }
+            chunks.emplace_hint(chunks.end(), ref, _impl::FreeSpaceState::Chunk{size, version}); // Throws
         }
+        for (auto& chunk : chunks) {
+            if (chunk.second.released_at_version == 0)
+                m_free_space->size_map.emplace(chunk.second.size, chunk.first); // Throws
+        }
+    }
 
+    if (limit) {
         // This will imply a copy-on-write
         m_free_positions.clear();
         m_free_lengths.clear();
@@ -564,86 +623,266 @@ void GroupWriter::read_in_freelist()
         if (is_shared)
             m_free_versions.copy_on_write();
     }
+}
+
+void GroupWriter::release_locked_chunks()
+{
+    auto& chunks = m_free_space->chunks;
+    auto& locked = m_free_space->locked;
+    auto end = locked.lower_bound(m_readlock_version);
+    for (auto it = locked.begin(); it != end; it = locked.erase(it)) {
+        auto chunk = chunks.find(it->second);
+        REALM_ASSERT_RELEASE(chunk != chunks.end() && chunk->second.released_at_version == it->first);
+        chunk->second.released_at_version = 0;
+        merge_free_chunk(chunk); // Throws
+    }
+
+    // Chunks which were split, or added by extending the file, are merged once
+    // they are no longer needed in one piece
+    for (size_t pos : m_free_space->unmerged) {
+        auto chunk = chunks.find(pos);
+        if (chunk == chunks.end() || chunk->second.released_at_version != 0)
+            continue;
+        erase_from_size_map(chunk->first, chunk->second.size);
+        merge_free_chunk(chunk); // Throws
+    }
+    m_free_space->unmerged.clear();
+}
+
+void GroupWriter::merge_free_chunk(std::map<size_t, _impl::FreeSpaceState::Chunk>::iterator chunk)
+{
+    auto& chunks = m_free_space->chunks;
+    auto next = std::next(chunk);
+    if (next != chunks.end() && next->second.released_at_version == 0 &&
+        chunk->first + chunk->second.size == next->first) {
+        erase_from_size_map(next->first, next->second.size);
+        chunk->second.size += next->second.size;
+        chunks.erase(next);
+    }
+    if (chunk != chunks.begin()) {
+        auto prev = std::prev(chunk);
+        if (prev->second.released_at_version == 0 && prev->first + prev->second.size == chunk->first) {
+            erase_from_size_map(prev->first, prev->second.size);
+            prev->second.size += chunk->second.size;
+            chunks.erase(chunk);
+            chunk = prev;
+        }
+    }
+    m_free_space->size_map.emplace(chunk->second.size, chunk->first); // Throws
+}
+
+void GroupWriter::erase_from_size_map(size_t pos, size_t size)
+{
+    auto& size_map = m_free_space->size_map;
+    auto range = size_map.equal_range(size);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == pos) {
+            size_map.erase(it);
+            return;
+        }
+    }
+    REALM_ASSERT_RELEASE_EX(false, pos, size);
+}
+
+void GroupWriter::prepare_compaction()
+{
+    auto& chunks = m_free_space->chunks;
+    size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+
+    // Free space at the end of the file is cut off, down to a page boundary
+    if (!chunks.empty()) {
+        auto last = std::prev(chunks.end());
+        size_t end = last->first + last->second.size;
+        size_t new_size = util::round_up_to_page_size(last->first);
+        if (last->second.released_at_version == 0 && end == logical_file_size && new_size < end) {
+            erase_from_size_map(last->first, last->second.size);
+            if (new_size > last->first) {
+                last->second.size = new_size - last->first;
+                m_free_space->size_map.emplace(last->second.size, last->first); // Throws
+            }
+            else {
+                chunks.erase(last);
+            }
+            logical_file_size = new_size;
+            m_group.m_top.set(2, 1 + 2 * uint64_t(new_size)); // Throws
+        }
+    }
+
+    // Compact once a quarter of the file is free, by moving the arrays beyond
+    // the size of the data, plus some room for it to grow.
+    size_t free_size = 0;
+    for (const auto& chunk : chunks)
+        free_size += chunk.second.size;
+    size_t used_size = logical_file_size - free_size;
+    size_t boundary = util::round_up_to_page_size(used_size + used_size / 8);
+    if (free_size < logical_file_size / 4 || boundary >= logical_file_size) {
+        m_free_space->compaction_cursor.clear();
+        return;
+    }
+    m_compaction_boundary = boundary;
+    find_arrays_to_move(); // Throws
+}
+
+void GroupWriter::find_arrays_to_move()
+{
+    // Slots of the top array: table names, tables and history
+    static const size_t slots[] = {0, 1, 8};
+    Array& top = m_group.m_top;
+    auto& cursor = m_free_space->compaction_cursor;
+    size_t budget = m_compaction_budget;
+    size_t first = cursor.empty() ? 0 : cursor[0];
+    m_scan_stopped = false;
+    for (size_t i = first; i < 3 && !m_scan_stopped; ++i) {
+        if (slots[i] >= top.size())
+            break;
+        ref_type ref = top.get_as_ref(slots[i]);
+        if (!ref)
+            continue;
+        m_scan_path.assign(1, i); // Throws
+        bool resume = !cursor.empty() && i == cursor[0];
+        find_arrays_to_move(ref, resume, budget); // Throws
+    }
+    // Start from the beginning again next time
+    if (!m_scan_stopped)
+        cursor.clear();
+}
+
+bool GroupWriter::find_arrays_to_move(ref_type ref, bool resume, size_t& budget)
+{
+    auto& cursor = m_free_space->compaction_cursor;
+    bool read_only = m_alloc.is_read_only(ref);
+    char* header = m_alloc.translate(ref);
+    bool has_refs = NodeHeader::get_hasrefs_from_header(header);
+    bool move = read_only && ref >= m_compaction_boundary;
+
+    // Arrays which are moved or searched for refs count in full, others only by their header
+    size_t cost = (move || has_refs) ? NodeHeader::get_byte_size_from_header(header) : NodeHeader::header_size;
+    budget -= std::min(budget, cost);
+
+    if (has_refs) {
+        Array array(m_alloc);
+        array.init_from_mem(MemRef(header, ref, m_alloc));
+        size_t depth = m_scan_path.size();
+        bool on_cursor = resume && depth < cursor.size();
+        size_t n = array.size();
+        for (size_t i = on_cursor ? cursor[depth] : 0; i < n; ++i) {
+            if (budget == 0) {
+                cursor = m_scan_path; // Throws
+                cursor.push_back(i);  // Throws
+                m_scan_stopped = true;
+                break;
+            }
+            int_fast64_t value = array.get(i);
+            if (value == 0 || (value & 1) != 0)
+                continue;
+            m_scan_path.push_back(i); // Throws
+            if (find_arrays_to_move(to_ref(value), on_cursor && i == cursor[depth], budget)) // Throws
+                move = true;
+            m_scan_path.pop_back();
+            if (m_scan_stopped)
+                break;
+        }
+    }
+
+    // An array above one that is moved must be written to hold its new ref
+    if (move && read_only)
+        m_rewrite.insert(ref); // Throws
+    return move;
+}
+
+bool GroupWriter::must_rewrite(ref_type ref)
+{
+    auto it = m_rewrite.find(ref);
+    if (it == m_rewrite.end())
+        return false;
+    m_rewrite.erase(it);
+    // The old copy is freed, as if the array had been copied on write
+    m_alloc.free_(ref, m_alloc.translate(ref));
+    return true;
+}
+
+void GroupWriter::shrink_file(size_t room)
+{
+#ifdef _WIN32
+    static_cast<void>(room);
+#else
+    size_t new_file_size = util::round_up_to_page_size(get_logical_file_size() + room);
+    auto lock = lock_file_size(); // Throws
+    if (get_file_size() > new_file_size) {
+        // The windows may map the part of the file which is cut off
+        m_map_windows.clear();
+        m_alloc.get_file().resize(new_file_size); // Throws
+    }
+#endif
+}
 
-    free_in_file.merge_adjacent_entries_in_freelist();
-    // Previous step produces - potentially - some entries with size of zero. These
-    // entries will be skipped in the next step.
-    free_in_file.move_free_in_file_to_size_map(m_size_map);
+std::unique_lock<util::InterprocessMutex> GroupWriter::lock_file_size()
+{
+    if (!m_file_size_mutex)
+        return std::unique_lock<util::InterprocessMutex>();
+    return std::unique_lock<util::InterprocessMutex>(*m_file_size_mutex); // Throws
 }
 
 size_t GroupWriter::recreate_freelist(size_t reserve_pos)
 {
-    std::vector<FreeSpaceEntry> free_in_file;
+    auto& chunks = m_free_space->chunks;
     auto& new_free_space = m_group.m_alloc.get_free_read_only(); // Throws
-    auto nb_elements = m_size_map.size() + m_not_free_in_file.size() + new_free_space.size();
-    free_in_file.reserve(nb_elements);
-
     size_t reserve_ndx = realm::npos;
     bool is_shared = m_group.m_is_shared;
 
-    for (const auto& entry : m_size_map) {
-        free_in_file.emplace_back(entry.second, entry.first, 0);
-    }
-
     {
         size_t locked_space_size = 0;
-        REALM_ASSERT_RELEASE(m_not_free_in_file.empty() || is_shared);
-        for (const auto& locked : m_not_free_in_file) {
-            free_in_file.emplace_back(locked.ref, locked.size, locked.released_at_version);
-            locked_space_size += locked.size;
-        }
+        REALM_ASSERT_RELEASE(m_free_space->locked.empty() || is_shared);
+        for (const auto& locked : m_free_space->locked)
+            locked_space_size += chunks.at(locked.second).size;
 
         for (const auto& free_space : new_free_space) {
-            free_in_file.emplace_back(free_space.first, free_space.second, m_current_version);
-            locked_space_size += free_space.second;
+            auto ref = free_space.first;
+            auto size = free_space.second;
+            auto next = chunks.lower_bound(ref);
+            bool overlaps = (next != chunks.end() && next->first < ref + size);
+            if (next != chunks.begin()) {
+                auto prev = std::prev(next);
+                overlaps = overlaps || prev->first + prev->second.size > ref;
+            }
+            if (REALM_UNLIKELY(overlaps)) {
+                // Check if we are freeing arrays already in the locked chunks
+                for (const auto& locked : m_free_space->locked) {
+                    size_t locked_size = chunks.at(locked.second).size;
+                    REALM_ASSERT_RELEASE_EX(ref < locked.second || ref >= (locked.second + locked_size),
+                                            locked.second, locked_size, locked.first, ref, m_current_version,
+                                            m_alloc.get_file_path_for_assertions());
+                    REALM_ASSERT_RELEASE_EX(locked.second < ref || locked.second >= (ref + size), locked.second,
+                                            locked.first, ref, size, m_current_version,
+                                            m_alloc.get_file_path_for_assertions());
+                }
+                REALM_ASSERT_RELEASE_EX(!overlaps, ref, size, m_alloc.get_file_path_for_assertions());
+            }
+            chunks.emplace_hint(next, ref, _impl::FreeSpaceState::Chunk{size, m_current_version}); // Throws
+            m_free_space->locked.emplace(m_current_version, ref);                                // Throws
+            locked_space_size += size;
         }
         m_locked_space_size = locked_space_size;
     }
 
-    REALM_ASSERT(free_in_file.size() == nb_elements);
-    std::sort(begin(free_in_file), end(free_in_file), [](auto& a, auto& b) { return a.ref < b.ref; });
-
     {
-        // Copy into arrays while checking consistency
-        size_t prev_ref = 0;
-        size_t prev_size = 0;
+        // Copy into arrays, which are sorted by position
         size_t free_space_size = 0;
-        auto limit = free_in_file.size();
-        for (size_t i = 0; i < limit; ++i) {
-            const auto& free_space = free_in_file[i];
-            auto ref = free_space.ref;
-            if (REALM_UNLIKELY(prev_ref + prev_size > ref)) {
-                // Check if we are freeing arrays already in 'm_not_free_in_file'
-                for (const auto& elem : new_free_space) {
-                    ref_type free_ref = elem.first;
-                    size_t free_sz = elem.second;
-                    for (const auto& locked : m_not_free_in_file) {
-                        REALM_ASSERT_RELEASE_EX(free_ref < locked.ref || free_ref >= (locked.ref + locked.size),
-                                                locked.ref, locked.size, locked.released_at_version, free_ref,
-                                                m_current_version, m_alloc.get_file_path_for_assertions());
-                        REALM_ASSERT_RELEASE_EX(locked.ref < free_ref || locked.ref >= (free_ref + free_sz),
-                                                locked.ref, locked.released_at_version, free_ref, free_sz,
-                                                m_current_version, m_alloc.get_file_path_for_assertions());
-                    }
-                }
-
-                REALM_ASSERT_RELEASE_EX(prev_ref + prev_size <= ref, prev_ref, prev_size, ref, i, limit,
-                                        m_alloc.get_file_path_for_assertions());
-            }
-            if (reserve_pos == ref) {
+        size_t i = 0;
+        for (const auto& chunk : chunks) {
+            if (reserve_pos == chunk.first) {
                 reserve_ndx = i;
             }
             else {
                 // The reserved chunk should not be counted in now. We don't know how much of it
                 // will eventually be used.
-                free_space_size += free_space.size;
+                free_space_size += chunk.second.size;
             }
-            m_free_positions.add(free_space.ref);
-            m_free_lengths.add(free_space.size);
+            m_free_positions.add(chunk.first);
+            m_free_lengths.add(chunk.second.size);
             if (is_shared)
-                m_free_versions.add(free_space.released_at_version);
-            prev_ref = free_space.ref;
-            prev_size = free_space.size;
+                m_free_versions.add(chunk.second.released_at_version);
+            ++i;
         }
         REALM_ASSERT_RELEASE(reserve_ndx != realm::npos);
 
@@ -653,36 +892,6 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
     return reserve_ndx;
 }
 
-void GroupWriter::FreeList::merge_adjacent_entries_in_freelist()
-{
-    if (size() > 1) {
-        // Combine any adjacent chunks in the freelist
-        auto prev = begin();
-        for (auto it = begin() + 1; it != end(); ++it) {
-            REALM_ASSERT(it->ref > prev->ref);
-            if (prev->ref + prev->size == it->ref) {
-                prev->size += it->size;
-                it->size = 0;
-            }
-            else {
-                prev = it;
-            }
-        }
-    }
-}
-
-void GroupWriter::FreeList::move_free_in_file_to_size_map(std::multimap<size_t, size_t>& size_map)
-{
-    for (auto& elem : *this) {
-        // Skip elements merged in 'merge_adjacent_entries_in_freelist'
-        if (elem.size) {
-            REALM_ASSERT_RELEASE_EX(!(elem.size & 7), elem.size);
-            REALM_ASSERT_RELEASE_EX(!(elem.ref & 7), elem.ref);
-            size_map.emplace(elem.size, elem.ref);
-        }
-    }
-}
-
 size_t GroupWriter::get_free_space(size_t size)
 {
     REALM_ASSERT_3(size % 8, ==, 0); // 8-byte alignment
@@ -697,13 +906,15 @@ size_t GroupWriter::get_free_space(size_t size)
     REALM_ASSERT_RELEASE_EX(!(chunk_size & 7), chunk_size);
 
     size_t rest = chunk_size - size;
-    m_size_map.erase(p);
+    m_free_space->size_map.erase(p);
+    m_free_space->chunks.erase(chunk_pos);
     if (rest > 0) {
         // Allocating part of chunk - this alway happens from the beginning
         // of the chunk. The call to reserve_free_space may split chunks
         // in order to make sure that it returns a chunk from which allocation
         // can be done from the beginning
-        m_size_map.emplace(rest, chunk_pos + size);
+        m_free_space->size_map.emplace(rest, chunk_pos + size);                                // Throws
+        m_free_space->chunks.emplace(chunk_pos + size, _impl::FreeSpaceState::Chunk{rest, 0}); // Throws
     }
     return chunk_pos;
 }
@@ -713,14 +924,17 @@ inline GroupWriter::FreeListElement GroupWriter::split_freelist_chunk(FreeListEl
 {
     size_t start_pos = it->second;
     size_t chunk_size = it->first;
-    m_size_map.erase(it);
+    m_free_space->size_map.erase(it);
     REALM_ASSERT_RELEASE_EX(alloc_pos > start_pos, alloc_pos, start_pos);
 
     REALM_ASSERT_RELEASE_EX(!(alloc_pos & 7), alloc_pos);
     size_t size_first = alloc_pos - start_pos;
     size_t size_second = chunk_size - size_first;
-    m_size_map.emplace(size_first, start_pos);
-    return m_size_map.emplace(size_second, alloc_pos);
+    m_free_space->size_map.emplace(size_first, start_pos); // Throws
+    m_free_space->chunks.at(start_pos).size = size_first;
+    m_free_space->chunks.emplace(alloc_pos, _impl::FreeSpaceState::Chunk{size_second, 0}); // Throws
+    m_free_space->unmerged.push_back(start_pos);                                           // Throws
+    return m_free_space->size_map.emplace(size_second, alloc_pos);                         // Throws
 }
 
 GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element(FreeListElement it, size_t size)
@@ -733,7 +947,7 @@ GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element
     size_t start_pos = it->second;
     size_t alloc_pos = alloc.find_section_in_range(start_pos, chunk_size, size);
     if (alloc_pos == 0) {
-        return m_size_map.end();
+        return m_free_space->size_map.end();
     }
     // we found a place - if it's not at the beginning of the chunk,
     // we split the chunk so that the allocation can be done from the
@@ -745,33 +959,41 @@ GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element
     return it;
 }
 
-GroupWriter::FreeListElement GroupWriter::search_free_space_in_part_of_freelist(size_t size)
+GroupWriter::FreeListElement GroupWriter::search_free_space_in_part_of_freelist(size_t size, bool anywhere)
 {
-    auto it = m_size_map.lower_bound(size);
-    while (it != m_size_map.end()) {
+    auto it = m_free_space->size_map.lower_bound(size);
+    while (it != m_free_space->size_map.end()) {
+        if (!anywhere && m_compaction_boundary && it->second >= m_compaction_boundary) {
+            ++it;
+            continue;
+        }
         // Accept either a perfect match or a block that is twice the size. Tests have shown
         // that this is a good strategy.
         if (it->first == size || it->first >= 2 * size) {
             auto ret = search_free_space_in_free_list_element(it, size);
-            if (ret != m_size_map.end()) {
+            if (ret != m_free_space->size_map.end()) {
                 return ret;
             }
             ++it;
         }
         else {
             // If block was too small, search for the first that is at least twice as big.
-            it = m_size_map.lower_bound(2 * size);
+            it = m_free_space->size_map.lower_bound(2 * size);
         }
     }
     // No match
-    return m_size_map.end();
+    return m_free_space->size_map.end();
 }
 
 
 GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
 {
-    auto chunk = search_free_space_in_part_of_freelist(size);
-    while (chunk == m_size_map.end()) {
+    auto chunk = search_free_space_in_part_of_freelist(size, false);
+    if (chunk == m_free_space->size_map.end() && m_compaction_boundary) {
+        // Better to use the space being compacted than to extend the file
+        chunk = search_free_space_in_part_of_freelist(size, true);
+    }
+    while (chunk == m_free_space->size_map.end()) {
         // No free space, so we have to extend the file.
         auto new_chunk = extend_free_space(size);
         chunk = search_free_space_in_free_list_element(new_chunk, size);
@@ -832,10 +1054,16 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
 
     // Note: resize_file() will call File::prealloc() which may misbehave under
     // race conditions (see documentation of File::prealloc()). Fortunately, no
-    // race conditions can occur, because in transactional mode we hold a write
-    // lock at this time, and in non-transactional mode it is the responsibility
-    // of the user to ensure non-concurrent file mutation.
-    m_alloc.resize_file(new_file_size); // Throws
+    // race conditions can occur, because in transactional mode we hold the
+    // lock on changes of the file size at this time, and in non-transactional
+    // mode it is the responsibility of the user to ensure non-concurrent file
+    // mutation. The file only grows while we do not hold the lock, so if it
+    // was extended ahead of time, the lock is not needed.
+    if (new_file_size > get_file_size()) {
+        auto lock = lock_file_size();           // Throws
+        if (m_alloc.resize_file(new_file_size)) // Throws
+            m_extended_file = true;
+    }
     REALM_ASSERT(new_file_size <= get_file_size());
 #if REALM_ALLOC_DEBUG
     std::cout << "        ** File extension to " << new_file_size << "     after request for " << requested_size
@@ -847,7 +1075,9 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
     size_t chunk_size = new_file_size - logical_file_size;
     REALM_ASSERT_RELEASE_EX(!(chunk_size & 7), chunk_size);
     REALM_ASSERT_RELEASE(chunk_size != 0);
-    auto it = m_size_map.emplace(chunk_size, logical_file_size);
+    auto it = m_free_space->size_map.emplace(chunk_size, logical_file_size);                       // Throws
+    m_free_space->chunks.emplace(logical_file_size, _impl::FreeSpaceState::Chunk{chunk_size, 0}); // Throws
+    m_free_space->unmerged.push_back(logical_file_size);                                          // Throws
 
     // Update the logical file size
     m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
@@ -855,6 +1085,19 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
     return it;
 }
 
+namespace {
+
+// Threads helping commits copy their arrays into the file, shared by all
+// writers of the process. There is one fewer than there are cores, and at most
+// 3, as a commit copies on up to 4 threads including its own.
+util::WorkerPool& write_workers()
+{
+    static util::WorkerPool workers(std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U) - 1);
+    return workers;
+}
+
+} // anonymous namespace
+
 bool inline is_aligned(char* addr)
 {
     size_t as_binary = reinterpret_cast<size_t>(addr);
@@ -865,6 +1108,14 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
 {
     // Get position of free space to write in (expanding file if needed)
     size_t pos = get_free_space(size);
+    if (m_log)
+        note_written(pos, size);
+
+    if (m_defer_writes && !NodeHeader::get_hasrefs_from_header(data)) {
+        m_deferred_writes.push_back({to_ref(pos), data, size, checksum}); // Throws
+        m_deferred_size += size;
+        return to_ref(pos);
+    }
 
     // Write the block
     MapWindow* window = get_window(pos, size);
@@ -880,6 +1131,82 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
 }
 
 
+void GroupWriter::flush_deferred_writes()
+{
+    unsigned num_parts = 1;
+    if (m_deferred_size >= parallel_write_threshold)
+        num_parts = std::min(write_workers().num_threads() + 1, max_write_threads);
+
+    std::vector<char*> dest;
+    std::vector<MapWindow*> windows;
+    std::vector<MapWindow*> dest_windows;
+    std::vector<size_t> part_ends;
+    size_t begin = 0;
+    size_t n = m_deferred_writes.size();
+    while (begin < n) {
+        // Getting a window may remap the other parts of that window, so every
+        // window of a batch is looked up before translating any address. A
+        // batch uses fewer windows than are cached, so none of them are closed
+        // before the batch has been copied.
+        windows.clear();
+        dest_windows.clear();
+        size_t end = begin;
+        size_t batch_size = 0;
+        while (end < n) {
+            const DeferredWrite& w = m_deferred_writes[end];
+            MapWindow* window = get_window(w.ref, w.size);
+            if (std::find(windows.begin(), windows.end(), window) == windows.end()) {
+                if (windows.size() == size_t(num_map_windows - 1))
+                    break;
+                windows.push_back(window); // Throws
+            }
+            dest_windows.push_back(window); // Throws
+            batch_size += w.size;
+            ++end;
+        }
+        dest.clear();
+        for (size_t i = begin; i < end; ++i) {
+            const DeferredWrite& w = m_deferred_writes[i];
+            // The source must still be the array that was deferred, see DeferredWrite
+            REALM_ASSERT_DEBUG(NodeHeader::get_byte_size_from_header(w.data) == w.size);
+            char* dest_addr = dest_windows[i - begin]->translate(w.ref);
+            REALM_ASSERT_RELEASE(is_aligned(dest_addr));
+            dest.push_back(dest_addr); // Throws
+        }
+
+        // Split the batch into parts of about the same size
+        part_ends.clear();
+        size_t part_size = batch_size / num_parts + 1;
+        size_t size = 0;
+        for (size_t i = begin; i < end; ++i) {
+            size += m_deferred_writes[i].size;
+            if (size >= part_size || i + 1 == end) {
+                part_ends.push_back(i + 1); // Throws
+                size = 0;
+            }
+        }
+        auto copy = [&](size_t part) {
+            size_t part_begin = part == 0 ? begin : part_ends[part - 1];
+            for (size_t i = part_begin; i < part_ends[part]; ++i) {
+                const DeferredWrite& w = m_deferred_writes[i];
+                char* dest_addr = dest[i - begin];
+                memcpy(dest_addr, &w.checksum, 4);
+                memcpy(dest_addr + 4, w.data + 4, w.size - 4);
+            }
+        };
+        // Another writer using the workers copies its own parts while this
+        // one copies all of its parts itself
+        if (part_ends.size() < 2 || !write_workers().try_run(part_ends.size(), copy)) { // Throws
+            for (size_t part = 0; part < part_ends.size(); ++part)
+                copy(part);
+        }
+        begin = end;
+    }
+    m_deferred_writes.clear();
+    m_deferred_size = 0;
+}
+
+
 void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* data, size_t size)
 {
     size_t pos = size_t(ref);
@@ -947,6 +1274,40 @@ void GroupWriter::commit(ref_type new_top_ref)
 }
 
 
+void GroupWriter::note_written(ref_type ref, size_t size)
+{
+    // Arrays are mostly written one after the other, so most of them extend the previous part. A part must stay
+    // within a single window though.
+    if (!m_written.empty()) {
+        auto& last = m_written.back();
+        bool same_window = last.first / m_window_alignment == (ref + size - 1) / m_window_alignment;
+        if (last.first + last.second == ref && same_window) {
+            last.second += size;
+            return;
+        }
+    }
+    m_written.emplace_back(ref, size);
+}
+
+
+void GroupWriter::commit_to_log(ref_type new_top_ref)
+{
+    REALM_ASSERT(m_log);
+    try {
+        for (auto& part : m_written) {
+            MapWindow* window = get_window(part.first, part.second);
+            m_log->add(part.first, window->translate(part.first), part.second); // Throws
+        }
+    }
+    catch (...) {
+        // The next commit must not carry the data of this one
+        m_log->discard();
+        throw;
+    }
+    m_log->commit(m_current_version, new_top_ref, get_file_size(), m_group.get_file_format_version()); // Throws
+}
+
+
 #ifdef REALM_DEBUG
 
 void GroupWriter::dump()
@@ -22,6 +22,10 @@
 #include <cstdint> // unint8_t etc
 #include <utility>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include <realm/util/file.hpp>
 #include <realm/alloc.hpp>
@@ -35,6 +39,38 @@ namespace realm {
 // Pre-declarations
 class Group;
 class SlabAlloc;
+namespace util {
+class InterprocessMutex;
+}
+namespace _impl {
+class WriteAheadLog;
+
+/// The free lists of the version last written by a GroupWriter, in a form that
+/// can be updated by the next commit, instead of having to read the free lists
+/// of the file back in, sort and merge them. Kept between commits by DB.
+struct FreeSpaceState {
+    struct Chunk {
+        size_t size;
+        // Version the chunk was released in, or zero if no snapshot in use can see it anymore
+        uint64_t released_at_version;
+    };
+    // The version described, and the ref of its list of free positions
+    uint64_t version = 0;
+    ref_type free_positions_ref = 0;
+    // All chunks, by position
+    std::map<size_t, Chunk> chunks;
+    // The chunks that can be allocated from, as (size, position)
+    std::multimap<size_t, size_t> size_map;
+    // The other chunks, as (version released in, position)
+    std::multimap<uint64_t, size_t> locked;
+    // Free chunks split or added since they were last merged with their neighbours
+    std::vector<size_t> unmerged;
+    // Path to the array where the search for arrays to move by incremental
+    // compaction continues: the index of the slot of the top array, followed
+    // by the index of the ref in each array below it
+    std::vector<size_t> compaction_cursor;
+};
+} // namespace _impl
 
 
 /// This class is not supposed to be reused for multiple write sessions. In
@@ -69,9 +105,73 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Keep track of the changes made by write_group(), so that they can be
+    /// appended to \a log by commit_to_log() instead of being synced. Must be
+    /// called before write_group().
+    void set_write_ahead_log(_impl::WriteAheadLog* log) noexcept
+    {
+        m_log = log;
+    }
+
+    /// Append the changes made by write_group() to the write-ahead log as a
+    /// record of the new version, and sync the log. The file header is left
+    /// unchanged. Pass the top ref returned by write_group().
+    void commit_to_log(ref_type new_top_ref);
+
+    /// Pass the free lists kept from the previous commit. They are only used
+    /// if they describe the version this commit is based on. Must be called
+    /// before write_group().
+    void set_free_space_state(std::unique_ptr<_impl::FreeSpaceState> state) noexcept
+    {
+        m_free_space = std::move(state);
+    }
+
+    /// The free lists of the version written by write_group(), to be passed
+    /// to the next commit.
+    std::unique_ptr<_impl::FreeSpaceState> release_free_space_state() noexcept
+    {
+        return std::move(m_free_space);
+    }
+
+    /// Move arrays from the end of the file to free space before it, making
+    /// up at most \a budget bytes, see
+    /// DBOptions::incremental_compaction_budget. Must be called before
+    /// write_group().
+    void set_compaction_budget(size_t budget) noexcept
+    {
+        m_compaction_budget = budget;
+    }
+
+    /// Change the size of the file only while holding \a mutex, as the file
+    /// may be extended concurrently by another thread or process, see
+    /// DB::grow_file(). Must be called before write_group().
+    void set_file_size_mutex(util::InterprocessMutex* mutex) noexcept
+    {
+        m_file_size_mutex = mutex;
+    }
+
+    /// Truncate the file to \a room bytes beyond the logical size of the
+    /// version written by write_group(), which must be durable. The allocators
+    /// mapping the file drop the part that was cut off when they next update
+    /// their view of it (SlabAlloc::update_reader_view()). Does nothing on
+    /// Windows, where a file cannot be cut while other sessions map it.
+    void shrink_file(size_t room = 0);
+
     size_t get_file_size() const noexcept;
 
+    /// The size of the file used by the version written by write_group(),
+    /// which may be smaller than the size of the file.
+    size_t get_logical_file_size() const noexcept;
+
+    /// Whether write_group() had to extend the file on disk, rather than just
+    /// use space which was allocated ahead of time.
+    bool extended_file() const noexcept
+    {
+        return m_extended_file;
+    }
+
     ref_type write_array(const char*, size_t, uint32_t) override;
+    bool must_rewrite(ref_type) override;
 
 #ifdef REALM_DEBUG
     void dump();
@@ -100,32 +200,65 @@ private:
     size_t m_free_space_size = 0;
     size_t m_locked_space_size = 0;
     Durability m_durability;
-
-    struct FreeSpaceEntry {
-        FreeSpaceEntry(size_t r, size_t s, uint64_t v)
-            : ref(r)
-            , size(s)
-            , released_at_version(v)
-        {
-        }
-        size_t ref;
+    _impl::WriteAheadLog* m_log = nullptr;
+    util::InterprocessMutex* m_file_size_mutex = nullptr;
+    // Parts of the file written by write_group(), when there is a write-ahead log
+    std::vector<std::pair<ref_type, size_t>> m_written;
+
+    // Leaf arrays are not copied into the file by write_array(). Their space is
+    // allocated right away, but the copying is left to flush_deferred_writes(),
+    // which spreads it over several threads when a commit writes a lot of
+    // data. Only arrays without refs can be deferred, as arrays with refs are
+    // written from temporary copies.
+    //
+    // The data of a deferred array stays valid until the flush, which
+    // write_group() does right after writing the arrays of the group. Until
+    // then, nothing modifies or frees any array of the transaction. Modified
+    // arrays live in the slab, which is only reset after the commit. Arrays
+    // moved by compaction live in the read-only mappings of the allocator. Those
+    // mappings are kept for the version being written, and the file space of a
+    // moved array is only released to later commits. Growing the file for
+    // write_array() does not touch these mappings.
+    struct DeferredWrite {
+        ref_type ref;
+        const char* data;
         size_t size;
-        uint64_t released_at_version;
+        uint32_t checksum;
     };
-    class FreeList : public std::vector<FreeSpaceEntry> {
-    public:
-        FreeList() = default;
-        // Merge adjacent chunks
-        void merge_adjacent_entries_in_freelist();
-        // Copy free space entries to structure where entries are sorted by size
-        void move_free_in_file_to_size_map(std::multimap<size_t, size_t>& size_map);
-    };
-    //  m_free_in_file;
-    std::vector<FreeSpaceEntry> m_not_free_in_file;
-    std::multimap<size_t, size_t> m_size_map;
+    std::vector<DeferredWrite> m_deferred_writes;
+    size_t m_deferred_size = 0;
+    bool m_defer_writes;
+
+    std::unique_ptr<_impl::FreeSpaceState> m_free_space;
     using FreeListElement = std::multimap<size_t, size_t>::iterator;
 
+    // Use the free lists kept from the previous commit if they are those of
+    // the version this commit is based on, otherwise read them from the file
     void read_in_freelist();
+    // Make the chunks released before the oldest version still in use available
+    void release_locked_chunks();
+    // Merge a free chunk, which is not in the size map, with its free
+    // neighbours, and add the result to the size map
+    void merge_free_chunk(std::map<size_t, _impl::FreeSpaceState::Chunk>::iterator);
+    void erase_from_size_map(size_t pos, size_t size);
+
+    bool m_extended_file = false;
+
+    size_t m_compaction_budget = 0;
+    // Arrays at or beyond this position are moved, and space is not allocated
+    // beyond it if it can be avoided. Zero when not compacting.
+    size_t m_compaction_boundary = 0;
+    // Unmodified arrays to be written by this commit: those that are moved,
+    // and the arrays above them
+    std::set<ref_type> m_rewrite;
+    std::vector<size_t> m_scan_path;
+    bool m_scan_stopped = false;
+
+    // Truncate the free space at the end of the file and decide whether to
+    // compact
+    void prepare_compaction();
+    void find_arrays_to_move();
+    bool find_arrays_to_move(ref_type, bool resume, size_t& budget);
     size_t recreate_freelist(size_t reserve_pos);
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
@@ -144,6 +277,23 @@ private:
     // Sync all cached memory mappings
     void sync_all_mappings();
 
+    // Lock the mutex passed to set_file_size_mutex(), if any
+    std::unique_lock<util::InterprocessMutex> lock_file_size();
+
+    // Mappings are not synced when durability is not required, or when the changes go to the write-ahead log
+    bool syncs_mappings() const noexcept
+    {
+        return m_durability != Durability::Unsafe && !m_log;
+    }
+
+    void note_written(ref_type ref, size_t size);
+
+    // Commits copying less than this into the file use a single thread
+    static constexpr size_t parallel_write_threshold = 4 * 1024 * 1024;
+    static constexpr unsigned max_write_threads = 4;
+
+    void flush_deferred_writes();
+
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
     /// required. The returned chunk is removed from the amount of
@@ -171,7 +321,9 @@ private:
     /// Search only a range of the free list for a block as big as the
     /// specified size. Return a pair with index and size of the found chunk.
     /// \param found indicates whether a suitable block was found.
-    FreeListElement search_free_space_in_part_of_freelist(size_t size);
+    /// When compacting, chunks beyond the compaction boundary are only
+    /// considered if \a anywhere is true.
+    FreeListElement search_free_space_in_part_of_freelist(size_t size, bool anywhere);
 
     /// Extend the file to ensure that a chunk of free space of the
     /// specified size is available. The specified size does not need
@@ -80,6 +80,7 @@ public:
     // void update_early_from_top_ref(version_type, size_t, ref_type) override;
     // void update_from_parent(version_type) override;
     void get_changesets(version_type, version_type, BinaryIterator*) const noexcept override;
+    bool has_changesets(version_type, version_type) const noexcept override;
     void set_oldest_bound_version(version_type) override;
 
     void verify() const override;
@@ -150,6 +151,12 @@ void InRealmHistory::get_changesets(version_type begin_version, version_type end
 }
 
 
+bool InRealmHistory::has_changesets(version_type begin_version, version_type end_version) const noexcept
+{
+    return begin_version <= end_version && begin_version >= m_base_version && end_version <= m_base_version + m_size;
+}
+
+
 void InRealmHistory::set_oldest_bound_version(version_type version)
 {
     REALM_ASSERT(version >= m_base_version);
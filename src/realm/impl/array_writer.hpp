@@ -36,6 +36,14 @@ public:
     /// Returns the ref (position in the target stream) of the written copy of
     /// the specified array data.
     virtual ref_type write_array(const char* data, size_t size, uint32_t checksum) = 0;
+
+    /// Returns true if the specified array must be written even though it
+    /// has not been modified, as when it is moved to another part of the
+    /// file.
+    virtual bool must_rewrite(ref_type)
+    {
+        return false;
+    }
 };
 
 } // namespace impl_
@@ -78,6 +78,16 @@ public:
     virtual void get_changesets(version_type begin_version, version_type end_version, BinaryIterator* buffer) const
         noexcept = 0;
 
+    /// Returns true if get_changesets() can be called for the specified
+    /// versions, i.e. if the changesets have not yet been trimmed off the
+    /// history. Implementations that cannot tell return false.
+    virtual bool has_changesets(version_type begin_version, version_type end_version) const noexcept
+    {
+        static_cast<void>(begin_version);
+        static_cast<void>(end_version);
+        return false;
+    }
+
     /// \brief Specify the version of the oldest bound snapshot.
     ///
     /// This function must be called by the associated SharedGroup object during
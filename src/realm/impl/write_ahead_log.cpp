@@ -0,0 +1,170 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <cstring>
+#include <stdexcept>
+
+#include <realm/impl/write_ahead_log.hpp>
+#include <realm/disable_sync_to_disk.hpp>
+#include <realm/impl/simulated_failure.hpp>
+#include <realm/string_data.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+
+const uint32_t g_record_magic = 0x4c415752; // "RWAL"
+
+struct Change {
+    uint64_t ref;
+    uint64_t size;
+};
+
+size_t aligned(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+uint64_t checksum(const char* data, size_t size)
+{
+    return murmur2_or_cityhash(reinterpret_cast<const unsigned char*>(data), size);
+}
+
+} // anonymous namespace
+
+// The checksum covers everything after it, including the changes following the header
+struct WriteAheadLog::RecordHeader {
+    uint64_t checksum;
+    uint64_t changes_size;
+    uint64_t version;
+    uint64_t top_ref;
+    uint64_t file_size;
+    uint32_t file_format_version;
+    uint32_t magic;
+};
+
+WriteAheadLog::WriteAheadLog(const std::string& path)
+{
+    m_file.open(path, util::File::access_ReadWrite, util::File::create_Auto, 0); // Throws
+}
+
+void WriteAheadLog::add(ref_type ref, const char* data, size_t size)
+{
+    if (m_buffer.empty())
+        m_buffer.resize(sizeof(RecordHeader));
+    size_t pos = m_buffer.size();
+    m_buffer.resize(pos + sizeof(Change) + aligned(size)); // Throws
+    Change change{ref, size};
+    memcpy(m_buffer.data() + pos, &change, sizeof(Change));
+    memcpy(m_buffer.data() + pos + sizeof(Change), data, size);
+}
+
+void WriteAheadLog::commit(uint64_t version, ref_type top_ref, uint64_t file_size, int file_format_version)
+{
+    if (m_buffer.empty())
+        m_buffer.resize(sizeof(RecordHeader));
+    RecordHeader header;
+    header.changes_size = m_buffer.size() - sizeof(RecordHeader);
+    header.version = version;
+    header.top_ref = top_ref;
+    header.file_size = file_size;
+    header.file_format_version = uint32_t(file_format_version);
+    header.magic = g_record_magic;
+    memcpy(m_buffer.data(), &header, sizeof(RecordHeader));
+    header.checksum = checksum(m_buffer.data() + sizeof(uint64_t), m_buffer.size() - sizeof(uint64_t));
+    memcpy(m_buffer.data(), &header.checksum, sizeof(uint64_t));
+
+    if (m_unusable)
+        throw std::runtime_error("Write-ahead log is unusable after a failed commit");
+    // A record which is not completely written would hide every record appended after it from replay(), so it is
+    // cut off again if the commit fails
+    util::File::SizeType log_size = m_file.get_size(); // Throws
+    try {
+        m_file.seek(log_size);                          // Throws
+        m_file.write(m_buffer.data(), m_buffer.size()); // Throws
+        SimulatedFailure::trigger(SimulatedFailure::write_ahead_log__sync); // Throws
+        if (!get_disable_sync_to_disk())
+            m_file.sync(); // Throws
+    }
+    catch (...) {
+        m_buffer.clear();
+        try {
+            m_file.resize(log_size); // Throws
+        }
+        catch (...) {
+            // Until reset() empties the log, nothing can be appended after the partial record
+            m_unusable = true;
+        }
+        throw;
+    }
+    m_buffer.clear();
+}
+
+void WriteAheadLog::discard() noexcept
+{
+    m_buffer.clear();
+}
+
+size_t WriteAheadLog::replay(const std::function<void(const Record&)>& handler)
+{
+    uint64_t log_size = size();
+    uint64_t pos = 0;
+    size_t count = 0;
+    std::vector<char> buffer;
+    m_file.seek(0);
+    while (log_size - pos >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        m_file.read(reinterpret_cast<char*>(&header), sizeof(RecordHeader)); // Throws
+        if (header.magic != g_record_magic || header.changes_size > log_size - pos - sizeof(RecordHeader))
+            break;
+        size_t record_size = sizeof(RecordHeader) + size_t(header.changes_size);
+        buffer.resize(record_size); // Throws
+        memcpy(buffer.data(), &header, sizeof(RecordHeader));
+        m_file.read(buffer.data() + sizeof(RecordHeader), size_t(header.changes_size)); // Throws
+        if (checksum(buffer.data() + sizeof(uint64_t), record_size - sizeof(uint64_t)) != header.checksum)
+            break;
+
+        Record record;
+        record.version = header.version;
+        record.top_ref = ref_type(header.top_ref);
+        record.file_size = header.file_size;
+        record.file_format_version = int(header.file_format_version);
+        size_t offset = sizeof(RecordHeader);
+        while (offset < record_size) {
+            Change change;
+            memcpy(&change, buffer.data() + offset, sizeof(Change));
+            offset += sizeof(Change);
+            record.changes.emplace_back(ref_type(change.ref), BinaryData(buffer.data() + offset, size_t(change.size)));
+            offset += aligned(size_t(change.size));
+        }
+        handler(record); // Throws
+        pos += record_size;
+        ++count;
+    }
+    return count;
+}
+
+void WriteAheadLog::reset()
+{
+    m_buffer.clear();
+    m_file.resize(0); // Throws
+    if (!get_disable_sync_to_disk())
+        m_file.sync(); // Throws
+    m_unusable = false;
+}
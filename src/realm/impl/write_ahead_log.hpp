@@ -0,0 +1,94 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_WRITE_AHEAD_LOG_HPP
+#define REALM_IMPL_WRITE_AHEAD_LOG_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <realm/alloc.hpp>
+#include <realm/binary_data.hpp>
+#include <realm/util/file.hpp>
+
+namespace realm {
+namespace _impl {
+
+/// The write-ahead log holds the parts of the database file written by the
+/// commits made since the file was last synced. Each commit appends one record
+/// with the data it wrote and syncs the log only, which is a single sequential
+/// write, instead of syncing every part of the database file it touched.
+///
+/// The log is emptied by a checkpoint, once the database file has been synced
+/// and its header points to the latest version. If the process crashes before
+/// that, the records are written to the database file again by the next
+/// session. A record which was not completely written is detected by its
+/// checksum, and it and all records after it are ignored.
+class WriteAheadLog {
+public:
+    struct Record {
+        uint64_t version;
+        ref_type top_ref;
+        uint64_t file_size;
+        int file_format_version;
+        // The data of the record and the position in the database file it was written to
+        std::vector<std::pair<ref_type, BinaryData>> changes;
+    };
+
+    /// Open the log at \a path, creating it if it does not exist.
+    explicit WriteAheadLog(const std::string& path);
+
+    /// Add data written by the current commit at position \a ref in the
+    /// database file to the next record.
+    void add(ref_type ref, const char* data, size_t size);
+
+    /// Append the record made of the data added since the last call, and sync
+    /// the log. If this fails, the data is dropped and the log is cut back to
+    /// its previous size. If even that fails, every commit fails until the log
+    /// is emptied by reset().
+    void commit(uint64_t version, ref_type top_ref, uint64_t file_size, int file_format_version);
+
+    /// Drop the data added since the last commit.
+    void discard() noexcept;
+
+    /// Call \a handler for each complete record in the log, in the order they
+    /// were committed. Returns the number of records.
+    size_t replay(const std::function<void(const Record&)>& handler);
+
+    /// Remove all records.
+    void reset();
+
+    uint64_t size() const
+    {
+        return uint64_t(m_file.get_size());
+    }
+
+private:
+    struct RecordHeader;
+
+    util::File m_file;
+    std::vector<char> m_buffer;
+    bool m_unusable = false;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_WRITE_AHEAD_LOG_HPP
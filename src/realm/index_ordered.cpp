@@ -0,0 +1,331 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/index_ordered.hpp>
+#include <realm/array_basic.hpp>
+#include <realm/array_timestamp.hpp>
+#include <realm/null.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace realm;
+
+namespace {
+
+// Nullable types are used for all columns, so that the same index can be used regardless of nullability
+template <class T>
+T from_mixed(Mixed value);
+
+template <>
+util::Optional<int64_t> from_mixed(Mixed value)
+{
+    return value.is_null() ? util::Optional<int64_t>() : util::Optional<int64_t>(value.get<int64_t>());
+}
+
+template <>
+util::Optional<float> from_mixed(Mixed value)
+{
+    return value.is_null() ? util::Optional<float>() : util::Optional<float>(value.get<float>());
+}
+
+template <>
+util::Optional<double> from_mixed(Mixed value)
+{
+    return value.is_null() ? util::Optional<double>() : util::Optional<double>(value.get<double>());
+}
+
+template <>
+Timestamp from_mixed(Mixed value)
+{
+    return value.is_null() ? Timestamp() : value.get<Timestamp>();
+}
+
+// Float and double nulls may be passed in as the special NaN value representing null in the columns
+Mixed normalize(Mixed value)
+{
+    if (value.is_null())
+        return value;
+    switch (value.get_type()) {
+        case type_Float:
+            return null::is_null_float(value.get<float>()) ? Mixed() : value;
+        case type_Double:
+            return null::is_null_float(value.get<double>()) ? Mixed() : value;
+        default:
+            return value;
+    }
+}
+
+template <class T>
+class OrderedIndexImpl : public OrderedIndex {
+public:
+    OrderedIndexImpl(Allocator& alloc)
+        : OrderedIndex(alloc)
+        , m_values(alloc)
+    {
+        m_values.set_parent(&m_top, s_values_ndx);
+    }
+
+    Mixed get_value(size_t ndx) const override
+    {
+        return Mixed(m_values.get(ndx));
+    }
+
+private:
+    BPlusTree<T> m_values;
+
+    BPlusTreeBase& values() noexcept override
+    {
+        return m_values;
+    }
+
+    size_t partition_point(util::FunctionRef<bool(Mixed, size_t)> before) const override
+    {
+        return m_values.partition_point([&](const T& value, size_t ndx) {
+            return before(Mixed(value), ndx);
+        });
+    }
+
+    size_t values_size() const noexcept override
+    {
+        return m_values.size();
+    }
+
+    void insert_value(size_t ndx, Mixed value) override
+    {
+        m_values.insert(ndx, from_mixed<T>(value));
+    }
+
+    void erase_value(size_t ndx) override
+    {
+        m_values.erase(ndx);
+    }
+
+    void clear_values() override
+    {
+        m_values.clear();
+    }
+};
+
+} // anonymous namespace
+
+OrderedIndex::OrderedIndex(Allocator& alloc)
+    : m_top(alloc)
+    , m_keys(alloc)
+{
+    m_keys.set_parent(&m_top, s_keys_ndx);
+}
+
+OrderedIndex::~OrderedIndex() noexcept
+{
+}
+
+bool OrderedIndex::type_supported(DataType type) noexcept
+{
+    return type == type_Int || type == type_Float || type == type_Double || type == type_Timestamp;
+}
+
+std::unique_ptr<OrderedIndex> OrderedIndex::make_accessor(DataType type, Allocator& alloc)
+{
+    switch (type) {
+        case type_Int:
+            return std::make_unique<OrderedIndexImpl<util::Optional<int64_t>>>(alloc);
+        case type_Float:
+            return std::make_unique<OrderedIndexImpl<util::Optional<float>>>(alloc);
+        case type_Double:
+            return std::make_unique<OrderedIndexImpl<util::Optional<double>>>(alloc);
+        case type_Timestamp:
+            return std::make_unique<OrderedIndexImpl<Timestamp>>(alloc);
+        default:
+            break;
+    }
+    REALM_UNREACHABLE();
+}
+
+std::unique_ptr<OrderedIndex> OrderedIndex::create(DataType type, Allocator& alloc)
+{
+    auto index = make_accessor(type, alloc);
+    index->create(); // Throws
+    return index;
+}
+
+std::unique_ptr<OrderedIndex> OrderedIndex::create(DataType type, ref_type ref, ArrayParent* parent,
+                                                   size_t ndx_in_parent, Allocator& alloc)
+{
+    auto index = make_accessor(type, alloc);
+    index->set_parent(parent, ndx_in_parent);
+    index->init_from_ref(ref);
+    return index;
+}
+
+void OrderedIndex::create()
+{
+    m_top.create(Array::type_HasRefs, false, 2, 0); // Throws
+    values().create();                              // Throws
+    m_keys.create();                                // Throws
+}
+
+void OrderedIndex::init_from_ref(ref_type ref)
+{
+    m_top.init_from_ref(ref);
+    values().init_from_parent();
+    m_keys.init_from_parent();
+}
+
+void OrderedIndex::update_from_parent(size_t old_baseline) noexcept
+{
+    if (m_top.update_from_parent(old_baseline)) {
+        values().update_from_parent(old_baseline);
+        m_keys.update_from_parent(old_baseline);
+    }
+}
+
+void OrderedIndex::destroy() noexcept
+{
+    m_top.destroy_deep();
+}
+
+size_t OrderedIndex::find_position(Mixed value, ObjKey key) const
+{
+    return partition_point([&](Mixed v, size_t ndx) {
+        int c = v.compare(value);
+        return c < 0 || (c == 0 && get_key(ndx) < key);
+    });
+}
+
+size_t OrderedIndex::lower_bound(Mixed value) const
+{
+    value = normalize(value);
+    return partition_point([&](Mixed v, size_t) {
+        return v.compare(value) < 0;
+    });
+}
+
+size_t OrderedIndex::upper_bound(Mixed value) const
+{
+    value = normalize(value);
+    return partition_point([&](Mixed v, size_t) {
+        return v.compare(value) <= 0;
+    });
+}
+
+size_t OrderedIndex::begin_of_numbers(Mixed value) const
+{
+    // NaNs are ordered after the nulls and before all numbers, but as in queries, they are not less than anything
+    switch (value.get_type()) {
+        case type_Float:
+            return lower_bound(Mixed(-std::numeric_limits<float>::infinity()));
+        case type_Double:
+            return lower_bound(Mixed(-std::numeric_limits<double>::infinity()));
+        default:
+            return upper_bound(Mixed());
+    }
+}
+
+std::pair<size_t, size_t> OrderedIndex::find_range(Relation relation, Mixed value) const
+{
+    value = normalize(value);
+    if (value.is_null()) {
+        if (relation == Relation::equal)
+            return {0, upper_bound(value)};
+        return {0, 0};
+    }
+
+    switch (relation) {
+        case Relation::equal:
+            return {lower_bound(value), upper_bound(value)};
+        case Relation::greater:
+            return {upper_bound(value), size()};
+        case Relation::greater_equal:
+            return {lower_bound(value), size()};
+        case Relation::less:
+            return {begin_of_numbers(value), lower_bound(value)};
+        case Relation::less_equal:
+            return {begin_of_numbers(value), upper_bound(value)};
+    }
+    REALM_UNREACHABLE();
+}
+
+void OrderedIndex::get_keys(size_t begin, size_t end, std::vector<ObjKey>& keys) const
+{
+    REALM_ASSERT(begin <= end && end <= size());
+    keys.reserve(keys.size() + (end - begin));
+    for (size_t i = begin; i < end; i++) {
+        keys.push_back(get_key(i));
+    }
+}
+
+void OrderedIndex::build(std::vector<std::pair<Mixed, ObjKey>>& entries)
+{
+    REALM_ASSERT(size() == 0);
+    for (auto& entry : entries)
+        entry.first = normalize(entry.first);
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        int c = a.first.compare(b.first);
+        return c < 0 || (c == 0 && a.second < b.second);
+    });
+    for (auto& entry : entries) {
+        insert_value(size(), entry.first); // Throws
+        m_keys.add(entry.second.value);    // Throws
+    }
+}
+
+void OrderedIndex::insert(ObjKey key, Mixed value)
+{
+    value = normalize(value);
+    size_t ndx = find_position(value, key);
+    insert_value(ndx, value); // Throws
+    m_keys.insert(ndx, key.value); // Throws
+}
+
+void OrderedIndex::erase(ObjKey key, Mixed value)
+{
+    value = normalize(value);
+    size_t ndx = find_position(value, key);
+    REALM_ASSERT(ndx < size() && get_key(ndx) == key);
+    erase_value(ndx);
+    m_keys.erase(ndx);
+}
+
+void OrderedIndex::set(ObjKey key, Mixed old_value, Mixed new_value)
+{
+    old_value = normalize(old_value);
+    new_value = normalize(new_value);
+    if (old_value.compare(new_value) == 0)
+        return;
+    erase(key, old_value);
+    insert(key, new_value); // Throws
+}
+
+void OrderedIndex::clear()
+{
+    clear_values();
+    m_keys.clear();
+}
+
+void OrderedIndex::verify() const
+{
+#ifdef REALM_DEBUG
+    size_t sz = size();
+    REALM_ASSERT(values_size() == sz);
+    for (size_t i = 1; i < sz; i++) {
+        int c = get_value(i - 1).compare(get_value(i));
+        REALM_ASSERT(c < 0 || (c == 0 && get_key(i - 1) < get_key(i)));
+    }
+#endif
+}
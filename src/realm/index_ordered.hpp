@@ -0,0 +1,137 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_INDEX_ORDERED_HPP
+#define REALM_INDEX_ORDERED_HPP
+
+#include <memory>
+#include <vector>
+
+#include <realm/array_integer.hpp>
+#include <realm/bplustree.hpp>
+#include <realm/keys.hpp>
+#include <realm/mixed.hpp>
+
+/*
+The OrderedIndex keeps the values of a column sorted, together with the keys of the objects holding them. It is
+made of two B+ trees of equal size: one with the values and one with the object keys. Entries are ordered by
+value, nulls first, and entries with equal values are ordered by key. This is exactly the order a stable ascending
+sort of the table on the column would produce.
+
+As opposed to the StringIndex, which can only look up a single value, the ordered index can find all objects
+where the value is within a range using two binary searches, and it can hand out the objects of a table in sorted
+order without comparing any values.
+
+The B+ trees are indexed by position, and their inner nodes hold no values to descend by. A binary search
+therefore descends the trees by position, O(log(n / leaf size)) times, and does the rest of its comparisons on
+the last leaf it reached (see BPlusTree::partition_point()). With the usual depth of two or three levels, a lookup
+visits O(log n) nodes.
+
+The index is supported for Int, Float, Double and Timestamp columns.
+*/
+
+namespace realm {
+
+class OrderedIndex {
+public:
+    // The relation between the values of a range and the value it is looked up by
+    enum class Relation { equal, greater, greater_equal, less, less_equal };
+
+    virtual ~OrderedIndex() noexcept;
+
+    static bool type_supported(DataType type) noexcept;
+
+    // Create a new, empty index for a column of type `type`
+    static std::unique_ptr<OrderedIndex> create(DataType type, Allocator& alloc);
+    // Create an accessor for the existing index at `ref`
+    static std::unique_ptr<OrderedIndex> create(DataType type, ref_type ref, ArrayParent* parent,
+                                                size_t ndx_in_parent, Allocator& alloc);
+
+    ref_type get_ref() const noexcept
+    {
+        return m_top.get_ref();
+    }
+    void set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept
+    {
+        m_top.set_parent(parent, ndx_in_parent);
+    }
+    void update_from_parent(size_t old_baseline) noexcept;
+    void destroy() noexcept;
+
+    size_t size() const noexcept
+    {
+        return m_keys.size();
+    }
+    ObjKey get_key(size_t ndx) const
+    {
+        return ObjKey(m_keys.get(ndx));
+    }
+    virtual Mixed get_value(size_t ndx) const = 0;
+
+    // Fill the empty index with `entries`, sorting them first and appending them to the trees in order
+    void build(std::vector<std::pair<Mixed, ObjKey>>& entries);
+    void insert(ObjKey key, Mixed value);
+    void erase(ObjKey key, Mixed value);
+    void set(ObjKey key, Mixed old_value, Mixed new_value);
+    void clear();
+
+    // Position of the first entry with a value not less than `value`
+    size_t lower_bound(Mixed value) const;
+    // Position of the first entry with a value greater than `value`
+    size_t upper_bound(Mixed value) const;
+    // Get the positions [first, second) of the entries with a value that relates to `value` as given by
+    // `relation`. As in queries, null values are only found when looking for values equal to null, and NaN values
+    // are not less than any value.
+    std::pair<size_t, size_t> find_range(Relation relation, Mixed value) const;
+    // Append the keys of the entries at positions [begin, end) to `keys`
+    void get_keys(size_t begin, size_t end, std::vector<ObjKey>& keys) const;
+
+    void verify() const;
+
+protected:
+    OrderedIndex(Allocator& alloc);
+
+    static constexpr size_t s_values_ndx = 0;
+    static constexpr size_t s_keys_ndx = 1;
+
+    Array m_top;
+    BPlusTree<int64_t> m_keys;
+
+    void create();
+    void init_from_ref(ref_type ref);
+
+private:
+    static std::unique_ptr<OrderedIndex> make_accessor(DataType type, Allocator& alloc);
+
+    virtual BPlusTreeBase& values() noexcept = 0;
+    // Position of the first entry for which `before` returns false, see BPlusTree::partition_point()
+    virtual size_t partition_point(util::FunctionRef<bool(Mixed, size_t)> before) const = 0;
+    virtual size_t values_size() const noexcept = 0;
+    virtual void insert_value(size_t ndx, Mixed value) = 0;
+    virtual void erase_value(size_t ndx) = 0;
+    virtual void clear_values() = 0;
+
+    // Position of the first entry not less than (value, key)
+    size_t find_position(Mixed value, ObjKey key) const;
+    // Position of the first entry that is neither null nor NaN, for an index holding values of the type of `value`
+    size_t begin_of_numbers(Mixed value) const;
+};
+
+} // namespace realm
+
+#endif // REALM_INDEX_ORDERED_HPP
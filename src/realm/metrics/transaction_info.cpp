@@ -92,14 +92,21 @@ size_t TransactionInfo::get_num_decrypted_pages() const
     return m_num_decrypted_pages;
 }
 
+const EncryptedFileStats& TransactionInfo::get_encrypted_file_stats() const
+{
+    return m_encrypted_file_stats;
+}
+
 void TransactionInfo::update_stats(size_t disk_size, size_t free_space, size_t total_objects,
-                                   size_t available_versions, size_t num_decrypted_pages)
+                                   size_t available_versions, size_t num_decrypted_pages,
+                                   const EncryptedFileStats& encrypted_file_stats)
 {
     m_realm_disk_size = disk_size;
     m_realm_free_space = free_space;
     m_total_objects = total_objects;
     m_num_versions = available_versions;
     m_num_decrypted_pages = num_decrypted_pages;
+    m_encrypted_file_stats = encrypted_file_stats;
 }
 
 void TransactionInfo::finish_timer()
@@ -30,6 +30,15 @@ namespace metrics {
 
 class Metrics;
 
+// The decrypted pages of the Realm file, all 0 if the file is not encrypted.
+// The counters are totals since the file was opened.
+struct EncryptedFileStats {
+    size_t page_hits = 0;        // pages found already decrypted
+    size_t page_decryptions = 0; // pages decrypted
+    size_t page_evictions = 0;   // decrypted pages released again
+    size_t decrypted_size = 0;   // memory used by the decrypted pages, in bytes
+};
+
 class TransactionInfo {
 public:
     enum TransactionType { read_transaction, write_transaction };
@@ -47,6 +56,7 @@ public:
     size_t get_total_objects() const;
     size_t get_num_available_versions() const;
     size_t get_num_decrypted_pages() const;
+    const EncryptedFileStats& get_encrypted_file_stats() const;
 
 private:
     MetricTimerResult m_transaction_time;
@@ -60,10 +70,11 @@ private:
     TransactionType m_type;
     size_t m_num_versions;
     size_t m_num_decrypted_pages;
+    EncryptedFileStats m_encrypted_file_stats;
 
     friend class Metrics;
     void update_stats(size_t disk_size, size_t free_space, size_t total_objects, size_t available_versions,
-                      size_t num_decrypted_pages);
+                      size_t num_decrypted_pages, const EncryptedFileStats& encrypted_file_stats);
     void finish_timer();
 };
 
@@ -806,6 +806,9 @@ Obj& Obj::set<int64_t>(ColKey col_key, int64_t value, bool is_default)
     if (StringIndex* index = m_table->get_search_index(col_key)) {
         index->set<int64_t>(m_key, value);
     }
+    if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+        index->set(m_key, get_any(col_key), Mixed(value));
+    }
 
     Allocator& alloc = get_alloc();
     alloc.bump_content_version();
@@ -864,6 +867,9 @@ Obj& Obj::add_int(ColKey col_key, int64_t value)
             if (StringIndex* index = m_table->get_search_index(col_key)) {
                 index->set<int64_t>(m_key, new_val);
             }
+            if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+                index->set(m_key, Mixed(*old), Mixed(new_val));
+            }
             values.set(m_row_ndx, new_val);
         }
         else {
@@ -879,6 +885,9 @@ Obj& Obj::add_int(ColKey col_key, int64_t value)
         if (StringIndex* index = m_table->get_search_index(col_key)) {
             index->set<int64_t>(m_key, new_val);
         }
+        if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+            index->set(m_key, Mixed(old), Mixed(new_val));
+        }
         values.set(m_row_ndx, new_val);
     }
 
@@ -986,6 +995,9 @@ Obj& Obj::set(ColKey col_key, T value, bool is_default)
     if (StringIndex* index = m_table->get_search_index(col_key)) {
         index->set<T>(m_key, value);
     }
+    if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+        index->set(m_key, get_any(col_key), Mixed(value));
+    }
 
     Allocator& alloc = get_alloc();
     alloc.bump_content_version();
@@ -1276,6 +1288,9 @@ Obj& Obj::set_null(ColKey col_key, bool is_default)
         if (StringIndex* index = m_table->get_search_index(col_key)) {
             index->set(m_key, null{});
         }
+        if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+            index->set(m_key, get_any(col_key), Mixed());
+        }
 
         switch (col_type) {
             case col_type_Int:
@@ -785,6 +785,86 @@ void apply_predicate(Query& query, const Predicate& predicate, Arguments& argume
     realm_precondition(validateMessage.empty(), validateMessage.c_str());
 }
 
+void apply_predicate(Query& query, StringData predicate, Arguments& arguments, PredicateCache& cache,
+                     parser::KeyPathMapping mapping)
+{
+    auto result = cache.parse(predicate); // Throws
+    realm_precondition(result->ordering.orderings.empty(),
+                       "Sort, distinct, limit and include clauses need a DescriptorOrdering to be applied to");
+    apply_predicate(query, result->predicate, arguments, mapping);
+}
+
+void apply_predicate(Query& query, DescriptorOrdering& ordering, StringData predicate, Arguments& arguments,
+                     PredicateCache& cache, parser::KeyPathMapping mapping)
+{
+    auto result = cache.parse(predicate); // Throws
+    apply_predicate(query, result->predicate, arguments, mapping);
+    apply_ordering(ordering, query.get_table(), result->ordering, arguments, mapping);
+}
+
+PredicateCache::PredicateCache(size_t capacity)
+    : m_capacity(capacity)
+{
+    REALM_ASSERT(capacity > 0);
+}
+
+std::shared_ptr<const ParserResult> PredicateCache::parse(StringData predicate)
+{
+    std::string key(predicate);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru_pos);
+            ++m_hits;
+            return it->second.result;
+        }
+        ++m_misses;
+    }
+
+    // Parse without holding the lock, so that other threads can use the cache meanwhile
+    auto result = std::make_shared<const ParserResult>(parser::parse(predicate)); // Throws
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        // Another thread parsed the same predicate
+        return it->second.result;
+    }
+    m_lru.push_front(key);
+    m_entries.emplace(std::move(key), Entry{result, m_lru.begin()});
+    if (m_entries.size() > m_capacity) {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+    return result;
+}
+
+size_t PredicateCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void PredicateCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+}
+
+size_t PredicateCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+size_t PredicateCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
 void apply_ordering(DescriptorOrdering& ordering, ConstTableRef target, const parser::DescriptorOrderingState& state,
                     Arguments&, parser::KeyPathMapping mapping)
 {
@@ -19,8 +19,11 @@
 #ifndef REALM_QUERY_BUILDER_HPP
 #define REALM_QUERY_BUILDER_HPP
 
-#include <string>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <realm/binary_data.hpp>
@@ -42,20 +45,70 @@ using RowExpr = BasicRowExpr<Table>;
 namespace parser {
     struct Predicate;
     struct DescriptorOrderingState;
+    struct ParserResult;
 }
 
 namespace query_builder {
 class Arguments;
+class PredicateCache;
 
 void apply_predicate(Query& query, const parser::Predicate& predicate, Arguments& arguments,
                      parser::KeyPathMapping mapping = parser::KeyPathMapping());
 
+// Parse `predicate` unless `cache` already holds it, and apply it. Arguments are only bound here, so a cached
+// predicate serves all argument values. Throws if the predicate has sort, distinct, limit or include clauses.
+void apply_predicate(Query& query, StringData predicate, Arguments& arguments, PredicateCache& cache,
+                     parser::KeyPathMapping mapping = parser::KeyPathMapping());
+// As above, and add the sort, distinct, limit and include clauses of the predicate to `ordering`
+void apply_predicate(Query& query, DescriptorOrdering& ordering, StringData predicate, Arguments& arguments,
+                     PredicateCache& cache, parser::KeyPathMapping mapping = parser::KeyPathMapping());
+
 void apply_ordering(DescriptorOrdering& ordering, ConstTableRef target, const parser::DescriptorOrderingState& state,
                     Arguments& arguments, parser::KeyPathMapping mapping = parser::KeyPathMapping());
 void apply_ordering(DescriptorOrdering& ordering, ConstTableRef target, const parser::DescriptorOrderingState& state,
                     parser::KeyPathMapping mapping = parser::KeyPathMapping());
 
 
+// Cache of parse results, for applications which run the same query shapes over and over. Entries are keyed on
+// the query string, which holds placeholders ($0, $1, ...) for the arguments. A parse result does not depend on
+// any schema, so an entry serves every table, and key paths are resolved each time it is applied. The least
+// recently used entries are evicted when the cache holds more than `capacity` entries. The cache is thread safe.
+//
+// Only the parse is saved. The query nodes built from a predicate hold the values of its arguments, and which
+// nodes are built depends on their types and on whether they are null, so a built query cannot be bound to new
+// arguments. Applying a cached predicate still resolves its key paths, builds a node for each comparison and
+// validates the query, which takes time linear in the length of the predicate and not in the size of the table.
+class PredicateCache {
+public:
+    explicit PredicateCache(size_t capacity = 256);
+
+    // Return the parse result of `predicate`, which is parsed only if it is not found in the cache. Predicates
+    // which fail to parse throw and are not cached.
+    std::shared_ptr<const parser::ParserResult> parse(StringData predicate);
+
+    size_t size() const;
+    void clear();
+
+    // Number of lookups which found the predicate in the cache and which had to parse it
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    using LruList = std::list<std::string>;
+    struct Entry {
+        std::shared_ptr<const parser::ParserResult> result;
+        LruList::iterator lru_pos;
+    };
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    // Most recently used first
+    LruList m_lru;
+    std::map<std::string, Entry> m_entries;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+};
+
 struct AnyContext
 {
     template<typename T>
@@ -25,8 +25,13 @@
 #include <realm/query_expression.hpp>
 #include <realm/table_view.hpp>
 #include <realm/table_tpl.hpp>
+#include <realm/util/worker_pool.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 
 using namespace realm;
@@ -97,7 +102,9 @@ Query::Query(const Query& source)
     : error_code(source.error_code)
     , m_groups(source.m_groups)
     , m_table(source.m_table)
+    , m_threadcount(source.m_threadcount)
 {
+    copy_plan(source);
     if (source.m_owned_source_table_view) {
         m_owned_source_table_view = source.m_owned_source_table_view->clone();
         m_source_table_view = m_owned_source_table_view.get();
@@ -121,6 +128,11 @@ Query& Query::operator=(const Query& source)
     if (this != &source) {
         m_groups = source.m_groups;
         m_table = source.m_table;
+        m_threadcount = source.m_threadcount;
+        // The plan describes the conditions replaced here
+        m_plan_costs.clear();
+        m_plan_nodes.clear();
+        copy_plan(source);
 
         if (source.m_owned_source_table_view) {
             m_owned_source_table_view = source.m_owned_source_table_view->clone();
@@ -166,6 +178,7 @@ Query::Query(const Query* source, Transaction* tr, PayloadPolicy policy)
         m_view = m_source_link_list.get();
     }
     m_groups = source->m_groups;
+    m_threadcount = source->m_threadcount;
     if (source->m_table)
         set_table(tr->import_copy_of(source->m_table));
     // otherwise: empty query.
@@ -187,6 +200,7 @@ void Query::set_table(TableRef tr)
     }
 
     m_table = tr;
+    m_plan_nodes.clear();
     if (m_table) {
         ParentNode* root = root_node();
         if (root)
@@ -863,6 +877,196 @@ Query& Query::like(ColKey column_key, StringData value, bool case_sensitive)
 }
 
 
+// Parallel traversal =========================================================================
+
+namespace {
+
+// Leaves are handed to the threads in morsels of this many consecutive leaves. Small enough to balance
+// the load between the threads, large enough to amortize the per morsel bookkeeping.
+constexpr size_t leaves_per_morsel = 4;
+
+// Queries are only split over several threads if the table has at least this many rows, as the threads then get
+// enough work to pay for their own copies of the query
+constexpr size_t min_rows_for_parallel = 10000;
+
+// Threads helping the queries run on several threads, one fewer than there are cores. They are shared by all
+// queries, and a query finding them busy with another one runs on its own thread.
+util::WorkerPool& query_workers()
+{
+    static util::WorkerPool workers(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return workers;
+}
+
+// Calls func(thread_ndx, morsel) for every morsel in [0, num_morsels) on up to num_threads threads, the
+// calling thread included. Every thread_ndx in [0, num_threads) is used by a single thread at a time, which
+// repeatedly claims the next unprocessed morsel, so a thread that is done with its current morsel takes over
+// work that would otherwise wait for a slower one. The first exception thrown on any thread stops the
+// remaining work and is rethrown on the calling thread.
+template <class F>
+void run_morsels(size_t num_threads, size_t num_morsels, F func)
+{
+    std::atomic<size_t> next_morsel(0);
+    std::exception_ptr first_exception;
+    std::mutex exception_mutex;
+
+    auto worker = [&](size_t thread_ndx) {
+        try {
+            for (size_t morsel = next_morsel++; morsel < num_morsels; morsel = next_morsel++)
+                func(thread_ndx, morsel);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (!first_exception)
+                first_exception = std::current_exception();
+            next_morsel = num_morsels;
+        }
+    };
+
+    if (num_threads < 2 || !query_workers().try_run(num_threads, worker)) // Throws
+        worker(0);
+
+    if (first_exception)
+        std::rethrow_exception(first_exception);
+}
+
+// Merging of per morsel states. Morsels are merged in key order, so for min and max the first of
+// several equal values wins, just like in a serial scan.
+template <class State>
+void merge_query_state(State& st, const State& other, std::integral_constant<Action, act_Sum>)
+{
+    st.m_state += other.m_state;
+}
+
+template <class State>
+void merge_query_state(State& st, const State& other, std::integral_constant<Action, act_Count>)
+{
+    st.m_state += other.m_state;
+}
+
+template <class State>
+void merge_query_state(State& st, const State& other, std::integral_constant<Action, act_Max>)
+{
+    if (other.m_state > st.m_state) {
+        st.m_state = other.m_state;
+        st.m_minmax_index = other.m_minmax_index;
+    }
+}
+
+template <class State>
+void merge_query_state(State& st, const State& other, std::integral_constant<Action, act_Min>)
+{
+    if (other.m_state < st.m_state) {
+        st.m_state = other.m_state;
+        st.m_minmax_index = other.m_minmax_index;
+    }
+}
+
+template <Action action, class State>
+void merge_query_state(State& st, const State& other)
+{
+    if (other.m_match_count == 0)
+        return;
+    merge_query_state(st, other, std::integral_constant<Action, action>());
+    st.m_match_count += other.m_match_count;
+}
+
+} // anonymous namespace
+
+std::vector<ParentNode*> Query::get_zone_map_nodes() const
+{
+    std::vector<ParentNode*> nodes;
+    if (ParentNode* root = root_node()) {
+        for (ParentNode* node : root->m_children) {
+            if (node->get_zone_map_column())
+                nodes.push_back(node);
+        }
+    }
+    return nodes;
+}
+
+namespace {
+
+// A subtree can only contain matches if every condition with a zone map can match within it
+bool can_match_subtree(const ClusterTree& clusters, const std::vector<ParentNode*>& zone_map_nodes, ref_type ref)
+{
+    for (ParentNode* node : zone_map_nodes) {
+        ClusterTree::ZoneMap zone;
+        if (clusters.get_zone_map(ref, node->get_zone_map_column(), zone) &&
+            (zone.empty() || !node->can_match_zone(zone)))
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool Query::traverse_matching_clusters(ClusterTree::TraverseFunction func) const
+{
+    const ClusterTree& clusters = m_table.unchecked_ptr()->m_clusters;
+    std::vector<ParentNode*> zone_map_nodes = get_zone_map_nodes();
+    if (zone_map_nodes.empty())
+        return clusters.traverse(func);
+
+    auto filter = [&](ref_type ref) { return can_match_subtree(clusters, zone_map_nodes, ref); };
+    return clusters.traverse(func, filter);
+}
+
+void Query::get_matching_leaf_positions(std::vector<ClusterTree::LeafPosition>& leaves) const
+{
+    const ClusterTree& clusters = m_table.unchecked_ptr()->m_clusters;
+    std::vector<ParentNode*> zone_map_nodes = get_zone_map_nodes();
+    if (zone_map_nodes.empty())
+        return clusters.get_leaf_positions(leaves);
+
+    auto filter = [&](ref_type ref) { return can_match_subtree(clusters, zone_map_nodes, ref); };
+    clusters.get_leaf_positions(leaves, filter);
+}
+
+bool Query::can_traverse_parallel() const
+{
+    // Frozen transactions never change, so their leaves can be read from several threads at once
+    return m_threadcount > 1 && !m_view && m_table->is_frozen() && m_table->size() >= min_rows_for_parallel;
+}
+
+size_t Query::get_morsel_count(const std::vector<ClusterTree::LeafPosition>& leaves) const
+{
+    return (leaves.size() + leaves_per_morsel - 1) / leaves_per_morsel;
+}
+
+void Query::traverse_parallel(const std::vector<ClusterTree::LeafPosition>& leaves, Action action, DataType type,
+                              bool nullable,
+                              util::FunctionRef<void(size_t morsel, ParentNode* node, const Cluster* cluster)> func) const
+{
+    size_t num_morsels = get_morsel_count(leaves);
+    size_t num_threads = std::min({size_t(m_threadcount), num_morsels, size_t(query_workers().num_threads()) + 1});
+    if (num_threads == 0)
+        return;
+
+    // The nodes keep state about the current leaf, so every thread must work on its own copy of the query. The
+    // copies take over the plan of this query, so they do not sample the table again.
+    std::vector<Query> copies(num_threads, *this);
+    for (auto& copy : copies) {
+        copy.init();
+        ParentNode* pn = copy.root_node();
+        for (size_t c = 0; c < pn->m_children.size(); c++)
+            pn->m_children[c]->aggregate_local_prepare(action, type, nullable);
+    }
+
+    const ClusterTree& clusters = m_table.unchecked_ptr()->m_clusters;
+    run_morsels(num_threads, num_morsels, [&](size_t thread_ndx, size_t morsel) {
+        ParentNode* node = copies[thread_ndx].root_node();
+        size_t end = std::min(leaves.size(), (morsel + 1) * leaves_per_morsel);
+        for (size_t i = morsel * leaves_per_morsel; i < end; ++i) {
+            clusters.visit_leaf(leaves[i], [&](const Cluster* cluster) {
+                node->set_cluster(cluster);
+                func(morsel, node, cluster);
+                // Continue
+                return false;
+            });
+        }
+    });
+}
+
 // Aggregates =================================================================================
 
 bool Query::eval_object(ConstObj& obj) const
@@ -912,24 +1116,46 @@ R Query::aggregate(ColKey column_key, size_t* resultcount, ObjKey* return_ndx) c
             }
             // no index, traverse cluster tree
             node = pn;
-            LeafType leaf(m_table.unchecked_ptr()->get_alloc());
             bool nullable = m_table->is_nullable(column_key);
 
-            for (size_t c = 0; c < node->m_children.size(); c++)
-                node->m_children[c]->aggregate_local_prepare(action, ColumnTypeTraits<T>::id, nullable);
+            if (can_traverse_parallel()) {
+                std::vector<ClusterTree::LeafPosition> leaves;
+                get_matching_leaf_positions(leaves);
+                std::vector<QueryState<ResultType>> morsel_states(get_morsel_count(leaves), st);
+
+                auto f = [column_key, &morsel_states, this](size_t morsel, ParentNode* morsel_node,
+                                                            const Cluster* cluster) {
+                    LeafType leaf(m_table.unchecked_ptr()->get_alloc());
+                    QueryState<ResultType>& morsel_st = morsel_states[morsel];
+                    cluster->init_leaf(column_key, &leaf);
+                    morsel_st.m_key_offset = cluster->get_offset();
+                    morsel_st.m_key_values = cluster->get_key_array();
+                    aggregate_internal(morsel_node, &morsel_st, 0, cluster->node_size(), &leaf);
+                };
+
+                traverse_parallel(leaves, action, ColumnTypeTraits<T>::id, nullable, f);
+                for (auto& morsel_st : morsel_states)
+                    merge_query_state<action>(st, morsel_st);
+            }
+            else {
+                LeafType leaf(m_table.unchecked_ptr()->get_alloc());
 
-            auto f = [column_key, &leaf, &node, &st, this](const Cluster* cluster) {
-                size_t e = cluster->node_size();
-                node->set_cluster(cluster);
-                cluster->init_leaf(column_key, &leaf);
-                st.m_key_offset = cluster->get_offset();
-                st.m_key_values = cluster->get_key_array();
-                aggregate_internal(node, &st, 0, e, &leaf);
-                // Continue
-                return false;
-            };
+                for (size_t c = 0; c < node->m_children.size(); c++)
+                    node->m_children[c]->aggregate_local_prepare(action, ColumnTypeTraits<T>::id, nullable);
 
-            m_table.unchecked_ptr()->traverse_clusters(f);
+                auto f = [column_key, &leaf, &node, &st, this](const Cluster* cluster) {
+                    size_t e = cluster->node_size();
+                    node->set_cluster(cluster);
+                    cluster->init_leaf(column_key, &leaf);
+                    st.m_key_offset = cluster->get_offset();
+                    st.m_key_values = cluster->get_key_array();
+                    aggregate_internal(node, &st, 0, e, &leaf);
+                    // Continue
+                    return false;
+                };
+
+                traverse_matching_clusters(f);
+            }
         }
         else {
             for (size_t t = 0; t < m_view->size(); t++) {
@@ -1260,7 +1486,7 @@ ObjKey Query::find()
             return false;
         };
 
-        m_table->traverse_clusters(f);
+        traverse_matching_clusters(f);
         return key;
     }
 }
@@ -1322,6 +1548,7 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
                 auto begin_key = (begin >= m_table->size()) ? ObjKey() : m_table->get_object(begin).get_key();
                 auto end_key = (end >= m_table->size()) ? ObjKey() : m_table->get_object(end).get_key();
                 KeyColumn* refs = ret.m_key_values;
+                ObjKey last_key;
                 node->index_based_aggregate(limit, [&](ConstObj& obj) -> bool {
                     auto key = obj.get_key();
                     if (begin_key && key < begin_key)
@@ -1329,6 +1556,10 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
                     if (end_key && !(key < end_key))
                         return false;
                     if (eval_object(obj)) {
+                        // Not every index hands out the objects in key order
+                        if (last_key && key < last_key)
+                            ret.m_in_key_order = false;
+                        last_key = key;
                         refs->add(key);
                         return true;
                     }
@@ -1339,6 +1570,34 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
                 return;
             }
             // no index on best node (and likely no index at all), descend B+-tree
+            if (begin == 0 && end == m_table->size() && limit == size_t(-1) && can_traverse_parallel()) {
+                std::vector<ClusterTree::LeafPosition> leaves;
+                get_matching_leaf_positions(leaves);
+                std::vector<std::unique_ptr<KeyColumn>> morsel_keys(get_morsel_count(leaves));
+
+                auto f = [&morsel_keys, this](size_t morsel, ParentNode* morsel_node, const Cluster* cluster) {
+                    std::unique_ptr<KeyColumn>& keys = morsel_keys[morsel];
+                    if (!keys) {
+                        keys.reset(new KeyColumn(Allocator::get_default()));
+                        keys->create();
+                    }
+                    QueryState<int64_t> st(act_FindAll, keys.get());
+                    st.m_key_offset = cluster->get_offset();
+                    st.m_key_values = cluster->get_key_array();
+                    aggregate_internal(morsel_node, &st, 0, cluster->node_size(), nullptr);
+                };
+
+                traverse_parallel(leaves, act_FindAll, type_Int, false, f);
+                for (auto& keys : morsel_keys) {
+                    if (keys) {
+                        size_t sz = keys->size();
+                        for (size_t i = 0; i < sz; i++)
+                            ret.m_key_values->add(keys->get(i));
+                        keys->destroy();
+                    }
+                }
+                return;
+            }
             node = pn;
             QueryState<int64_t> st(act_FindAll, ret.m_key_values, limit);
 
@@ -1365,7 +1624,11 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
                 return end == 0 || st.m_match_count == st.m_limit;
             };
 
-            m_table->traverse_clusters(f);
+            // Skipping parts of the table would upset the counting of rows when only a range is searched
+            if (begin == 0 && end == m_table->size())
+                traverse_matching_clusters(f);
+            else
+                m_table->traverse_clusters(f);
         }
     }
 }
@@ -1426,6 +1689,23 @@ size_t Query::do_count(size_t limit) const
             return counter;
         }
         // no index, descend down the B+-tree instead
+        if (limit == size_t(-1) && can_traverse_parallel()) {
+            std::vector<ClusterTree::LeafPosition> leaves;
+            get_matching_leaf_positions(leaves);
+            std::vector<QueryState<int64_t>> morsel_states(get_morsel_count(leaves), QueryState<int64_t>(act_Count));
+
+            auto f = [&morsel_states, this](size_t morsel, ParentNode* morsel_node, const Cluster* cluster) {
+                QueryState<int64_t>& st = morsel_states[morsel];
+                st.m_key_offset = cluster->get_offset();
+                st.m_key_values = cluster->get_key_array();
+                aggregate_internal(morsel_node, &st, 0, cluster->node_size(), nullptr);
+            };
+
+            traverse_parallel(leaves, act_Count, type_Int, false, f);
+            for (auto& st : morsel_states)
+                cnt += size_t(st.m_state);
+            return cnt;
+        }
         node = pn;
         QueryState<int64_t> st(act_Count, limit);
 
@@ -1442,7 +1722,7 @@ size_t Query::do_count(size_t limit) const
             return st.m_match_count == st.m_limit;
         };
 
-        m_table->traverse_clusters(f);
+        traverse_matching_clusters(f);
 
         cnt = size_t(st.m_state);
     }
@@ -1528,135 +1808,12 @@ size_t Query::remove()
     return rows;
 }
 
-#if REALM_MULTITHREAD_QUERY
-TableView Query::find_all_multi(size_t start, size_t end)
+Query& Query::set_threads(unsigned int threadcount)
 {
-    static_cast<void>(start);
-    static_cast<void>(end);
-
-    // Initialization
-    init();
-    ts.next_job = start;
-    ts.end_job = end;
-    ts.done_job = 0;
-    ts.count = 0;
-    ts.table = &table;
-    ts.node = first[0];
-
-    // Signal all threads to start
-    pthread_mutex_unlock(&ts.jobs_mutex);
-    pthread_cond_broadcast(&ts.jobs_cond);
-
-    // Wait until all threads have completed
-    pthread_mutex_lock(&ts.completed_mutex);
-    while (ts.done_job < ts.end_job)
-        pthread_cond_wait(&ts.completed_cond, &ts.completed_mutex);
-    pthread_mutex_lock(&ts.jobs_mutex);
-    pthread_mutex_unlock(&ts.completed_mutex);
-
-    TableView tv(*m_table);
-
-    // Sort search results because user expects ascending order
-    sort(ts.chunks.begin(), ts.chunks.end(), &Query::comp);
-    for (size_t i = 0; i < ts.chunks.size(); ++i) {
-        const size_t from = ts.chunks[i].m_root_node;
-        const size_t upto = (i == ts.chunks.size() - 1) ? size_t(-1) : ts.chunks[i + 1].m_root_node;
-        size_t first = ts.chunks[i].second;
-
-        while (first < ts.results.size() && ts.results[first] < upto && ts.results[first] >= from) {
-            tv.get_ref_column().add(ts.results[first]);
-            ++first;
-        }
-    }
-
-    return move(tv);
-}
-
-int Query::set_threads(unsigned int threadcount)
-{
-#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64)
-    pthread_win32_process_attach_np();
-#endif
-    pthread_mutex_init(&ts.result_mutex, nullptr);
-    pthread_cond_init(&ts.completed_cond, nullptr);
-    pthread_mutex_init(&ts.jobs_mutex, nullptr);
-    pthread_mutex_init(&ts.completed_mutex, nullptr);
-    pthread_cond_init(&ts.jobs_cond, nullptr);
-
-    pthread_mutex_lock(&ts.jobs_mutex);
-
-    for (size_t i = 0; i < m_threadcount; ++i)
-        pthread_detach(threads[i]);
-
-    for (size_t i = 0; i < threadcount; ++i) {
-        int r = pthread_create(&threads[i], nullptr, query_thread, (void*)&ts);
-        if (r != 0)
-            REALM_ASSERT(false); // todo
-    }
-    m_threadcount = threadcount;
-    return 0;
-}
-
-
-void* Query::query_thread(void* arg)
-{
-    static_cast<void>(arg);
-    thread_state* ts = static_cast<thread_state*>(arg);
-
-    std::vector<size_t> res;
-    std::vector<pair<size_t, size_t>> chunks;
-
-    for (;;) {
-        // Main waiting loop that waits for a query to start
-        pthread_mutex_lock(&ts->jobs_mutex);
-        while (ts->next_job == ts->end_job)
-            pthread_cond_wait(&ts->jobs_cond, &ts->jobs_mutex);
-        pthread_mutex_unlock(&ts->jobs_mutex);
-
-        for (;;) {
-            // Pick a job
-            pthread_mutex_lock(&ts->jobs_mutex);
-            if (ts->next_job == ts->end_job)
-                break;
-            const size_t chunk = min(ts->end_job - ts->next_job, thread_chunk_size);
-            const size_t mine = ts->next_job;
-            ts->next_job += chunk;
-            size_t r = mine - 1;
-            const size_t end = mine + chunk;
-
-            pthread_mutex_unlock(&ts->jobs_mutex);
-
-            // Execute job
-            for (;;) {
-                r = ts->node->find_first(r + 1, end);
-                if (r == end)
-                    break;
-                res.push_back(r);
-            }
-
-            // Append result in common queue shared by all threads.
-            pthread_mutex_lock(&ts->result_mutex);
-            ts->done_job += chunk;
-            if (res.size() > 0) {
-                ts->chunks.push_back(std::pair<size_t, size_t>(mine, ts->results.size()));
-                ts->count += res.size();
-                for (size_t i = 0; i < res.size(); i++) {
-                    ts->results.push_back(res[i]);
-                }
-                res.clear();
-            }
-            pthread_mutex_unlock(&ts->result_mutex);
-
-            // Signal main thread that we might have compleeted
-            pthread_mutex_lock(&ts->completed_mutex);
-            pthread_cond_signal(&ts->completed_cond);
-            pthread_mutex_unlock(&ts->completed_mutex);
-        }
-    }
-    return 0;
+    m_threadcount = std::max(threadcount, 1u);
+    return *this;
 }
 
-#endif // REALM_MULTITHREADQUERY
 
 std::string Query::validate()
 {
@@ -1698,7 +1855,132 @@ void Query::init() const
         root->init();
         std::vector<ParentNode*> vec;
         root->gather_children(vec);
+        plan_conditions();
+    }
+}
+
+void Query::plan_conditions() const
+{
+    ParentNode* root = root_node();
+    if (m_view || root->m_children.size() < 2)
+        return;
+
+    const Table* table = m_table.unchecked_ptr();
+    size_t num_nodes = root->m_children.size();
+
+    // The estimates hold until the table changes, as long as the conditions are the same
+    uint_fast64_t version = table->get_content_version();
+    bool same_nodes = m_plan_nodes.size() == num_nodes;
+    for (size_t c = 0; same_nodes && c < num_nodes; c++)
+        same_nodes = m_plan_nodes[c] == root->m_children[c]->m_node_id;
+    if (version != m_plan_version || !same_nodes) {
+        estimate_condition_costs();
+        m_plan_version = version;
+        m_plan_nodes.clear();
+        for (ParentNode* node : root->m_children)
+            m_plan_nodes.push_back(node->m_node_id);
+    }
+    if (m_plan_costs.empty())
+        return;
+
+    for (size_t c = 0; c < num_nodes; c++) {
+        ParentNode* node = root->m_children[c];
+        // Index based conditions keep their own statistics
+        if (node->has_search_index())
+            continue;
+        node->m_dD = m_plan_costs[c].first;
+        node->m_dT = m_plan_costs[c].second;
+    }
+
+    // Each node tests the remaining conditions in the order of its m_children, so put the ones most likely to
+    // reject a row first. m_children[0] is the node itself and must stay in front.
+    auto score_compare = [](const ParentNode* a, const ParentNode* b) { return a->cost() < b->cost(); };
+    for (ParentNode* node : root->m_children)
+        std::stable_sort(node->m_children.begin() + 1, node->m_children.end(), score_compare);
+}
+
+void Query::copy_plan(const Query& source)
+{
+    // The conditions of this query are clones of those of the source, in the same order, so the plan of the
+    // source holds for them as long as it holds for the source
+    ParentNode* node = root_node();
+    ParentNode* source_node = source.root_node();
+    std::vector<uint64_t> nodes;
+    for (uint64_t id : source.m_plan_nodes) {
+        if (!node || !source_node || source_node->m_node_id != id)
+            return;
+        nodes.push_back(node->m_node_id);
+        node = node->m_child.get();
+        source_node = source_node->m_child.get();
+    }
+    if (node || source_node)
+        return;
+    m_plan_costs = source.m_plan_costs;
+    m_plan_nodes = std::move(nodes);
+    m_plan_version = source.m_plan_version;
+}
+
+void Query::estimate_condition_costs() const
+{
+    ParentNode* root = root_node();
+    const ClusterTree& clusters = m_table.unchecked_ptr()->m_clusters;
+    m_plan_costs.clear();
+
+    // Sample the leaves holding the first and the last row and some evenly spaced rows in between. Finding
+    // each of them only descends the path to it, so the cost does not grow with the size of the table.
+    size_t num_rows = clusters.size();
+    size_t num_nodes = root->m_children.size();
+    std::vector<double> matches(num_nodes, 0.0);
+    std::vector<double> row_cost(num_nodes, 0.0);
+    double rows = 0;
+    size_t num_samples = std::min(num_rows, plan_sample_leaves);
+    ref_type last_sampled = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        size_t ndx = num_samples == 1 ? 0 : i * (num_rows - 1) / (num_samples - 1);
+        ClusterTree::LeafPosition leaf = clusters.get_leaf_position(ndx);
+        // Small tables have several samples in the same leaf
+        if (leaf.ref == last_sampled)
+            continue;
+        last_sampled = leaf.ref;
+        auto f = [&](const Cluster* cluster) {
+            size_t sz = cluster->node_size();
+            if (sz == 0)
+                return false;
+            root->set_cluster(cluster);
+            rows += sz;
+            for (size_t c = 0; c < num_nodes; c++) {
+                ParentNode* node = root->m_children[c];
+                if (node->has_search_index())
+                    continue;
+                matches[c] += node->estimate_match_ratio(plan_sample_rows) * sz;
+                row_cost[c] += node->estimate_row_cost() * sz;
+            }
+            return false;
+        };
+        clusters.visit_leaf(leaf, f);
+    }
+    if (rows == 0)
+        return;
+
+    m_plan_costs.reserve(num_nodes);
+    for (size_t c = 0; c < num_nodes; c++)
+        m_plan_costs.emplace_back(rows / (matches[c] + 1.0), row_cost[c] / rows);
+}
+
+std::string Query::get_plan_description() const
+{
+    ParentNode* root = root_node();
+    if (!root)
+        return "";
+
+    init();
+    util::serializer::SerialisationState state;
+    std::ostringstream out;
+    ParentNode* best = root->m_children[find_best_node(root)];
+    for (ParentNode* node : best->m_children) {
+        out << node->describe(state) << " (match distance " << node->m_dD << ", cost " << node->cost() << ")\n";
     }
+    return out.str();
 }
 
 size_t Query::find_internal(size_t start, size_t end) const
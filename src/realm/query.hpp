@@ -26,15 +26,9 @@
 #include <string>
 #include <vector>
 
-#define REALM_MULTITHREAD_QUERY 0
-
-#if REALM_MULTITHREAD_QUERY
-// FIXME: Use our C++ thread abstraction API since it provides a much
-// higher level of encapsulation and safety.
-#include <pthread.h>
-#endif
-
+#include <realm/cluster_tree.hpp>
 #include <realm/obj_list.hpp>
+#include <realm/query_conditions.hpp>
 #include <realm/table_ref.hpp>
 #include <realm/binary_data.hpp>
 #include <realm/timestamp.hpp>
@@ -248,12 +242,18 @@ public:
     // Deletion
     size_t remove();
 
-#if REALM_MULTITHREAD_QUERY
     // Multi-threading
-    TableView find_all_multi(size_t start = 0, size_t end = size_t(-1));
-    ConstTableView find_all_multi(size_t start = 0, size_t end = size_t(-1)) const;
-    int set_threads(unsigned int threadcount);
-#endif
+    //
+    // Allow find_all(), count() and the aggregates to split the table into ranges of
+    // leaves that are evaluated on up to `threadcount` threads (the calling thread
+    // included). This is only done for queries on frozen transactions, which may be
+    // read from several threads at once, and only when neither a restricting view,
+    // a search index nor a limit is involved, and the table has at least 10000
+    // rows. The threads are shared by all queries, one fewer than there are cores,
+    // and a query finding them busy runs on the calling thread only. Results are
+    // identical to those of a single threaded run, including the order of
+    // find_all().
+    Query& set_threads(unsigned int threadcount);
 
     ConstTableRef& get_table()
     {
@@ -278,12 +278,21 @@ public:
     std::string get_description() const;
     std::string get_description(util::serializer::SerialisationState& state) const;
 
+    // Before a scan, the conditions are ordered by a cost estimate made from a sample of the
+    // table's leaves (bit width and value range of integer leaves, match rate of a few rows).
+    // Returns one line per condition in the order they will be tested, with the estimated
+    // average distance between matches and the resulting cost.
+    std::string get_plan_description() const;
+
     bool eval_object(ConstObj& obj) const;
 
 private:
     void create();
 
     void init() const;
+    void plan_conditions() const;
+    void copy_plan(const Query& source);
+    void estimate_condition_costs() const;
     size_t find_internal(size_t start = 0, size_t end = size_t(-1)) const;
     void handle_pending_not();
     void set_table(TableRef tr);
@@ -338,6 +347,16 @@ private:
 
     void find_all(ConstTableView& tv, size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
     size_t do_count(size_t limit = size_t(-1)) const;
+
+    std::vector<ParentNode*> get_zone_map_nodes() const;
+    bool traverse_matching_clusters(ClusterTree::TraverseFunction func) const;
+    void get_matching_leaf_positions(std::vector<ClusterTree::LeafPosition>& leaves) const;
+
+    bool can_traverse_parallel() const;
+    size_t get_morsel_count(const std::vector<ClusterTree::LeafPosition>& leaves) const;
+    void traverse_parallel(const std::vector<ClusterTree::LeafPosition>& leaves, Action action, DataType type,
+                           bool nullable,
+                           util::FunctionRef<void(size_t morsel, ParentNode* node, const Cluster* cluster)> func) const;
     void delete_nodes() noexcept;
 
     bool has_conditions() const
@@ -361,6 +380,11 @@ private:
 
     std::vector<QueryGroup> m_groups;
     mutable std::vector<TableKey> m_table_keys;
+    // Match distance and row cost of each condition from the last sampling of the table, valid while the
+    // content version of the table and the conditions are the same
+    mutable std::vector<std::pair<double, double>> m_plan_costs;
+    mutable std::vector<uint64_t> m_plan_nodes; // ParentNode::m_node_id of each condition
+    mutable uint_fast64_t m_plan_version = 0;
 
     TableRef m_table;
 
@@ -373,6 +397,8 @@ private:
     LnkLstPtr m_source_link_list;                  // link lists are owned by the query.
     ConstTableView* m_source_table_view = nullptr; // table views are not refcounted, and not owned by the query.
     std::unique_ptr<ConstTableView> m_owned_source_table_view; // <--- except when indicated here
+
+    unsigned int m_threadcount = 1;
 };
 
 // Implementation:
@@ -25,6 +25,8 @@
 
 using namespace realm;
 
+std::atomic<uint64_t> ParentNode::s_next_node_id{1};
+
 ParentNode::ParentNode(const ParentNode& from)
     : m_child(from.m_child ? from.m_child->clone() : nullptr)
     , m_condition_column_name(from.m_condition_column_name)
@@ -153,6 +155,60 @@ void ParentNode::aggregate_local_prepare(Action TAction, DataType col_id, bool n
     }
 }
 
+bool ParentNode::find_in_ordered_index(OrderedIndex::Relation relation, Mixed value)
+{
+    m_index_matches.clear();
+    m_use_index_matches = false;
+
+    // Comparing with null is left to the scan
+    if (value.is_null() && relation != OrderedIndex::Relation::equal)
+        return false;
+    const OrderedIndex* index = m_table.unchecked_ptr()->get_ordered_index(m_condition_column_key);
+    if (!index)
+        return false;
+
+    auto range = index->find_range(relation, value);
+    size_t num_matches = range.second - range.first;
+    size_t num_rows = index->size();
+    if (num_matches * ordered_index_scan_factor > num_rows)
+        return false;
+
+    // The index holds the matches in value order, but they must be reported in table order
+    index->get_keys(range.first, range.second, m_index_matches);
+    std::sort(m_index_matches.begin(), m_index_matches.end());
+    m_use_index_matches = true;
+    m_dD = num_rows / (num_matches + 1.0);
+    m_dT = 0.0;
+    return true;
+}
+
+void ParentNode::aggregate_index_matches(size_t limit, Evaluator evaluator)
+{
+    for (size_t t = 0; t < m_index_matches.size() && limit > 0; ++t) {
+        auto obj = m_table->get_object(m_index_matches[t]);
+        if (evaluator(obj)) {
+            --limit;
+        }
+    }
+}
+
+double ParentNode::estimate_match_ratio(size_t sample_rows)
+{
+    size_t sz = m_cluster->node_size();
+    if (sz == 0 || sample_rows == 0)
+        return 1.0;
+
+    size_t step = std::max<size_t>(sz / sample_rows, 1);
+    size_t probes = 0;
+    size_t matches = 0;
+    for (size_t r = 0; r < sz; r += step) {
+        probes++;
+        if (find_first_local(r, r + 1) == r)
+            matches++;
+    }
+    return double(matches) / probes;
+}
+
 size_t ParentNode::aggregate_local(QueryStateBase* st, size_t start, size_t end, size_t local_limit,
                                    ArrayPayload* source_column)
 {
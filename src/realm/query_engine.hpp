@@ -85,6 +85,8 @@ AggregateState      State of the aggregate - contains a state variable that stor
 #define REALM_QUERY_ENGINE_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <sstream>
 #include <string>
@@ -134,6 +136,15 @@ const size_t probe_matches = 4;
 
 const size_t bitwidth_time_unit = 64;
 
+// Number of leaves, and number of rows within each of them, that are sampled to estimate the cost of each
+// condition before a query starts scanning.
+const size_t plan_sample_leaves = 3;
+const size_t plan_sample_rows = 16;
+
+// An ordered index is only used for a condition if it narrows the search down to at most one in this many
+// objects. Visiting the matches one by one is much more expensive per object than scanning a leaf.
+const size_t ordered_index_scan_factor = 32;
+
 typedef bool (*CallbackDummy)(int64_t);
 using Evaluator = util::FunctionRef<bool(ConstObj& obj)>;
 
@@ -170,6 +181,29 @@ public:
                m_dT; // dt = 1/64 to 1. Match dist is 8 times more important than bitwidth
     }
 
+    // Estimate the fraction of rows in the current cluster that match this condition. Used to order the
+    // conditions of a query before the scan starts. The default implementation tests up to sample_rows rows
+    // spread evenly over the cluster.
+    virtual double estimate_match_ratio(size_t sample_rows);
+
+    // Estimate the time it takes to test a row in the current cluster, in the same unit as m_dT
+    virtual double estimate_row_cost() const
+    {
+        return m_dT;
+    }
+
+    // Column with a zone map that can tell if a part of the table may contain matches for this condition
+    virtual ColKey get_zone_map_column() const
+    {
+        return ColKey();
+    }
+
+    // Return false if no row summarised by the zone map of get_zone_map_column() can match
+    virtual bool can_match_zone(const ClusterTree::ZoneMap&) const
+    {
+        return true;
+    }
+
     size_t find_first(size_t start, size_t end);
 
     bool match(ConstObj& obj);
@@ -180,6 +214,8 @@ public:
             m_child->init();
 
         m_column_action_specializer = nullptr;
+        m_index_matches.clear();
+        m_use_index_matches = false;
     }
 
     void get_link_dependencies(std::vector<TableKey>& tables) const
@@ -314,7 +350,12 @@ public:
     size_t m_probes = 0;
     size_t m_matches = 0;
 
+    // Unique among all nodes, also copies, unlike the address of a node which may be reused once it is destroyed
+    uint64_t m_node_id = s_next_node_id.fetch_add(1, std::memory_order_relaxed);
+
 protected:
+    static std::atomic<uint64_t> s_next_node_id;
+
     typedef bool (ParentNode::*Column_action_specialized)(QueryStateBase*, ArrayPayload*, size_t);
     Column_action_specialized m_column_action_specializer = nullptr;
     ConstTableRef m_table = ConstTableRef();
@@ -322,11 +363,21 @@ protected:
     QueryStateBase* m_state = nullptr;
     std::string error_code;
 
+    // Keys of the objects matching the condition, in table order, when found through an ordered index
+    std::vector<ObjKey> m_index_matches;
+    bool m_use_index_matches = false;
+
     ColumnType get_real_column_type(ColKey key)
     {
         return m_table.unchecked_ptr()->get_real_column_type(key);
     }
 
+    // Look up the objects with a value in the condition column that relates to `value` as given by `relation`
+    // in the ordered index on that column. Returns false, leaving the condition to be tested by scanning,
+    // if there is no such index or it matches too many objects to be worth it.
+    bool find_in_ordered_index(OrderedIndex::Relation relation, Mixed value);
+    void aggregate_index_matches(size_t limit, Evaluator evaluator);
+
 private:
     virtual void table_changed()
     {
@@ -368,6 +419,121 @@ struct CostHeuristic<ArrayIntNull> {
 };
 
 // FIXME: Add AdaptiveStringColumn, BasicColumn, etc.
+
+// Tell if a zone containing the non-null values zone.min to zone.max, and zone.null_count nulls, may contain a
+// value for which Cond(value, v) is true
+template <class Cond>
+inline bool zone_can_match(Cond, const ClusterTree::ZoneMap&, int64_t)
+{
+    return true;
+}
+
+inline bool zone_can_match(Equal, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.min <= v && v <= zone.max;
+}
+
+inline bool zone_can_match(NotEqual, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.null_count > 0 || zone.min != v || zone.max != v;
+}
+
+inline bool zone_can_match(Greater, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.max > v;
+}
+
+inline bool zone_can_match(GreaterEqual, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.max >= v;
+}
+
+inline bool zone_can_match(Less, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.min < v;
+}
+
+inline bool zone_can_match(LessEqual, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.min <= v;
+}
+
+// Zone maps of timestamp columns only hold the seconds, so strict comparisons must include the boundary
+inline bool zone_can_match_seconds(Greater, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.max >= v;
+}
+
+inline bool zone_can_match_seconds(Less, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone.min <= v;
+}
+
+inline bool zone_can_match_seconds(NotEqual, const ClusterTree::ZoneMap&, int64_t)
+{
+    return true;
+}
+
+template <class Cond>
+inline bool zone_can_match_seconds(Cond c, const ClusterTree::ZoneMap& zone, int64_t v)
+{
+    return zone_can_match(c, zone, v);
+}
+
+// A search for null can only match where there are nulls, and a search for anything but null only where there
+// are values
+template <class Cond>
+inline bool zone_can_match_null(Cond, const ClusterTree::ZoneMap&)
+{
+    return true;
+}
+
+inline bool zone_can_match_null(Equal, const ClusterTree::ZoneMap& zone)
+{
+    return zone.null_count > 0;
+}
+
+inline bool zone_can_match_null(NotEqual, const ClusterTree::ZoneMap& zone)
+{
+    return zone.min <= zone.max;
+}
+
+// The range of an ordered index holding the values for which Cond(value, v) is true
+template <class Cond>
+struct OrderedIndexRelation {
+    static constexpr bool supported = false;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::equal;
+};
+
+template <>
+struct OrderedIndexRelation<Equal> {
+    static constexpr bool supported = true;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::equal;
+};
+
+template <>
+struct OrderedIndexRelation<Greater> {
+    static constexpr bool supported = true;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::greater;
+};
+
+template <>
+struct OrderedIndexRelation<GreaterEqual> {
+    static constexpr bool supported = true;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::greater_equal;
+};
+
+template <>
+struct OrderedIndexRelation<Less> {
+    static constexpr bool supported = true;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::less;
+};
+
+template <>
+struct OrderedIndexRelation<LessEqual> {
+    static constexpr bool supported = true;
+    static constexpr OrderedIndex::Relation relation = OrderedIndex::Relation::less_equal;
+};
 }
 
 class ColumnNodeBase : public ParentNode {
@@ -529,6 +695,51 @@ protected:
         m_dD = _impl::CostHeuristic<LeafType>::dD();
     }
 
+    double estimate_row_cost() const override
+    {
+        // Linear scans run at a speed proportional to the bit width of the leaf
+        return std::max<size_t>(m_leaf_ptr->get_width(), 1) / double(bitwidth_time_unit);
+    }
+
+    // Use the value range of the leaf to tell if the condition matches none or all of the rows without looking
+    // at them
+    template <class TConditionFunction>
+    double estimate_match_ratio_from_bounds(size_t sample_rows)
+    {
+        int64_t value;
+        if (get_int_value(m_value, value)) {
+            TConditionFunction c;
+            if (!c.can_match(value, m_leaf_ptr->get_lower_bound(), m_leaf_ptr->get_upper_bound()))
+                return 0.0;
+            if (c.will_match(value, m_leaf_ptr->get_lower_bound(), m_leaf_ptr->get_upper_bound()))
+                return 1.0;
+        }
+        return ParentNode::estimate_match_ratio(sample_rows);
+    }
+
+    template <class TConditionFunction>
+    bool can_match_zone_impl(const ClusterTree::ZoneMap& zone) const
+    {
+        int64_t value;
+        if (!get_int_value(m_value, value))
+            return _impl::zone_can_match_null(TConditionFunction(), zone);
+        return _impl::zone_can_match(TConditionFunction(), zone, value);
+    }
+
+    static bool get_int_value(int64_t v, int64_t& out)
+    {
+        out = v;
+        return true;
+    }
+
+    static bool get_int_value(const util::Optional<int64_t>& v, int64_t& out)
+    {
+        if (!v)
+            return false;
+        out = *v;
+        return true;
+    }
+
     bool should_run_in_fastmode(ArrayPayload* source_leaf) const
     {
         if (m_children.size() > 1 || m_fastmode_disabled)
@@ -639,6 +850,25 @@ public:
     {
     }
 
+    void init() override
+    {
+        BaseType::init();
+
+        using Relation = _impl::OrderedIndexRelation<TConditionFunction>;
+        if (Relation::supported)
+            this->find_in_ordered_index(Relation::relation, Mixed(this->m_value));
+    }
+
+    bool has_search_index() const override
+    {
+        return this->m_use_index_matches;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        this->aggregate_index_matches(limit, evaluator);
+    }
+
     void aggregate_local_prepare(Action action, DataType col_id, bool is_nullable) override
     {
         this->m_fastmode_disabled = (col_id == type_Float || col_id == type_Double);
@@ -660,6 +890,21 @@ public:
         return this->m_leaf_ptr->template find_first<TConditionFunction>(this->m_value, start, end);
     }
 
+    double estimate_match_ratio(size_t sample_rows) override
+    {
+        return this->template estimate_match_ratio_from_bounds<TConditionFunction>(sample_rows);
+    }
+
+    ColKey get_zone_map_column() const override
+    {
+        return this->m_condition_column_key;
+    }
+
+    bool can_match_zone(const ClusterTree::ZoneMap& zone) const override
+    {
+        return this->template can_match_zone_impl<TConditionFunction>(zone);
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         return state.describe_column(ParentNode::m_table, ColumnNodeBase::m_condition_column_key) + " " +
@@ -706,6 +951,12 @@ public:
             m_last_start_key = ObjKey();
             IntegerNodeBase<LeafType>::m_dT = 0;
         }
+        else if (!m_nb_needles &&
+                 this->find_in_ordered_index(OrderedIndex::Relation::equal, Mixed(BaseType::m_value))) {
+            m_result = std::move(this->m_index_matches);
+            m_result_get = 0;
+            m_last_start_key = ObjKey();
+        }
     }
 
     void consume_condition(IntegerNode<LeafType, Equal>* other)
@@ -720,7 +971,8 @@ public:
 
     bool has_search_index() const override
     {
-        return this->m_table->has_search_index(IntegerNodeBase<LeafType>::m_condition_column_key);
+        return this->m_table->has_search_index(IntegerNodeBase<LeafType>::m_condition_column_key) ||
+               this->m_use_index_matches;
     }
 
     void index_based_aggregate(size_t limit, Evaluator evaluator) override
@@ -802,6 +1054,24 @@ public:
         return s;
     }
 
+    double estimate_match_ratio(size_t sample_rows) override
+    {
+        if (m_nb_needles)
+            return ParentNode::estimate_match_ratio(sample_rows);
+        return this->template estimate_match_ratio_from_bounds<Equal>(sample_rows);
+    }
+
+    ColKey get_zone_map_column() const override
+    {
+        // Conditions merged from several equality tests are not covered
+        return m_nb_needles ? ColKey() : this->m_condition_column_key;
+    }
+
+    bool can_match_zone(const ClusterTree::ZoneMap& zone) const override
+    {
+        return this->template can_match_zone_impl<Equal>(zone);
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         REALM_ASSERT(this->m_condition_column_key);
@@ -909,6 +1179,21 @@ public:
     {
         ParentNode::init();
         m_dD = 100.0;
+
+        // A NaN other than null matches no comparison, but has a place in the order of the index
+        using Relation = _impl::OrderedIndexRelation<TConditionFunction>;
+        if (Relation::supported && (!std::isnan(m_value) || null::is_null_float(m_value)))
+            find_in_ordered_index(Relation::relation, Mixed(m_value));
+    }
+
+    bool has_search_index() const override
+    {
+        return m_use_index_matches;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        aggregate_index_matches(limit, evaluator);
     }
 
     size_t find_first_local(size_t start, size_t end) override
@@ -1281,11 +1566,42 @@ class TimestampNode : public TimestampNodeBase {
 public:
     using TimestampNodeBase::TimestampNodeBase;
 
+    void init() override
+    {
+        TimestampNodeBase::init();
+
+        using Relation = _impl::OrderedIndexRelation<TConditionFunction>;
+        if (Relation::supported)
+            find_in_ordered_index(Relation::relation, Mixed(m_value));
+    }
+
+    bool has_search_index() const override
+    {
+        return m_use_index_matches;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        aggregate_index_matches(limit, evaluator);
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
         return m_leaf_ptr->find_first<TConditionFunction>(m_value, start, end);
     }
 
+    ColKey get_zone_map_column() const override
+    {
+        return m_condition_column_key;
+    }
+
+    bool can_match_zone(const ClusterTree::ZoneMap& zone) const override
+    {
+        if (m_value.is_null())
+            return _impl::zone_can_match_null(TConditionFunction(), zone);
+        return _impl::zone_can_match_seconds(TConditionFunction(), zone, m_value.get_seconds());
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         REALM_ASSERT(m_condition_column_key);
@@ -1813,6 +2129,10 @@ private:
 // will first set m_conditions[0] = left-hand-side through constructor, and then later, when .first.equal(222) is
 // invoked, invocation will set m_conditions[1] = right-hand-side through Query& Query::Or() (see query.cpp).
 // In there, m_child is also set to next AND condition (if any exists) following the OR.
+//
+// Wide ORs, like the ones generated for IN lists, are evaluated a range of rows at a time: each condition marks its
+// matches in a bitmap covering the range, and the matches are then read from the bitmap, instead of looking for the
+// nearest match among all conditions for each match.
 class OrNode : public ParentNode {
 public:
     OrNode(std::unique_ptr<ParentNode> condition)
@@ -1851,6 +2171,8 @@ public:
 
         m_was_match.clear();
         m_was_match.resize(m_conditions.size(), false);
+
+        m_bitmap_begin = m_bitmap_end = 0;
     }
 
     std::string describe(util::serializer::SerialisationState& state) const override
@@ -1883,6 +2205,21 @@ public:
 
         m_dD = 10.0;
 
+        // Nested ORs without AND conditions following them, like the ones built by Query::operator||(), are
+        // merged into this node
+        for (size_t i = 0; i < m_conditions.size();) {
+            auto nested = dynamic_cast<OrNode*>(m_conditions[i].get());
+            if (nested && nested->m_child == nullptr) {
+                auto conditions = std::move(nested->m_conditions);
+                m_conditions.erase(m_conditions.begin() + i);
+                for (auto& condition : conditions)
+                    m_conditions.emplace_back(std::move(condition));
+            }
+            else {
+                ++i;
+            }
+        }
+
         std::sort(m_conditions.begin(), m_conditions.end(),
                   [](auto& a, auto& b) { return a->m_condition_column_key < b->m_condition_column_key; });
 
@@ -1899,6 +2236,8 @@ public:
         m_was_match.clear();
         m_was_match.resize(m_conditions.size(), false);
 
+        m_bitmap_begin = m_bitmap_end = 0;
+
         std::vector<ParentNode*> v;
         for (auto& condition : m_conditions) {
             condition->init();
@@ -1912,6 +2251,16 @@ public:
         if (start >= end)
             return not_found;
 
+        if (m_conditions.size() >= s_bitmap_min_conditions) {
+            bool in_bitmap = start >= m_bitmap_begin && start < m_bitmap_end && end <= m_bitmap_end;
+            if (!in_bitmap && end - start >= s_bitmap_min_rows) {
+                fill_bitmap(start, end);
+                in_bitmap = true;
+            }
+            if (in_bitmap)
+                return find_in_bitmap(start, end);
+        }
+
         size_t index = not_found;
 
         for (size_t c = 0; c < m_conditions.size(); ++c) {
@@ -1971,6 +2320,47 @@ public:
     std::vector<std::unique_ptr<ParentNode>> m_conditions;
 
 private:
+    // Minimum number of conditions and of rows searched for using the bitmap
+    static constexpr size_t s_bitmap_min_conditions = 4;
+    static constexpr size_t s_bitmap_min_rows = 64;
+
+    // Bit `i` of the bitmap is set if row `m_bitmap_begin + i` matches any of the conditions
+    std::vector<uint64_t> m_bitmap;
+    size_t m_bitmap_begin = 0;
+    size_t m_bitmap_end = 0;
+
+    void fill_bitmap(size_t start, size_t end)
+    {
+        m_bitmap.assign((end - start + 63) / 64, 0);
+        uint64_t* bits = m_bitmap.data();
+        for (auto& condition : m_conditions) {
+            size_t s = start;
+            while ((s = condition->find_first(s, end)) != not_found) {
+                size_t i = s - start;
+                bits[i / 64] |= uint64_t(1) << (i % 64);
+                ++s;
+            }
+        }
+        m_bitmap_begin = start;
+        m_bitmap_end = end;
+    }
+
+    size_t find_in_bitmap(size_t start, size_t end) const
+    {
+        size_t i = start - m_bitmap_begin;
+        size_t n = end - m_bitmap_begin;
+        size_t word = i / 64;
+        uint64_t bits = m_bitmap[word] & (~uint64_t(0) << (i % 64));
+        size_t num_words = (n + 63) / 64;
+        while (bits == 0) {
+            if (++word == num_words)
+                return not_found;
+            bits = m_bitmap[word];
+        }
+        size_t match = word * 64 + count_trailing_zeros(bits);
+        return match < n ? m_bitmap_begin + match : not_found;
+    }
+
     template<class QueryNodeType>
     void combine_conditions() {
         QueryNodeType* first_match = nullptr;
@@ -60,7 +60,7 @@ Operator: public Subexpr2
 
 Value<T>: public Subexpr2
     void evaluate(size_t i, ValueBase* destination)
-    T m_v[8];
+    NullableVector<T> m_storage;
 
 Columns<T>: public Subexpr2
     void evaluate(size_t i, ValueBase* destination)
@@ -83,10 +83,13 @@ size_t Compare<Greater>::find_first()-------------+
                                                Value<float>::evaluate()    Columns<float>::evaluate()
 
 Operator, Value and Columns have an evaluate(size_t i, ValueBase* destination) method which returns a Value<T>
-containing 8 values representing table rows i...i + 7.
+containing up to ValueBase::chunk_size (256) values representing table rows i...i + 255.
 
-So Value<T> contains 8 concecutive values and all operations are based on these chunks. This is
+So Value<T> contains a chunk of concecutive values and all operations are based on these chunks. This is
 to save overhead by virtual calls needed for evaluating a query that has been dynamically constructed at runtime.
+Constants are held as a single value which Operator and Compare apply to every value of the chunk. Compare records
+which rows of a chunk match in a bitmap, so that the chunk is evaluated only once while the query engine asks for
+one match after the other.
 
 
 Memory allocation:
@@ -313,7 +316,7 @@ struct Common<T1, T2, true, false, b> {
 
 
 struct ValueBase {
-    static const size_t chunk_size = 8;
+    static const size_t chunk_size = 256;
     virtual void export_bool(ValueBase& destination) const = 0;
     virtual void export_Timestamp(ValueBase& destination) const = 0;
     virtual void export_int(ValueBase& destination) const = 0;
@@ -331,6 +334,10 @@ struct ValueBase {
 
     // Number of values stored in the class.
     size_t m_values;
+
+    // Upper limit on the number of rows read into this value when evaluating columns. Callers that need only a
+    // few rows, like the check of a single object, set it to avoid reading a whole chunk.
+    size_t m_max_values = chunk_size;
 };
 
 class Expression {
@@ -816,6 +823,8 @@ The query system will then construct a NullableVector of type `null` (NullableVe
 time optimizations for these cases.
 */
 
+// Chunks of up to ValueBase::chunk_size values are allocated on the heap, while single values and short chunks,
+// like the ones of constants and of link lists, fit in the preallocated space.
 template <class T, size_t prealloc = 8>
 struct NullableVector {
     using Underlying = typename util::RemoveOptional<T>::type;
@@ -1278,6 +1287,27 @@ public:
         }
     }
 
+    // Apply the operator to each of `values` and the single value of `constant`, which is the left-hand side of
+    // the operator if `constant_is_left` and the right-hand side otherwise
+    template <class TOperator>
+    REALM_FORCEINLINE void fun_const(const Value* values, const Value* constant, bool constant_is_left)
+    {
+        init(values->m_from_link_list, values->m_values);
+
+        OperatorOptionalAdapter<TOperator> o;
+        auto c = constant->m_storage.get(0);
+        if (constant_is_left) {
+            for (size_t i = 0; i < values->m_values; i++) {
+                m_storage.set(i, o(c, values->m_storage.get(i)));
+            }
+        }
+        else {
+            for (size_t i = 0; i < values->m_values; i++) {
+                m_storage.set(i, o(values->m_storage.get(i), c));
+            }
+        }
+    }
+
 
     // Below import and export methods are for type conversion between float, double, int64_t, etc.
     template <class D>
@@ -1428,6 +1458,36 @@ public:
         return not_found; // no match
     }
 
+    // Given a TCond and two Value<T> which do not come from link lists, set bit `m` of `matches` for each row `m`
+    // where the condition holds. If `left_is_const`, the single value of `left` is compared to all of `right`.
+    // Returns the number of rows compared.
+    template <class TCond>
+    REALM_FORCEINLINE static size_t compare_all(const Value<T>* left, const Value<T>* right, bool left_is_const,
+                                                uint64_t* matches)
+    {
+        TCond c;
+
+        size_t sz = left_is_const ? right->ValueBase::m_values
+                                  : minimum(left->ValueBase::m_values, right->ValueBase::m_values);
+        REALM_ASSERT_DEBUG(sz <= ValueBase::chunk_size);
+        std::fill(matches, matches + (sz + 63) / 64, 0);
+        if (left_is_const) {
+            bool left_is_null = left->m_storage.is_null(0);
+            for (size_t m = 0; m < sz; m++) {
+                uint64_t bit = c(left->m_storage[0], right->m_storage[m], left_is_null, right->m_storage.is_null(m));
+                matches[m / 64] |= bit << (m % 64);
+            }
+        }
+        else {
+            for (size_t m = 0; m < sz; m++) {
+                uint64_t bit = c(left->m_storage[m], right->m_storage[m], left->m_storage.is_null(m),
+                                 right->m_storage.is_null(m));
+                matches[m / 64] |= bit << (m % 64);
+            }
+        }
+        return sz;
+    }
+
     std::unique_ptr<Subexpr> clone() const override
     {
         return make_subexpr<Value<T>>(*this);
@@ -3190,24 +3250,23 @@ public:
             // Not a Link column
             size_t colsize = leaf->size();
 
-            // Now load `ValueBase::chunk_size` rows from from the leaf into m_storage. If it's an integer
-            // leaf, then it contains the method get_chunk() which copies these values in a super fast way (first
-            // case of the `if` below. Otherwise, copy the values one by one in a for-loop (the `else` case).
-            if (std::is_same<U, int64_t>::value && index + ValueBase::chunk_size <= colsize) {
-                Value<int64_t> v(false, ValueBase::chunk_size);
-
-                // If you want to modify 'chunk_size' then update Array::get_chunk()
-                REALM_ASSERT_3(ValueBase::chunk_size, ==, 8);
+            // Now load up to `ValueBase::chunk_size` rows from from the leaf into m_storage. If it's an integer
+            // leaf, then it contains the method get_chunk() which copies 8 values at a time in a super fast way
+            // (first case of the `if` below. Otherwise, copy the values one by one in a for-loop (the `else` case).
+            size_t rows = minimum(minimum(colsize - index, ValueBase::chunk_size), destination.m_max_values);
+            if (std::is_same<U, int64_t>::value && rows >= 8) {
+                Value<int64_t> v(false, rows);
 
                 auto leaf_2 = static_cast<const Array*>(leaf);
-                leaf_2->get_chunk(index, v.m_storage.m_first);
+                size_t t = 0;
+                for (; t + 8 <= rows; t += 8)
+                    leaf_2->get_chunk(index + t, v.m_storage.m_first + t);
+                for (; t < rows; t++)
+                    v.m_storage.m_first[t] = leaf_2->get(index + t);
 
                 destination.import(v);
             }
             else {
-                size_t rows = colsize - index;
-                if (rows > ValueBase::chunk_size)
-                    rows = ValueBase::chunk_size;
                 Value<typename util::RemoveOptional<U>::type> v(false, rows);
 
                 for (size_t t = 0; t < rows; t++)
@@ -3725,12 +3784,14 @@ public:
         : m_left(std::move(left))
         , m_right(std::move(right))
     {
+        init_constants();
     }
 
     Operator(const Operator& other)
         : m_left(other.m_left->clone())
         , m_right(other.m_right->clone())
     {
+        init_constants();
     }
 
     Operator& operator=(const Operator& other)
@@ -3738,6 +3799,7 @@ public:
         if (this != &other) {
             m_left = other.m_left->clone();
             m_right = other.m_right->clone();
+            init_constants();
         }
         return *this;
     }
@@ -3779,9 +3841,21 @@ public:
         Value<T> result;
         Value<T> left;
         Value<T> right;
-        m_left->evaluate(index, left);
-        m_right->evaluate(index, right);
-        result.template fun<oper>(&left, &right);
+        left.m_max_values = right.m_max_values = destination.m_max_values;
+        // A constant holds a single value, which would limit the result to a single row if combined value by value
+        if (m_left_is_const && !m_right_is_const) {
+            m_right->evaluate(index, right);
+            result.template fun_const<oper>(&right, &m_const_value, true);
+        }
+        else if (m_right_is_const && !m_left_is_const) {
+            m_left->evaluate(index, left);
+            result.template fun_const<oper>(&left, &m_const_value, false);
+        }
+        else {
+            m_left->evaluate(index, left);
+            m_right->evaluate(index, right);
+            result.template fun<oper>(&left, &right);
+        }
         destination.import(result);
     }
 
@@ -3807,6 +3881,17 @@ private:
     typedef typename oper::type T;
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
+    bool m_left_is_const;
+    bool m_right_is_const;
+    Value<T> m_const_value;
+
+    void init_constants()
+    {
+        m_left_is_const = m_left->has_constant_evaluation();
+        m_right_is_const = m_right->has_constant_evaluation();
+        if (m_left_is_const != m_right_is_const)
+            (m_left_is_const ? m_left : m_right)->evaluate(-1 /*unused*/, m_const_value);
+    }
 };
 
 namespace {
@@ -3852,10 +3937,14 @@ public:
             m_left->set_cluster(cluster);
             m_right->set_cluster(cluster);
         }
+        m_chunk_begin = m_chunk_end = 0;
+        m_link_list_seen = false;
     }
 
     double init() override
     {
+        m_chunk_begin = m_chunk_end = 0;
+        m_link_list_seen = false;
         double dT = m_left_is_const ? 10.0 : 50.0;
         if (std::is_same<TCond, Equal>::value && m_left_is_const && m_right->has_search_index()) {
             if (m_left_value.m_storage.is_null(0)) {
@@ -3938,27 +4027,51 @@ public:
             return m_cluster->lower_bound_key(ObjKey(actual_key.value - m_cluster->get_offset()));
         }
 
+        // The query engine asks for one match after the other, so the next match is likely to be found among the
+        // rows of the chunk evaluated by the previous call
+        if (start >= m_chunk_begin && start < m_chunk_end) {
+            size_t match = find_in_chunk(start, end);
+            if (match != not_found || end <= m_chunk_end)
+                return match;
+            start = m_chunk_end;
+        }
+
         size_t match;
 
         Value<T> left;
         Value<T> right;
 
         for (; start < end;) {
-            if (m_left_is_const) {
-                m_right->evaluate(start, right);
-                match = Value<T>::template compare_const<TCond>(&m_left_value, &right);
-            }
-            else {
+            // Don't read more rows than needed when only a few rows are checked, like when matching a single object,
+            // or when the values of a link list are checked one row at a time
+            size_t max_values = m_link_list_seen ? 1 : minimum(end - start, ValueBase::chunk_size);
+            left.m_max_values = right.m_max_values = max_values;
+            if (!m_left_is_const)
                 m_left->evaluate(start, left);
-                m_right->evaluate(start, right);
-                match = Value<T>::template compare<TCond>(&left, &right);
-            }
+            m_right->evaluate(start, right);
 
-            if (match != not_found && match + start < end)
-                return start + match;
+            if (left.m_from_link_list || right.m_from_link_list) {
+                // Values from link lists all belong to the single row `start`
+                m_link_list_seen = true;
+                if (m_left_is_const)
+                    match = Value<T>::template compare_const<TCond>(&m_left_value, &right);
+                else
+                    match = Value<T>::template compare<TCond>(&left, &right);
+
+                if (match != not_found && match + start < end)
+                    return start + match;
+                start++;
+                continue;
+            }
 
-            size_t rows =
-                (left.m_from_link_list || right.m_from_link_list) ? 1 : minimum(right.m_values, left.m_values);
+            // Compare all rows of the chunk in one go and keep the matches for the following calls
+            const Value<T>* l = m_left_is_const ? &m_left_value : &left;
+            size_t rows = Value<T>::template compare_all<TCond>(l, &right, m_left_is_const, m_chunk_matches);
+            m_chunk_begin = start;
+            m_chunk_end = start + rows;
+            match = find_in_chunk(start, end);
+            if (match != not_found)
+                return match;
             start += rows;
         }
 
@@ -3996,6 +4109,22 @@ private:
         }
     }
 
+    // First match at or after `start` and before `end` among the rows of the last chunk evaluated
+    size_t find_in_chunk(size_t start, size_t end) const
+    {
+        size_t last = minimum(end, m_chunk_end);
+        while (start < last) {
+            size_t offset = start - m_chunk_begin;
+            uint64_t bits = m_chunk_matches[offset / 64] >> (offset % 64);
+            if (bits) {
+                start += count_trailing_zeros(bits);
+                return start < last ? start : not_found;
+            }
+            start += 64 - offset % 64;
+        }
+        return not_found;
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
     const Cluster* m_cluster;
@@ -4005,6 +4134,13 @@ private:
     std::vector<ObjKey> m_matches;
     mutable size_t m_index_get = 0;
     size_t m_index_end = 0;
+    // Bit `m` is set if row `m_chunk_begin + m` matches, for the rows [m_chunk_begin, m_chunk_end) of the cluster
+    mutable uint64_t m_chunk_matches[ValueBase::chunk_size / 64];
+    mutable size_t m_chunk_begin = 0;
+    mutable size_t m_chunk_end = 0;
+    // Set once the values of a link list have been evaluated for the current cluster, after which rows are
+    // evaluated one at a time
+    mutable bool m_link_list_seen = false;
 };
 }
 #endif // REALM_QUERY_EXPRESSION_HPP
@@ -177,4 +177,116 @@ static inline __m128i __attribute__((always_inline)) _mm_cvtepi32_epi64(__m128i
 } // namespace realm
 
 #endif // !defined(_MSC_VER) && defined(REALM_COMPILER_SSE)
+
+/*
+    AVX2 compare helpers used by Array::find_avx2(). Each call compares one 32-byte chunk of packed integers against
+    another and returns the vpmovmskb byte mask of the result (bit n set if byte n belongs to a matching element).
+
+    The same runtime detection argument as above applies, so on gcc and llvm the instructions are emitted through
+    the back end assembler. Operands are passed through memory so that no 256-bit value ever crosses a function
+    boundary (which would require -mavx for the calling convention), and vzeroupper is issued before returning to
+    avoid AVX-to-SSE transition penalties in the surrounding non-VEX code.
+*/
+#if defined(REALM_COMPILER_AVX)
+
+#ifdef _MSC_VER
+#include <immintrin.h>
+#endif
+
+namespace realm {
+
+struct Avx2Chunk {
+    char bytes[32];
+};
+
+#ifdef _MSC_VER
+
+// Returns byte mask of a == b
+template <size_t width>
+static inline unsigned int avx2_cmpeq_mask(const void* a, const void* b)
+{
+    __m256i x = _mm256_loadu_si256(static_cast<const __m256i*>(a));
+    __m256i y = _mm256_loadu_si256(static_cast<const __m256i*>(b));
+    __m256i r;
+    if (width == 8)
+        r = _mm256_cmpeq_epi8(x, y);
+    else if (width == 16)
+        r = _mm256_cmpeq_epi16(x, y);
+    else if (width == 32)
+        r = _mm256_cmpeq_epi32(x, y);
+    else if (width == 64)
+        r = _mm256_cmpeq_epi64(x, y);
+    else
+        return 0;
+    return unsigned(_mm256_movemask_epi8(r));
+}
+
+// Returns byte mask of a > b (signed)
+template <size_t width>
+static inline unsigned int avx2_cmpgt_mask(const void* a, const void* b)
+{
+    __m256i x = _mm256_loadu_si256(static_cast<const __m256i*>(a));
+    __m256i y = _mm256_loadu_si256(static_cast<const __m256i*>(b));
+    __m256i r;
+    if (width == 8)
+        r = _mm256_cmpgt_epi8(x, y);
+    else if (width == 16)
+        r = _mm256_cmpgt_epi16(x, y);
+    else if (width == 32)
+        r = _mm256_cmpgt_epi32(x, y);
+    else if (width == 64)
+        r = _mm256_cmpgt_epi64(x, y);
+    else
+        return 0;
+    return unsigned(_mm256_movemask_epi8(r));
+}
+
+#else
+
+#define REALM_AVX2_MOVEMASK(insn)                                                                                    \
+    "vmovdqu %1, %%ymm0\n\t" insn " %2, %%ymm0, %%ymm0\n\tvpmovmskb %%ymm0, %0\n\tvzeroupper"
+
+// Returns byte mask of a == b
+template <size_t width>
+static inline unsigned int __attribute__((always_inline)) avx2_cmpeq_mask(const void* a, const void* b)
+{
+    const Avx2Chunk& x = *static_cast<const Avx2Chunk*>(a);
+    const Avx2Chunk& y = *static_cast<const Avx2Chunk*>(b);
+    unsigned int mask = 0;
+    if (width == 8)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpeqb") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 16)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpeqw") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 32)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpeqd") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 64)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpeqq") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    return mask;
+}
+
+// Returns byte mask of a > b (signed)
+template <size_t width>
+static inline unsigned int __attribute__((always_inline)) avx2_cmpgt_mask(const void* a, const void* b)
+{
+    const Avx2Chunk& x = *static_cast<const Avx2Chunk*>(a);
+    const Avx2Chunk& y = *static_cast<const Avx2Chunk*>(b);
+    unsigned int mask = 0;
+    if (width == 8)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpgtb") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 16)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpgtw") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 32)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpgtd") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    else if (width == 64)
+        __asm__(REALM_AVX2_MOVEMASK("vpcmpgtq") : "=r" (mask) : "m" (x), "m" (y) : "xmm0");
+    return mask;
+}
+
+#undef REALM_AVX2_MOVEMASK
+
+#endif // _MSC_VER
+
+} // namespace realm
+
+#endif // REALM_COMPILER_AVX
 #endif
@@ -232,15 +232,146 @@ void IncludeDescriptor::execute(IndexPairs&, const Sorter&, const BaseDescriptor
     // does nothing.
 }
 
+bool SortDescriptor::has_links() const noexcept
+{
+    return std::any_of(m_column_keys.begin(), m_column_keys.end(), [](auto&& columns) { return columns.size() > 1; });
+}
+
+namespace {
+
+template <class T>
+int compare_as(const T& a, const T& b)
+{
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+} // anonymous namespace
+
+int SortDescriptor::compare(size_t ndx, Mixed a, Mixed b) const
+{
+    // The Sorter compares the first column through Mixed, and the others through ConstObj::cmp()
+    if (ndx == 0)
+        return a.compare(b);
+    switch (m_column_keys[ndx][0].get_type()) {
+        case col_type_Int:
+            // Nulls come first, like util::Optional<Int> orders them
+            if (a.is_null() || b.is_null())
+                return int(!a.is_null()) - int(!b.is_null());
+            return compare_as(a.get_int(), b.get_int());
+        case col_type_Bool:
+            // A null is read as true when compared as a plain bool
+            return compare_as(a.is_null() || a.get_bool(), b.is_null() || b.get_bool());
+        case col_type_Float:
+            // A null is read as NaN, which is neither less nor greater than any value
+            if (a.is_null() || b.is_null())
+                return 0;
+            return compare_as(a.get_float(), b.get_float());
+        case col_type_Double:
+            if (a.is_null() || b.is_null())
+                return 0;
+            return compare_as(a.get_double(), b.get_double());
+        case col_type_String:
+            return compare_as(a.is_null() ? StringData() : a.get_string(),
+                              b.is_null() ? StringData() : b.get_string());
+        case col_type_Binary:
+            return compare_as(a.is_null() ? BinaryData() : a.get_binary(),
+                              b.is_null() ? BinaryData() : b.get_binary());
+        case col_type_Timestamp:
+            return compare_as(a.is_null() ? Timestamp() : a.get_timestamp(),
+                              b.is_null() ? Timestamp() : b.get_timestamp());
+        case col_type_Link:
+            return compare_as(a.is_null() ? ObjKey() : a.get<ObjKey>(), b.is_null() ? ObjKey() : b.get<ObjKey>());
+        default:
+            REALM_UNREACHABLE();
+    }
+    return 0;
+}
+
+bool SortDescriptor::is_before(const Table& table, ObjKey a, ObjKey b) const
+{
+    REALM_ASSERT_DEBUG(!has_links());
+    ConstObj obj_a = table.get_object(a);
+    ConstObj obj_b = table.get_object(b);
+    for (size_t t = 0; t < m_column_keys.size(); t++) {
+        ColKey col_key = m_column_keys[t][0];
+        int c = compare(t, obj_a.get_any(col_key), obj_b.get_any(col_key));
+        if (c)
+            return m_ascending[t] ? c < 0 : c > 0;
+    }
+    return a < b;
+}
+
+bool SortDescriptor::is_before(const Values& a, ObjKey key_a, const Values& b, ObjKey key_b) const
+{
+    for (size_t t = 0; t < m_column_keys.size(); t++) {
+        int c = compare(t, a.get(t), b.get(t));
+        if (c)
+            return m_ascending[t] ? c < 0 : c > 0;
+    }
+    return key_a < key_b;
+}
+
+SortDescriptor::Values SortDescriptor::get_values(const Table& table, ObjKey key) const
+{
+    REALM_ASSERT_DEBUG(!has_links());
+    ConstObj obj = table.get_object(key);
+    Values values;
+    values.m_values.reserve(m_column_keys.size());
+    for (auto& columns : m_column_keys) {
+        Mixed value = obj.get_any(columns[0]);
+        size_t begin = values.m_data.size();
+        size_t size = 0;
+        if (!value.is_null() && value.get_type() == type_String) {
+            StringData str = value.get_string();
+            values.m_data.append(str.data(), str.size());
+            size = str.size();
+            value = StringData("", 0);
+        }
+        else if (!value.is_null() && value.get_type() == type_Binary) {
+            BinaryData bin = value.get_binary();
+            values.m_data.append(bin.data(), bin.size());
+            size = bin.size();
+            value = BinaryData("", 0);
+        }
+        values.m_values.push_back({value, begin, size});
+    }
+    return values;
+}
+
+Mixed SortDescriptor::Values::get(size_t ndx) const noexcept
+{
+    const Value& v = m_values[ndx];
+    if (!v.value.is_null()) {
+        if (v.value.get_type() == type_String)
+            return StringData(m_data.data() + v.begin, v.size);
+        if (v.value.get_type() == type_Binary)
+            return BinaryData(m_data.data() + v.begin, v.size);
+    }
+    return v.value;
+}
+
 BaseDescriptor::Sorter SortDescriptor::sorter(Table const& table, const IndexPairs& indexes) const
 {
     REALM_ASSERT(!m_column_keys.empty());
-    return Sorter(m_column_keys, m_ascending, table, indexes);
+    Sorter sorter(m_column_keys, m_ascending, table, indexes);
+    sorter.find_ordered_index(indexes);
+    return sorter;
 }
 
 void SortDescriptor::execute(IndexPairs& v, const Sorter& predicate, const BaseDescriptor* next) const
 {
-    std::sort(v.begin(), v.end(), std::ref(predicate));
+    // If a limit follows, only the first `limit` entries need to be put in order
+    size_t limit = size_t(-1);
+    if (next && next->get_type() == DescriptorType::Limit)
+        limit = static_cast<const LimitDescriptor*>(next)->get_limit();
+
+    if (!predicate.sort_by_ordered_index(v, limit)) {
+        // The predicate is a total ordering, so a partial sort gives the same first entries as a full sort
+        if (limit < v.size() / 2)
+            std::partial_sort(v.begin(), v.begin() + limit, v.end(), std::ref(predicate));
+        else
+            std::sort(v.begin(), v.end(), std::ref(predicate));
+    }
 
     // not doing this on the last step is an optimisation
     if (next) {
@@ -324,7 +455,8 @@ bool BaseDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
 
 void BaseDescriptor::Sorter::cache_first_column(IndexPairs& v)
 {
-    if (m_columns.empty())
+    // Values are not needed when sorting through an index
+    if (m_columns.empty() || m_ordered_index)
         return;
 
     auto& col = m_columns[0];
@@ -347,6 +479,68 @@ void BaseDescriptor::Sorter::cache_first_column(IndexPairs& v)
     }
 }
 
+void BaseDescriptor::Sorter::find_ordered_index(const IndexPairs& v)
+{
+    m_ordered_index = nullptr;
+    if (m_columns.size() != 1 || !m_columns[0].translated_keys.empty())
+        return;
+    const OrderedIndex* index = m_columns[0].table->get_ordered_index(m_columns[0].col_key);
+    // Walking the index visits every object in the table, so the view must hold a good part of it
+    if (!index || v.size() * 4 < index->size())
+        return;
+    // The index orders equal values by key, which is only the order of a stable sort if the view is in
+    // table order
+    for (size_t i = 1; i < v.size(); i++) {
+        if (!(v[i - 1].key_for_object < v[i].key_for_object) || !(v[i - 1] < v[i]))
+            return;
+    }
+    m_ordered_index = index;
+}
+
+bool BaseDescriptor::Sorter::sort_by_ordered_index(IndexPairs& v, size_t limit) const
+{
+    if (!m_ordered_index)
+        return false;
+
+    const OrderedIndex& index = *m_ordered_index;
+    size_t wanted = std::min(v.size(), limit);
+    std::vector<IndexPair> sorted;
+    sorted.reserve(wanted);
+    auto add = [&](size_t ndx) {
+        ObjKey key = index.get_key(ndx);
+        auto it = std::lower_bound(v.begin(), v.end(), key,
+                                   [](const IndexPair& pair, ObjKey k) { return pair.key_for_object < k; });
+        if (it != v.end() && it->key_for_object == key)
+            sorted.push_back(*it);
+    };
+
+    size_t sz = index.size();
+    if (m_columns[0].ascending) {
+        for (size_t i = 0; i < sz && sorted.size() < wanted; i++) {
+            add(i);
+        }
+    }
+    else {
+        // Take the runs of equal values from the back, keeping each run in table order
+        size_t end = sz;
+        while (end > 0 && sorted.size() < wanted) {
+            Mixed value = index.get_value(end - 1);
+            size_t begin = end - 1;
+            while (begin > 0 && index.get_value(begin - 1).compare(value) == 0)
+                --begin;
+            for (size_t i = begin; i < end && sorted.size() < wanted; i++) {
+                add(i);
+            }
+            end = begin;
+        }
+    }
+    REALM_ASSERT(sorted.size() == wanted);
+    // The entries beyond the limit were never looked at, so account for them here instead of in the limit
+    v.m_removed_by_limit += v.size() - wanted;
+    v.std::vector<IndexPair>::swap(sorted);
+    return true;
+}
+
 IncludeDescriptor::IncludeDescriptor(ConstTableRef table, const std::vector<std::vector<LinkPathPart>>& column_links)
     : ColumnsDescriptor()
 {
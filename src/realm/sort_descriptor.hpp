@@ -27,6 +27,7 @@
 namespace realm {
 
 class SortDescriptor;
+class OrderedIndex;
 class ConstTableRef;
 class Group;
 
@@ -94,6 +95,13 @@ public:
         }
         void cache_first_column(IndexPairs& v);
 
+        // Use an ordered index on the sort column, if there is one, to sort `v` without comparing values. This
+        // is only possible when sorting on a single column without links, and `v` is in table order.
+        void find_ordered_index(const IndexPairs& v);
+        // Sort `v` through the index found by find_ordered_index(). Returns false if there is none. Only the
+        // first `limit` entries are looked up in the index, and the rest are removed from `v`.
+        bool sort_by_ordered_index(IndexPairs& v, size_t limit = size_t(-1)) const;
+
     private:
         struct SortColumn {
             SortColumn(const Table* t, ColKey c, bool a)
@@ -110,6 +118,7 @@ public:
             bool ascending;
         };
         std::vector<SortColumn> m_columns;
+        const OrderedIndex* m_ordered_index = nullptr;
         friend class ObjList;
     };
 
@@ -199,6 +208,36 @@ public:
 
     void merge_with(SortDescriptor&& other);
 
+    // The values of the sort columns of an object. Strings and binaries are copied, so that the values can still
+    // be used once the transaction they were read in has moved on.
+    class Values {
+    public:
+        Mixed get(size_t ndx) const noexcept;
+
+    private:
+        struct Value {
+            // An empty string or binary for values whose data is kept in m_data
+            Mixed value;
+            size_t begin;
+            size_t size;
+        };
+        std::vector<Value> m_values;
+        std::string m_data;
+
+        friend class SortDescriptor;
+    };
+
+    // True if any of the columns is reached through links
+    bool has_links() const noexcept;
+    // Returns true if the object `a` of `table` comes before `b` when sorted by this descriptor. Ties are
+    // broken by key, which is the order a stable sort of a view in table order gives. Can only be used when
+    // there are no links.
+    bool is_before(const Table& table, ObjKey a, ObjKey b) const;
+    // Same as above, for objects with the sort values `a` and `b`
+    bool is_before(const Values& a, ObjKey key_a, const Values& b, ObjKey key_b) const;
+    // Read the sort values of the object `key` of `table`. Can only be used when there are no links.
+    Values get_values(const Table& table, ObjKey key) const;
+
     Sorter sorter(Table const& table, const IndexPairs& indexes) const override;
 
     void execute(IndexPairs& v, const Sorter& predicate, const BaseDescriptor* next) const override;
@@ -207,6 +246,9 @@ public:
 
 private:
     std::vector<bool> m_ascending;
+
+    // Compare values of the sort column `ndx` the same way as the Sorter does
+    int compare(size_t ndx, Mixed a, Mixed b) const;
 };
 
 class LimitDescriptor : public BaseDescriptor {
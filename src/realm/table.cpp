@@ -565,9 +565,13 @@ void Table::populate_search_index(ColKey col_key)
     }
 }
 
-void Table::add_search_index(ColKey col_key)
+void Table::add_search_index(ColKey col_key, IndexType type)
 {
     check_column(col_key);
+    if (type == IndexType::Ordered) {
+        add_ordered_index(col_key);
+        return;
+    }
     size_t column_ndx = col_key.get_index().val;
 
     // Early-out if already indexed
@@ -602,9 +606,13 @@ void Table::add_search_index(ColKey col_key)
     populate_search_index(col_key);
 }
 
-void Table::remove_search_index(ColKey col_key)
+void Table::remove_search_index(ColKey col_key, IndexType type)
 {
     check_column(col_key);
+    if (type == IndexType::Ordered) {
+        remove_ordered_index(col_key);
+        return;
+    }
     auto column_ndx = col_key.get_index();
 
     // Early-out if non-indexed
@@ -627,6 +635,69 @@ void Table::remove_search_index(ColKey col_key)
     m_spec.set_column_attr(spec_ndx, attr); // Throws
 }
 
+void Table::add_ordered_index(ColKey col_key)
+{
+    // Early-out if already indexed
+    if (get_ordered_index(col_key))
+        return;
+
+    DataType type = DataType(col_key.get_type());
+    if (!OrderedIndex::type_supported(type) || col_key.get_attrs().test(col_attr_List))
+        throw LogicError(LogicError::illegal_combination);
+
+    if (m_top.size() <= top_position_for_ordered_indexes) {
+        MemRef mem = Array::create_empty_array(Array::type_HasRefs, false, m_top.get_alloc()); // Throws
+        _impl::DeepArrayRefDestroyGuard dg(mem.get_ref(), m_top.get_alloc());
+        m_top.add(from_ref(mem.get_ref())); // Throws
+        dg.release();
+        m_ordered_index_refs.init_from_parent();
+    }
+
+    std::vector<std::pair<Mixed, ObjKey>> entries;
+    entries.reserve(size());
+    for (auto o : *this) {
+        entries.emplace_back(o.get_any(col_key), o.get_key());
+    }
+
+    auto index = OrderedIndex::create(type, get_alloc()); // Throws
+    _impl::DeepArrayRefDestroyGuard dg(index->get_ref(), get_alloc());
+    index->build(entries); // Throws
+
+    size_t ndx_in_parent = m_ordered_index_refs.size() + 1;
+    m_ordered_index_refs.add(RefOrTagged::make_tagged(col_key.value)); // Throws
+    m_ordered_index_refs.add(from_ref(index->get_ref()));             // Throws
+    dg.release();
+    index->set_parent(&m_ordered_index_refs, ndx_in_parent);
+
+    size_t col_ndx = col_key.get_index().val;
+    if (col_ndx >= m_ordered_index_accessors.size())
+        m_ordered_index_accessors.resize(col_ndx + 1);
+    m_ordered_index_accessors[col_ndx] = std::move(index);
+
+    // Cores that do not know ordered indexes must not open the file anymore
+    Group* group = get_parent_group();
+    if (group && group->get_file_format_version() < 11)
+        group->set_file_format_version(11);
+}
+
+void Table::remove_ordered_index(ColKey col_key)
+{
+    OrderedIndex* index = get_ordered_index(col_key);
+    if (!index)
+        return;
+
+    size_t sz = m_ordered_index_refs.size();
+    for (size_t i = 0; i < sz; i += 2) {
+        if (ColKey(m_ordered_index_refs.get_as_ref_or_tagged(i).get_as_int()) == col_key) {
+            index->destroy();
+            m_ordered_index_refs.erase(i, i + 2);
+            break;
+        }
+    }
+    // The positions of the remaining indexes may have changed
+    refresh_ordered_index_accessors();
+}
+
 void Table::enumerate_string_column(ColKey col_key)
 {
     check_column(col_key);
@@ -744,6 +815,7 @@ ColKey Table::do_insert_root_column(ColKey col_key, ColumnType type, StringData
 void Table::do_erase_root_column(ColKey col_key)
 {
     size_t col_ndx = col_key.get_index().val;
+    remove_ordered_index(col_key);
     // If the column had a source index we have to remove and destroy that as well
     ref_type index_ref = m_index_refs.get_as_ref(col_ndx);
     if (index_ref) {
@@ -808,6 +880,9 @@ void Table::fully_detach() noexcept
     m_opposite_table.detach();
     m_opposite_column.detach();
     m_index_accessors.clear();
+    m_ordered_index_refs.detach();
+    m_ordered_index_accessors.clear();
+    m_clusters.clear_zone_maps();
 }
 
 
@@ -834,6 +909,11 @@ bool Table::has_search_index(ColKey col_key) const noexcept
     return m_index_accessors[col_key.get_index().val] != nullptr;
 }
 
+bool Table::has_ordered_index(ColKey col_key) const noexcept
+{
+    return get_ordered_index(col_key) != nullptr;
+}
+
 void Table::migrate_column_info(util::FunctionRef<void()> commit_and_continue)
 {
     bool changes = false;
@@ -2140,6 +2220,15 @@ void Table::update_from_parent(size_t old_baseline) noexcept
             m_opposite_table.update_from_parent(old_baseline);
         if (m_top.size() > top_position_for_opposite_column)
             m_opposite_column.update_from_parent(old_baseline);
+        if (m_top.size() > top_position_for_ordered_indexes) {
+            if (m_ordered_index_refs.update_from_parent(old_baseline)) {
+                for (auto& index : m_ordered_index_accessors) {
+                    if (index != nullptr) {
+                        index->update_from_parent(old_baseline);
+                    }
+                }
+            }
+        }
         refresh_content_version();
     }
     m_alloc.bump_storage_version();
@@ -2297,6 +2386,39 @@ void Table::refresh_index_accessors()
             m_index_accessors[col_ndx] = new StringIndex(ref, &m_index_refs, col_ndx, virtual_col, get_alloc());
         }
     }
+
+    refresh_ordered_index_accessors();
+}
+
+void Table::refresh_ordered_index_accessors()
+{
+    if (m_top.size() <= top_position_for_ordered_indexes) {
+        m_ordered_index_accessors.clear();
+        m_ordered_index_refs.detach();
+        return;
+    }
+
+    m_ordered_index_refs.init_from_parent();
+    // An index still at the same ref is unchanged, so its accessor is kept
+    std::vector<std::unique_ptr<OrderedIndex>> old_accessors;
+    old_accessors.swap(m_ordered_index_accessors);
+    size_t sz = m_ordered_index_refs.size();
+    for (size_t i = 0; i < sz; i += 2) {
+        ColKey col_key(m_ordered_index_refs.get_as_ref_or_tagged(i).get_as_int());
+        ref_type ref = m_ordered_index_refs.get_as_ref(i + 1);
+        size_t col_ndx = col_key.get_index().val;
+        if (col_ndx >= m_ordered_index_accessors.size())
+            m_ordered_index_accessors.resize(col_ndx + 1);
+        auto& index = m_ordered_index_accessors[col_ndx];
+        if (col_ndx < old_accessors.size() && old_accessors[col_ndx] && old_accessors[col_ndx]->get_ref() == ref) {
+            index = std::move(old_accessors[col_ndx]);
+            index->set_parent(&m_ordered_index_refs, i + 1);
+        }
+        else {
+            index = OrderedIndex::create(DataType(col_key.get_type()), ref, &m_ordered_index_refs, i + 1,
+                                         get_alloc()); // Throws
+        }
+    }
 }
 
 bool Table::is_cross_table_link_target() const noexcept
@@ -2318,6 +2440,12 @@ void Table::verify() const
         m_top.verify();
     m_spec.verify();
     m_clusters.verify();
+    for (auto& index : m_ordered_index_accessors) {
+        if (index) {
+            index->verify();
+            REALM_ASSERT(index->size() == size());
+        }
+    }
 #endif
 }
 
@@ -3088,6 +3216,7 @@ ColKey Table::set_nullability(ColKey col_key, bool nullable, bool throw_on_null)
         return col_key;
 
     bool si = has_search_index(col_key);
+    bool oi = has_ordered_index(col_key);
     std::string column_name(get_column_name(col_key));
     auto type = get_real_column_type(col_key);
     auto list = is_list(col_key);
@@ -3111,6 +3240,8 @@ ColKey Table::set_nullability(ColKey col_key, bool nullable, bool throw_on_null)
 
     if (si)
         add_search_index(new_col);
+    if (oi)
+        add_search_index(new_col, IndexType::Ordered);
 
     return new_col;
 }
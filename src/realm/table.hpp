@@ -34,6 +34,7 @@
 #include <realm/spec.hpp>
 #include <realm/query.hpp>
 #include <realm/cluster_tree.hpp>
+#include <realm/index_ordered.hpp>
 #include <realm/keys.hpp>
 #include <realm/global_key.hpp>
 
@@ -219,24 +220,37 @@ public:
 
     //@{
 
+    /// The kinds of index a column can have. A general search index
+    /// (StringIndex) speeds up equality conditions. An ordered index
+    /// (OrderedIndex) keeps the values sorted, which speeds up range conditions
+    /// and sorting on the column. Ordered indexes are supported for Int, Float,
+    /// Double and Timestamp columns.
+    enum class IndexType { General, Ordered };
+
     /// has_search_index() returns true if, and only if a search index has been
     /// added to the specified column. Rather than throwing, it returns false if
     /// the table accessor is detached or the specified index is out of range.
+    /// has_ordered_index() does the same for ordered indexes.
     ///
-    /// add_search_index() adds a search index to the specified column of the
-    /// table. It has no effect if a search index has already been added to the
-    /// specified column (idempotency).
+    /// add_search_index() adds a search index of the specified type to the
+    /// specified column of the table. It has no effect if an index of that type
+    /// has already been added to the specified column (idempotency).
     ///
-    /// remove_search_index() removes the search index from the specified column
-    /// of the table. It has no effect if the specified column has no search
-    /// index. The search index cannot be removed from the primary key of a
-    /// table.
+    /// remove_search_index() removes the index of the specified type from the
+    /// specified column of the table. It has no effect if the specified column
+    /// has no index of that type. The search index cannot be removed from the
+    /// primary key of a table.
+    ///
+    /// Like the search index, ordered indexes are not replicated. Adding the
+    /// first ordered index to a file raises its file format to version 11 once
+    /// the transaction is committed.
     ///
     /// \param col_key The key of a column of the table.
 
     bool has_search_index(ColKey col_key) const noexcept;
-    void add_search_index(ColKey col_key);
-    void remove_search_index(ColKey col_key);
+    bool has_ordered_index(ColKey col_key) const noexcept;
+    void add_search_index(ColKey col_key, IndexType type = IndexType::General);
+    void remove_search_index(ColKey col_key, IndexType type = IndexType::General);
 
     void enumerate_string_column(ColKey col_key);
     bool is_enumerated(ColKey col_key) const noexcept;
@@ -268,6 +282,17 @@ public:
     bool is_empty() const noexcept;
     size_t size() const noexcept;
 
+    // Read the data of the column, or of the whole table if no column is given,
+    // so it is in memory before it is needed. For encrypted files this
+    // decrypts it, on several threads for larger parts of the file. Returns the
+    // number of bytes read.
+    size_t warm_up(ColKey col_key = {}) const
+    {
+        if (col_key)
+            check_column(col_key);
+        return m_clusters.warm_up(col_key);
+    }
+
     //@{
 
     /// Object handling.
@@ -403,6 +428,12 @@ public:
             return nullptr;
         return m_index_accessors[col.get_index().val];
     }
+    // Will return pointer to ordered index accessor. Will return nullptr if no index
+    OrderedIndex* get_ordered_index(ColKey col) const noexcept
+    {
+        size_t ndx = col.get_index().val;
+        return ndx < m_ordered_index_accessors.size() ? m_ordered_index_accessors[ndx].get() : nullptr;
+    }
     template <class T>
     ObjKey find_first(ColKey col_key, T value) const;
 
@@ -686,6 +717,10 @@ private:
     Array m_opposite_table;  // 7th slot in m_top
     Array m_opposite_column; // 8th slot in m_top
     std::vector<StringIndex*> m_index_accessors;
+    // List of pairs (column index, index ref) in the optional 13th slot in m_top. The accessors are indexed
+    // by column index.
+    Array m_ordered_index_refs;
+    std::vector<std::unique_ptr<OrderedIndex>> m_ordered_index_accessors;
     ColKey m_primary_key_col;
     Replication* const* m_repl;
     static Replication* g_dummy_replication;
@@ -696,6 +731,8 @@ private:
     size_t do_set_link(ColKey col_key, size_t row_ndx, size_t target_row_ndx);
 
     void populate_search_index(ColKey col_key);
+    void add_ordered_index(ColKey col_key);
+    void remove_ordered_index(ColKey col_key);
 
     // Migration support
     void migrate_column_info(util::FunctionRef<void()>);
@@ -903,6 +940,7 @@ private:
     /// table.
     void refresh_accessor_tree();
     void refresh_index_accessors();
+    void refresh_ordered_index_accessors();
     void refresh_content_version();
     void flush_for_commit();
 
@@ -931,6 +969,8 @@ private:
     static constexpr int top_position_for_collision_map = 10;
     static constexpr int top_position_for_pk_col = 11;
     static constexpr int top_array_size = 12;
+    // Only present in tables which have, or have had, an ordered index
+    static constexpr int top_position_for_ordered_indexes = 12;
 
     enum { s_collision_map_lo = 0, s_collision_map_hi = 1, s_collision_map_local_id = 2, s_collision_map_num_slots };
 
@@ -1224,6 +1264,7 @@ inline Table::Table(Allocator& alloc)
     , m_index_refs(m_alloc)
     , m_opposite_table(m_alloc)
     , m_opposite_column(m_alloc)
+    , m_ordered_index_refs(m_alloc)
     , m_repl(&g_dummy_replication)
     , m_own_ref(this, alloc.get_instance_version())
 {
@@ -1231,6 +1272,7 @@ inline Table::Table(Allocator& alloc)
     m_index_refs.set_parent(&m_top, top_position_for_search_indexes);
     m_opposite_table.set_parent(&m_top, top_position_for_opposite_table);
     m_opposite_column.set_parent(&m_top, top_position_for_opposite_column);
+    m_ordered_index_refs.set_parent(&m_top, top_position_for_ordered_indexes);
 
     ref_type ref = create_empty_table(m_alloc); // Throws
     ArrayParent* parent = nullptr;
@@ -1246,6 +1288,7 @@ inline Table::Table(Replication* const* repl, Allocator& alloc)
     , m_index_refs(m_alloc)
     , m_opposite_table(m_alloc)
     , m_opposite_column(m_alloc)
+    , m_ordered_index_refs(m_alloc)
     , m_repl(repl)
     , m_own_ref(this, alloc.get_instance_version())
 {
@@ -1253,6 +1296,7 @@ inline Table::Table(Replication* const* repl, Allocator& alloc)
     m_index_refs.set_parent(&m_top, top_position_for_search_indexes);
     m_opposite_table.set_parent(&m_top, top_position_for_opposite_table);
     m_opposite_column.set_parent(&m_top, top_position_for_opposite_column);
+    m_ordered_index_refs.set_parent(&m_top, top_position_for_ordered_indexes);
 }
 
 inline void Table::revive(Replication* const* repl, Allocator& alloc, bool writable)
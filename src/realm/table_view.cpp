@@ -20,11 +20,159 @@
 #include <realm/column_integer.hpp>
 #include <realm/index_string.hpp>
 #include <realm/db.hpp>
+#include <realm/impl/input_stream.hpp>
+#include <realm/impl/transact_log.hpp>
 
 #include <unordered_set>
 
 using namespace realm;
 
+namespace {
+
+// Returns the transaction of `group`, if it is a read transaction. Only then are the changes up to its version
+// found in the history.
+Transaction* get_read_transaction(Group* group)
+{
+    auto tr = dynamic_cast<Transaction*>(group);
+    if (tr && (tr->get_transact_stage() == DB::transact_Reading || tr->get_transact_stage() == DB::transact_Frozen))
+        return tr;
+    return nullptr;
+}
+
+// Collects the objects of a table that are created, modified or removed by a series of changesets. Changes
+// which cannot be handled one object at a time, like schema changes or changes to other tables the table view
+// depends on, make the result unusable.
+class TouchedObjects : public _impl::NullInstructionObserver {
+public:
+    TouchedObjects(TableKey table_key, const TableVersions& dependencies)
+        : m_table_key(table_key)
+    {
+        // The first dependency is the table itself. If it shows up again, objects are linked to from other
+        // objects of the same table, so that a change to one object may change whether another one matches.
+        for (size_t i = 1; i < dependencies.size(); ++i) {
+            if (dependencies[i].first == table_key)
+                m_usable = false;
+            m_other_tables.push_back(dependencies[i].first);
+        }
+    }
+
+    bool is_usable() const noexcept
+    {
+        return m_usable;
+    }
+    const std::unordered_set<ObjKey>& get_keys() const noexcept
+    {
+        return m_keys;
+    }
+
+    bool select_table(TableKey key)
+    {
+        m_selected = key == m_table_key;
+        if (std::find(m_other_tables.begin(), m_other_tables.end(), key) != m_other_tables.end())
+            m_usable = false;
+        return true;
+    }
+    bool erase_group_level_table(TableKey key)
+    {
+        if (key == m_table_key)
+            m_usable = false;
+        return true;
+    }
+    bool create_object(ObjKey key)
+    {
+        return touch(key);
+    }
+    bool remove_object(ObjKey key)
+    {
+        return touch(key);
+    }
+    bool modify_object(ColKey, ObjKey key)
+    {
+        return touch(key);
+    }
+    bool select_list(ColKey, ObjKey key)
+    {
+        return touch(key);
+    }
+    bool select_link_list(ColKey, ObjKey key)
+    {
+        return touch(key);
+    }
+    bool clear_table(size_t)
+    {
+        return schema_change();
+    }
+    bool insert_column(ColKey)
+    {
+        return schema_change();
+    }
+    bool erase_column(ColKey)
+    {
+        return schema_change();
+    }
+    bool rename_column(ColKey)
+    {
+        return schema_change();
+    }
+    bool set_link_type(ColKey)
+    {
+        return schema_change();
+    }
+
+private:
+    TableKey m_table_key;
+    std::vector<TableKey> m_other_tables;
+    std::unordered_set<ObjKey> m_keys;
+    bool m_selected = false;
+    bool m_usable = true;
+
+    bool touch(ObjKey key)
+    {
+        if (m_selected)
+            m_keys.insert(key);
+        return true;
+    }
+    bool schema_change()
+    {
+        if (m_selected)
+            m_usable = false;
+        return true;
+    }
+};
+
+// Position of the first key in `keys` not less than `key`. `keys` must be in ascending order.
+size_t find_key_position(const KeyColumn& keys, ObjKey key)
+{
+    size_t lo = 0;
+    size_t hi = keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keys.get(mid) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Position of the first key in `keys` for which `is_before(key)` is false. `keys` must be partitioned by it.
+template <class F>
+size_t find_sorted_position(const KeyColumn& keys, F is_before)
+{
+    size_t lo = 0;
+    size_t hi = keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (is_before(keys.get(mid)))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+} // anonymous namespace
+
 ConstTableView::ConstTableView(ConstTableView& src, Transaction*, PayloadPolicy)
     : ObjList(&m_table_view_key_values)
     , m_source_column_key(src.m_source_column_key)
@@ -78,6 +226,12 @@ ConstTableView::ConstTableView(const ConstTableView& src, Transaction* tr, Paylo
     m_start = src.m_start;
     m_end = src.m_end;
     m_limit = src.m_limit;
+    m_incremental_sync = src.m_incremental_sync;
+    m_in_key_order = src.m_in_key_order;
+    if (was_in_sync) {
+        m_last_seen_db_version = src.m_last_seen_db_version;
+        m_sort_values = src.m_sort_values;
+    }
 }
 
 // Aggregates ----------------------------------------------------
@@ -512,6 +666,9 @@ void ConstTableView::limit(LimitDescriptor lim)
 
 void ConstTableView::apply_descriptor_ordering(const DescriptorOrdering& new_ordering)
 {
+    // The view is not in the order of the new descriptors, so it cannot be patched
+    m_last_seen_db_version = VersionID();
+    m_sort_values.clear();
     m_descriptor_ordering = new_ordering;
     m_descriptor_ordering.collect_dependencies(m_table.unchecked_ptr());
 
@@ -547,12 +704,19 @@ void ConstTableView::sort(SortDescriptor order)
     m_descriptor_ordering.collect_dependencies(m_table.unchecked_ptr());
 
     do_sort(m_descriptor_ordering);
+    m_last_seen_db_version = VersionID();
+    m_sort_values.clear();
 }
 
 
 void ConstTableView::do_sync()
 {
     CriticalSection cs(m_race_detector);
+    if (m_incremental_sync && do_incremental_sync()) {
+        m_last_seen_versions = get_dependency_versions();
+        return;
+    }
+
     // This TableView can be "born" from 4 different sources:
     // - LinkView
     // - Query::find_all()
@@ -599,12 +763,155 @@ void ConstTableView::do_sync()
 
         if (m_query.m_view)
             m_query.m_view->sync_if_needed();
+        m_in_key_order = true;
         m_query.find_all(*const_cast<ConstTableView*>(this), m_start, m_end, m_limit);
     }
 
     do_sort(m_descriptor_ordering);
 
     m_last_seen_versions = get_dependency_versions();
+    update_last_seen_db_version();
+}
+
+void ConstTableView::set_incremental_sync(bool enable)
+{
+    m_incremental_sync = enable;
+    if (!enable || is_in_sync())
+        update_last_seen_db_version();
+}
+
+void ConstTableView::update_last_seen_db_version()
+{
+    m_last_seen_db_version = VersionID();
+    m_sort_values.clear();
+    if (!m_incremental_sync || !m_table)
+        return;
+    Transaction* tr = get_read_transaction(m_table->get_parent_group());
+    if (!tr)
+        return;
+    const SortDescriptor* sort;
+    if (!get_incremental_sort(sort))
+        return;
+    // Unsorted views are patched assuming that the keys are in ascending order
+    if (!m_in_key_order && !sort)
+        return;
+    // The objects changed by the next commits are found in a sorted view by their values in this version
+    if (sort) {
+        m_sort_values.reserve(m_key_values->size());
+        for (size_t i = 0; i < m_key_values->size(); ++i) {
+            ObjKey key = m_key_values->get(i);
+            m_sort_values.emplace(key, sort->get_values(*m_table, key)); // Throws
+        }
+    }
+    m_last_seen_db_version = tr->get_version_of_current_transaction();
+}
+
+bool ConstTableView::get_incremental_sort(const SortDescriptor*& sort) const
+{
+    sort = nullptr;
+    if (m_linklist_source || m_distinct_column_source || m_source_column_key || !m_query.m_table ||
+        m_query.m_view || m_start != 0 || m_end != size_t(-1) || m_limit != size_t(-1))
+        return false;
+
+    // A single sort can be kept up to date by inserting objects at their position. Include descriptors do not
+    // change the result.
+    for (size_t i = 0; i < m_descriptor_ordering.size(); ++i) {
+        const BaseDescriptor* descr = m_descriptor_ordering[i];
+        if (descr->get_type() == DescriptorType::Sort && !sort) {
+            sort = static_cast<const SortDescriptor*>(descr);
+        }
+        else if (descr->get_type() != DescriptorType::Include) {
+            return false;
+        }
+    }
+    return !(sort && sort->has_links());
+}
+
+bool ConstTableView::do_incremental_sync()
+{
+    const SortDescriptor* sort;
+    if (!get_incremental_sort(sort))
+        return false;
+    if (m_last_seen_db_version.version == VersionID().version || !m_key_values->is_attached())
+        return false;
+    if (sort && m_sort_values.size() != m_key_values->size())
+        return false;
+
+    m_table.check();
+    Transaction* tr = get_read_transaction(m_table->get_parent_group());
+    if (!tr)
+        return false;
+    VersionID version = tr->get_version_of_current_transaction();
+    if (version.version < m_last_seen_db_version.version)
+        return false;
+    _impl::History* hist = tr->get_history();
+    if (!hist)
+        return false;
+    hist->ensure_updated(version.version);
+    if (!hist->has_changesets(m_last_seen_db_version.version, version.version))
+        return false;
+
+    TouchedObjects touched(m_table->get_key(), m_last_seen_versions);
+    {
+        _impl::TransactLogParser parser;
+        _impl::ChangesetInputStream in(*hist, m_last_seen_db_version.version, version.version);
+        parser.parse(in, touched); // Throws
+    }
+    if (!touched.is_usable())
+        return false;
+    const std::unordered_set<ObjKey>& keys = touched.get_keys();
+    // Each touched object costs a few lookups in the view, so when a large part of the table has changed,
+    // rerunning the query is cheaper
+    if (keys.size() * 8 > m_table->size())
+        return false;
+
+    // Take the touched objects out of the view
+    if (sort) {
+        // The view is ordered by the values the objects had when it was last synced, which the touched objects
+        // are looked up by
+        for (ObjKey key : keys) {
+            auto it = m_sort_values.find(key);
+            if (it == m_sort_values.end())
+                continue;
+            size_t ndx = find_sorted_position(*m_key_values, [&](ObjKey k) {
+                return sort->is_before(m_sort_values.find(k)->second, k, it->second, key);
+            });
+            REALM_ASSERT(ndx < m_key_values->size() && m_key_values->get(ndx) == key);
+            m_key_values->erase(ndx);
+            m_sort_values.erase(it);
+        }
+    }
+    else {
+        // An unsorted view is in key order, as recorded by the last full sync
+        for (ObjKey key : keys) {
+            size_t ndx = find_key_position(*m_key_values, key);
+            if (ndx < m_key_values->size() && m_key_values->get(ndx) == key)
+                m_key_values->erase(ndx);
+        }
+    }
+
+    // And put back the ones that still match
+    m_query.init();
+    for (ObjKey key : keys) {
+        if (!m_table->is_valid(key))
+            continue;
+        ConstObj obj = m_table->get_object(key);
+        if (!m_query.eval_object(obj))
+            continue;
+        size_t ndx;
+        if (sort) {
+            ndx = find_sorted_position(*m_key_values, [&](ObjKey k) { return sort->is_before(*m_table, k, key); });
+            m_sort_values.emplace(key, sort->get_values(*m_table, key)); // Throws
+        }
+        else {
+            ndx = find_key_position(*m_key_values, key);
+        }
+        m_key_values->insert(ndx, key);
+    }
+
+    m_limit_count = 0;
+    m_last_seen_db_version = version;
+    return true;
 }
 
 bool ConstTableView::is_in_table_order() const
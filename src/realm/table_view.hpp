@@ -23,6 +23,9 @@
 #include <realm/table.hpp>
 #include <realm/util/features.h>
 #include <realm/obj_list.hpp>
+#include <realm/version_id.hpp>
+
+#include <unordered_map>
 
 namespace realm {
 
@@ -302,6 +305,21 @@ public:
     // This will make the TableView empty and in sync with the highest possible table version
     // if the TableView depends on an object (LinkView or row) that has been deleted.
     void sync_if_needed() const override;
+
+    // With incremental sync enabled, sync_if_needed() updates a view built by a query on a read transaction
+    // from the changes committed since the last sync instead of rerunning the query. Only the objects created,
+    // modified or removed by those changes are evaluated, and the keys and the sort order of the view are
+    // patched accordingly. Views restricted by another view, a limit or a distinct, and views sorted through
+    // links, are always synced in full, and so is any view whose changes touch the schema or other tables the
+    // view depends on. A sorted view keeps a copy of the values of its sort columns for every object in it, so
+    // that the objects changed since the last sync can be looked up by their old values. This costs the memory
+    // of those values, strings and binaries included, for as long as incremental sync is enabled.
+    void set_incremental_sync(bool enable);
+    bool get_incremental_sync() const noexcept
+    {
+        return m_incremental_sync;
+    }
+
     // Return the version of the source it was created from.
     TableVersions get_dependency_versions() const
     {
@@ -384,8 +402,21 @@ protected:
 
     mutable TableVersions m_last_seen_versions;
 
+    bool m_incremental_sync = false;
+    // Whether the keys found by the query were in ascending order, which is how an unsorted view is patched
+    bool m_in_key_order = true;
+    // Version of the transaction the view was last synced in, if that was a read transaction
+    VersionID m_last_seen_db_version;
+    // The values of the sort columns at m_last_seen_db_version of each object in the view, if the view is sorted
+    std::unordered_map<ObjKey, SortDescriptor::Values> m_sort_values;
+
 private:
     KeyColumn m_table_view_key_values; // We should generally not use this name
+    bool do_incremental_sync();
+    // Returns false if the view must always be synced in full. Otherwise `sort` is set to the sort to keep up to
+    // date, or to null if the view is not sorted.
+    bool get_incremental_sort(const SortDescriptor*& sort) const;
+    void update_last_seen_db_version();
     ObjKey find_first_integer(ColKey column_key, int64_t value) const;
     template <class oper>
     Timestamp minmax_timestamp(ColKey column_key, ObjKey* return_key) const;
@@ -543,6 +574,10 @@ inline ConstTableView::ConstTableView(const ConstTableView& tv)
     , m_end(tv.m_end)
     , m_limit(tv.m_limit)
     , m_last_seen_versions(tv.m_last_seen_versions)
+    , m_incremental_sync(tv.m_incremental_sync)
+    , m_in_key_order(tv.m_in_key_order)
+    , m_last_seen_db_version(tv.m_last_seen_db_version)
+    , m_sort_values(tv.m_sort_values)
     , m_table_view_key_values(tv.m_table_view_key_values)
 {
     m_limit_count = tv.m_limit_count;
@@ -563,6 +598,10 @@ inline ConstTableView::ConstTableView(ConstTableView&& tv) noexcept
     // if we are created from a table view which is outdated, take care to use the outdated
     // version number so that we can later trigger a sync if needed.
     , m_last_seen_versions(std::move(tv.m_last_seen_versions))
+    , m_incremental_sync(tv.m_incremental_sync)
+    , m_in_key_order(tv.m_in_key_order)
+    , m_last_seen_db_version(tv.m_last_seen_db_version)
+    , m_sort_values(std::move(tv.m_sort_values))
     , m_table_view_key_values(std::move(tv.m_table_view_key_values))
 {
     m_limit_count = tv.m_limit_count;
@@ -585,6 +624,10 @@ inline ConstTableView& ConstTableView::operator=(ConstTableView&& tv) noexcept
     m_linklist_source = std::move(tv.m_linklist_source);
     m_descriptor_ordering = std::move(tv.m_descriptor_ordering);
     m_distinct_column_source = tv.m_distinct_column_source;
+    m_incremental_sync = tv.m_incremental_sync;
+    m_in_key_order = tv.m_in_key_order;
+    m_last_seen_db_version = tv.m_last_seen_db_version;
+    m_sort_values = std::move(tv.m_sort_values);
 
     return *this;
 }
@@ -608,6 +651,10 @@ inline ConstTableView& ConstTableView::operator=(const ConstTableView& tv)
     m_linklist_source = tv.m_linklist_source ? tv.m_linklist_source->clone() : LnkLstPtr{};
     m_descriptor_ordering = tv.m_descriptor_ordering;
     m_distinct_column_source = tv.m_distinct_column_source;
+    m_incremental_sync = tv.m_incremental_sync;
+    m_in_key_order = tv.m_in_key_order;
+    m_last_seen_db_version = tv.m_last_seen_db_version;
+    m_sort_values = tv.m_sort_values;
 
     return *this;
 }
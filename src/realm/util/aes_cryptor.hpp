@@ -32,8 +32,10 @@
 #include <stdio.h>
 #include <bcrypt.h>
 #pragma comment(lib, "bcrypt.lib")
+// 224-bit AES-2 from https://github.com/kalven/sha-2 - Public Domain. Native API
+// does not exist for 224 bits (only 128, 256, etc).
+#include <win32/kalven-sha2/sha224.hpp>
 #else
-#include <openssl/sha.h>
 #include <openssl/evp.h>
 #endif
 
@@ -43,14 +45,54 @@ namespace util {
 struct iv_table;
 class EncryptedFileMapping;
 
+/// The HMAC-SHA224 which authenticates the blocks of encrypted files. The
+/// hash states after the padded key has been taken in are computed once, so
+/// each block only costs the hashing of its own data. With OpenSSL the
+/// hashing goes through the EVP interface, which uses the SHA extensions of
+/// the CPU where they are available.
+class HmacSha224 {
+public:
+    static constexpr size_t digest_size = 28;
+
+    /// \a key is 32 bytes.
+    explicit HmacSha224(const uint8_t* key);
+    ~HmacSha224() noexcept;
+
+    HmacSha224(const HmacSha224&) = delete;
+    HmacSha224& operator=(const HmacSha224&) = delete;
+
+    /// Write the digest_size bytes of the HMAC of \a src to \a dst.
+    void calc(const void* src, size_t len, uint8_t* dst);
+    /// Check, in constant time, that \a hmac is the HMAC of \a src.
+    bool check(const void* src, size_t len, const uint8_t* hmac);
+
+private:
+#if REALM_PLATFORM_APPLE
+    CCHmacContext m_keyed;
+#elif defined(_WIN32)
+    sha224_state m_inner;
+    sha224_state m_outer;
+#else
+    EVP_MD_CTX* m_inner;
+    EVP_MD_CTX* m_outer;
+    EVP_MD_CTX* m_ctx;
+#endif
+};
+
 class AESCryptor {
 public:
     AESCryptor(const uint8_t* key);
     ~AESCryptor() noexcept;
 
+    /// Must be called before the first read() or write().
     void set_file_size(off_t new_size);
 
+    /// Read and decrypt the blocks of \a size bytes of data at \a pos.
+    /// Blocks which have never been written are left unmodified. Returns
+    /// false if any of them could not be read. The decryption of long runs of
+    /// blocks is shared with the threads set by set_decryption_threads().
     bool read(FileDesc fd, off_t pos, char* dst, size_t size);
+    /// Encrypt and write the blocks of \a size bytes of data at \a pos.
     void write(FileDesc fd, off_t pos, const char* src, size_t size) noexcept;
 
 private:
@@ -77,13 +119,17 @@ private:
     EVP_CIPHER_CTX* m_ctx;
 #endif
 
-    uint8_t m_hmacKey[32];
+    HmacSha224 m_hmac;
     std::vector<iv_table> m_iv_buffer;
     std::unique_ptr<char[]> m_rw_buffer;
     std::unique_ptr<char[]> m_dst_buffer;
+    // The key is kept to create the cryptors used by the decryption threads,
+    // one per thread, as the cipher state cannot be shared between them
+    uint8_t m_key[64];
+    std::vector<std::unique_ptr<AESCryptor>> m_helpers;
 
-    void calc_hmac(const void* src, size_t len, uint8_t* dst, const uint8_t* key) const;
-    bool check_hmac(const void* data, size_t len, const uint8_t* hmac) const;
+    bool decrypt_blocks(FileDesc fd, off_t pos, char* dst, const char* src, size_t size);
+    bool decrypt_block(off_t pos, char* dst, const char* src, size_t size, iv_table& iv);
     void crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept;
     iv_table& get_iv_table(FileDesc fd, off_t data_pos) noexcept;
     void handle_error();
@@ -105,6 +151,14 @@ struct SharedFileInfo {
     size_t progress_index = 0;
     std::vector<ReaderInfo> readers;
 
+    // The number of decrypted pages the page reclaimer keeps the file to, 0 for no limit
+    size_t page_budget = 0;
+    // Pages found decrypted by read barriers, pages decrypted, and pages
+    // taken back by the page reclaimer
+    uint64_t num_page_hits = 0;
+    uint64_t num_page_decryptions = 0;
+    uint64_t num_page_evictions = 0;
+
     SharedFileInfo(const uint8_t* key, FileDesc file_descriptor);
 };
 }
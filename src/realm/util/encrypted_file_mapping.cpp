@@ -23,8 +23,12 @@
 #if REALM_ENABLE_ENCRYPTION
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
 #include <stdexcept>
 #include <system_error>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <cstdio>
@@ -35,18 +39,19 @@
 
 #if defined(_WIN32)
 #include <Windows.h>
-// 224-bit AES-2 from https://github.com/kalven/sha-2 - Public Domain. Native API
-// does not exist for 224 bits (only 128, 256, etc).
-#include <win32/kalven-sha2/sha224.hpp>
 #include <bcrypt.h>
 #else
+#include <cerrno>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <pthread.h>
 #endif
 
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/errno.hpp>
 #include <realm/util/terminate.hpp>
+#include <realm/util/worker_pool.hpp>
+#include <realm/exceptions.hpp>
 
 namespace realm {
 namespace util {
@@ -123,29 +128,192 @@ off_t iv_table_pos(off_t pos)
     return off_t(metadata_block * (blocks_per_metadata_block + 1) * block_size + metadata_index * metadata_size);
 }
 
+// The number of data blocks which are contiguous in the file, starting with
+// the block at the given data position, capped at `max_blocks`
+size_t contiguous_blocks(off_t pos, size_t max_blocks)
+{
+    size_t index = static_cast<size_t>(pos) / block_size;
+    size_t rest_of_group = blocks_per_metadata_block - index % blocks_per_metadata_block;
+    return std::min(rest_of_group, max_blocks);
+}
+
+// Positioned reads and writes leave the file offset alone, and need a single
+// system call instead of three
 void check_write(FileDesc fd, off_t pos, const void* data, size_t len)
 {
+#ifdef _WIN32
     uint64_t orig = File::get_file_pos(fd);
     File::seek_static(fd, pos);
     File::write_static(fd, static_cast<const char*>(data), len);
     File::seek_static(fd, orig);
+#else
+    const char* src = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t r = ::pwrite(fd, src, len, pos);
+        if (r < 0) {
+            int err = errno; // Eliminate any risk of clobbering
+            if (err == EINTR)
+                continue;
+            if (err == ENOSPC || err == EDQUOT)
+                throw OutOfDiskSpace(get_errno_msg("pwrite() failed: ", err));
+            throw std::system_error(err, std::system_category(), "pwrite() failed");
+        }
+        REALM_ASSERT_RELEASE(r != 0);
+        src += r;
+        pos += r;
+        len -= size_t(r);
+    }
+#endif
 }
 
 size_t check_read(FileDesc fd, off_t pos, void* dst, size_t len)
 {
+#ifdef _WIN32
     uint64_t orig = File::get_file_pos(fd);
     File::seek_static(fd, pos);
     size_t ret = File::read_static(fd, static_cast<char*>(dst), len);
     File::seek_static(fd, orig);
     return ret;
+#else
+    char* data = static_cast<char*>(dst);
+    size_t total = 0;
+    while (total < len) {
+        ssize_t r = ::pread(fd, data + total, len - total, pos + off_t(total));
+        if (r == 0)
+            break;
+        if (r < 0) {
+            int err = errno; // Eliminate any risk of clobbering
+            if (err == EINTR)
+                continue;
+            throw std::system_error(err, std::system_category(), "pread() failed");
+        }
+        total += size_t(r);
+    }
+    return total;
+#endif
 }
 
+// A run of blocks is only split over several threads if each of them gets
+// at least this many blocks to decrypt
+const size_t min_blocks_per_thread = 8;
+const unsigned max_decryption_threads = 7;
+
+// Pages are read ahead of an in-order access in windows starting at this size
+// and doubling up to the limit set by set_encryption_read_ahead()
+const size_t initial_read_ahead = 4;
+std::atomic<size_t> read_ahead_pages(32);
+
+// Threads which help the thread reading a long run of blocks with their
+// decryption. By default there is one thread fewer than there are cores, and
+// at most 3.
+unsigned default_decryption_threads()
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? std::min(cores, 4U) - 1 : 0;
+}
+
+WorkerPool decryption_workers(default_decryption_threads());
+
 } // anonymous namespace
 
+void set_decryption_threads(unsigned num_threads)
+{
+    decryption_workers.set_num_threads(std::min(num_threads, max_decryption_threads));
+}
+
+void set_encryption_read_ahead(size_t max_pages)
+{
+    read_ahead_pages = max_pages;
+}
+
+HmacSha224::HmacSha224(const uint8_t* key)
+{
+#if REALM_PLATFORM_APPLE
+    CCHmacInit(&m_keyed, kCCHmacAlgSHA224, key, 32);
+#else
+    // HMAC(data) is sha224(opad + sha224(ipad + data)), where ipad and opad are
+    // the key padded to the block size of the hash and xored with a constant
+    uint8_t ipad[64];
+    uint8_t opad[64];
+    for (size_t i = 0; i < 32; ++i) {
+        ipad[i] = key[i] ^ 0x36;
+        opad[i] = key[i] ^ 0x5C;
+    }
+    memset(ipad + 32, 0x36, 32);
+    memset(opad + 32, 0x5C, 32);
+
+#ifdef _WIN32
+    sha_init(m_inner);
+    sha_process(m_inner, ipad, 64);
+    sha_init(m_outer);
+    sha_process(m_outer, opad, 64);
+#else
+    m_inner = EVP_MD_CTX_new();
+    m_outer = EVP_MD_CTX_new();
+    m_ctx = EVP_MD_CTX_new();
+    bool ok = m_inner && m_outer && m_ctx;
+    ok = ok && EVP_DigestInit_ex(m_inner, EVP_sha224(), nullptr) && EVP_DigestUpdate(m_inner, ipad, 64);
+    ok = ok && EVP_DigestInit_ex(m_outer, EVP_sha224(), nullptr) && EVP_DigestUpdate(m_outer, opad, 64);
+    if (!ok) {
+        EVP_MD_CTX_free(m_inner);
+        EVP_MD_CTX_free(m_outer);
+        EVP_MD_CTX_free(m_ctx);
+        throw std::runtime_error("Error occurred in encryption layer");
+    }
+#endif
+#endif
+}
+
+HmacSha224::~HmacSha224() noexcept
+{
+#if !REALM_PLATFORM_APPLE && !defined(_WIN32)
+    EVP_MD_CTX_free(m_inner);
+    EVP_MD_CTX_free(m_outer);
+    EVP_MD_CTX_free(m_ctx);
+#endif
+}
+
+void HmacSha224::calc(const void* src, size_t len, uint8_t* dst)
+{
+#if REALM_PLATFORM_APPLE
+    CCHmacContext ctx = m_keyed;
+    CCHmacUpdate(&ctx, src, len);
+    CCHmacFinal(&ctx, dst);
+#elif defined(_WIN32)
+    sha224_state s = m_inner;
+    sha_process(s, src, uint32_t(len));
+    sha_done(s, dst);
+    s = m_outer;
+    sha_process(s, dst, uint32_t(digest_size));
+    sha_done(s, dst);
+#else
+    unsigned int size;
+    bool ok = EVP_MD_CTX_copy_ex(m_ctx, m_inner) && EVP_DigestUpdate(m_ctx, src, len) &&
+              EVP_DigestFinal_ex(m_ctx, dst, &size);
+    ok = ok && EVP_MD_CTX_copy_ex(m_ctx, m_outer) && EVP_DigestUpdate(m_ctx, dst, digest_size) &&
+         EVP_DigestFinal_ex(m_ctx, dst, &size);
+    if (!ok)
+        throw std::runtime_error("Error occurred in encryption layer");
+#endif
+}
+
+bool HmacSha224::check(const void* src, size_t len, const uint8_t* hmac)
+{
+    uint8_t buffer[digest_size];
+    calc(src, len, buffer);
+
+    // Constant-time memcmp to avoid timing attacks
+    uint8_t result = 0;
+    for (size_t i = 0; i < digest_size; ++i)
+        result |= buffer[i] ^ hmac[i];
+    return result == 0;
+}
+
 AESCryptor::AESCryptor(const uint8_t* key)
-    : m_rw_buffer(new char[block_size]),
-      m_dst_buffer(new char[block_size])
+    : m_hmac(key + 32)
+    , m_dst_buffer(new char[block_size])
 {
+    memcpy(m_key, key, 64);
 #if REALM_PLATFORM_APPLE
     // A random iv is passed to CCCryptorReset. This iv is *not used* by Realm; we set it manually prior to
     // each call to BCryptEncrypt() and BCryptDecrypt(). We pass this random iv as an attempt to 
@@ -175,7 +343,6 @@ AESCryptor::AESCryptor(const uint8_t* key)
 
     memcpy(m_aesKey, key, 32);
 #endif
-    memcpy(m_hmacKey, key + 32, 32);
 }
 
 AESCryptor::~AESCryptor() noexcept
@@ -201,6 +368,10 @@ void AESCryptor::set_file_size(off_t new_size)
     size_t new_size_casted = size_t(new_size);
     size_t block_count = (new_size_casted + block_size - 1) / block_size;
     m_iv_buffer.reserve((block_count + blocks_per_metadata_block - 1) & ~(blocks_per_metadata_block - 1));
+    // Allocated here rather than in the constructor, as the cryptors of the
+    // decryption threads only decrypt blocks that have already been read
+    if (!m_rw_buffer)
+        m_rw_buffer.reset(new char[blocks_per_metadata_block * block_size]); // Throws
 }
 
 iv_table& AESCryptor::get_iv_table(FileDesc fd, off_t data_pos) noexcept
@@ -225,81 +396,121 @@ iv_table& AESCryptor::get_iv_table(FileDesc fd, off_t data_pos) noexcept
     return m_iv_buffer[idx];
 }
 
-bool AESCryptor::check_hmac(const void* src, size_t len, const uint8_t* hmac) const
-{
-    uint8_t buffer[224 / 8];
-    calc_hmac(src, len, buffer, m_hmacKey);
-
-    // Constant-time memcmp to avoid timing attacks
-    uint8_t result = 0;
-    for (size_t i = 0; i < 224 / 8; ++i)
-        result |= buffer[i] ^ hmac[i];
-    return result == 0;
-}
-
 bool AESCryptor::read(FileDesc fd, off_t pos, char* dst, size_t size)
 {
     REALM_ASSERT(size % block_size == 0);
+    bool all_read = true;
     while (size > 0) {
-        ssize_t bytes_read = check_read(fd, real_offset(pos), m_rw_buffer.get(), block_size);
-
+        // The blocks up to the next metadata block are read at once
+        size_t num_blocks = contiguous_blocks(pos, size / block_size);
+        size_t bytes_read = check_read(fd, real_offset(pos), m_rw_buffer.get(), num_blocks * block_size);
         if (bytes_read == 0)
             return false;
 
-        iv_table& iv = get_iv_table(fd, pos);
-        if (iv.iv1 == 0) {
-            // This block has never been written to, so we've just read pre-allocated
-            // space. No memset() since the code using this doesn't rely on
-            // pre-allocated space being zeroed.
+        if (!decrypt_blocks(fd, pos, dst, m_rw_buffer.get(), bytes_read))
+            all_read = false;
+        if (bytes_read < num_blocks * block_size)
             return false;
+        pos += off_t(num_blocks * block_size);
+        dst += num_blocks * block_size;
+        size -= num_blocks * block_size;
+    }
+    return all_read;
+}
+
+bool AESCryptor::decrypt_blocks(FileDesc fd, off_t pos, char* dst, const char* src, size_t size)
+{
+    // The blocks are all covered by the same block of IVs, which is loaded
+    // before any threads are involved
+    iv_table* first_iv = &get_iv_table(fd, pos);
+    size_t num_blocks = (size + block_size - 1) / block_size;
+    auto decrypt = [&](AESCryptor& cryptor, size_t begin, size_t end) {
+        bool all_read = true;
+        for (size_t i = begin; i < end; ++i) {
+            size_t offset = i * block_size;
+            size_t block_bytes = std::min(size - offset, block_size);
+            if (!cryptor.decrypt_block(pos + off_t(offset), dst + offset, src + offset, block_bytes, first_iv[i]))
+                all_read = false;
         }
+        return all_read;
+    };
 
-        if (!check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac1)) {
-            // Either the DB is corrupted or we were interrupted between writing the
-            // new IV and writing the data
-            if (iv.iv2 == 0) {
-                // Very first write was interrupted
-                return false;
-            }
+    size_t num_parts = std::min(size_t(decryption_workers.num_threads()) + 1, num_blocks / min_blocks_per_thread);
+    if (num_parts <= 1)
+        return decrypt(*this, 0, num_blocks);
+
+    while (m_helpers.size() < num_parts - 1)
+        m_helpers.emplace_back(new AESCryptor(m_key)); // Throws
+    bool all_read[max_decryption_threads + 1];
+    std::exception_ptr errors[max_decryption_threads + 1];
+    decryption_workers.run(num_parts, [&](size_t part) {
+        AESCryptor& cryptor = part == 0 ? *this : *m_helpers[part - 1];
+        try {
+            all_read[part] = decrypt(cryptor, num_blocks * part / num_parts, num_blocks * (part + 1) / num_parts);
+        }
+        catch (...) {
+            errors[part] = std::current_exception();
+        }
+    });
+    bool result = true;
+    for (size_t part = 0; part < num_parts; ++part) {
+        if (errors[part])
+            std::rethrow_exception(errors[part]);
+        result = result && all_read[part];
+    }
+    return result;
+}
 
-            if (check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac2)) {
-                // Un-bump the IV since the write with the bumped IV never actually
-                // happened
-                memcpy(&iv.iv1, &iv.iv2, 32);
-            }
-            else {
-                // If the file has been shrunk and then re-expanded, we may have
-                // old hmacs that don't go with this data. ftruncate() is
-                // required to fill any added space with zeroes, so assume that's
-                // what happened if the buffer is all zeroes
-                for (ssize_t i = 0; i < bytes_read; ++i) {
-                    if (m_rw_buffer[i] != 0)
-                        throw DecryptionFailed();
-                }
-                return false;
-            }
+bool AESCryptor::decrypt_block(off_t pos, char* dst, const char* src, size_t size, iv_table& iv)
+{
+    if (iv.iv1 == 0) {
+        // This block has never been written to, so we've just read pre-allocated
+        // space. No memset() since the code using this doesn't rely on
+        // pre-allocated space being zeroed.
+        return false;
+    }
+
+    if (!m_hmac.check(src, size, iv.hmac1)) {
+        // Either the DB is corrupted or we were interrupted between writing the
+        // new IV and writing the data
+        if (iv.iv2 == 0) {
+            // Very first write was interrupted
+            return false;
         }
 
-        // We may expect some adress ranges of the destination buffer of
-        // AESCryptor::read() to stay unmodified, i.e. being overwritten with
-        // the same bytes as already present, and may have read-access to these
-        // from other threads while decryption is taking place.
-        //
-        // However, some implementations of AES_cbc_encrypt(), in particular
-        // OpenSSL, will put garbled bytes as an intermediate step during the
-        // operation which will lead to incorrect data being read by other
-        // readers concurrently accessing that page. Incorrect data leads to
-        // crashes.
-        //
-        // We therefore decrypt to a temporary buffer first and then copy the
-        // completely decrypted data after.
-        crypt(mode_Decrypt, pos, m_dst_buffer.get(), m_rw_buffer.get(), reinterpret_cast<const char*>(&iv.iv1));
-        memcpy(dst, m_dst_buffer.get(), block_size);
-
-        pos += block_size;
-        dst += block_size;
-        size -= block_size;
+        if (m_hmac.check(src, size, iv.hmac2)) {
+            // Un-bump the IV since the write with the bumped IV never actually
+            // happened
+            memcpy(&iv.iv1, &iv.iv2, 32);
+        }
+        else {
+            // If the file has been shrunk and then re-expanded, we may have
+            // old hmacs that don't go with this data. ftruncate() is
+            // required to fill any added space with zeroes, so assume that's
+            // what happened if the buffer is all zeroes
+            for (size_t i = 0; i < size; ++i) {
+                if (src[i] != 0)
+                    throw DecryptionFailed();
+            }
+            return false;
+        }
     }
+
+    // We may expect some adress ranges of the destination buffer of
+    // AESCryptor::read() to stay unmodified, i.e. being overwritten with
+    // the same bytes as already present, and may have read-access to these
+    // from other threads while decryption is taking place.
+    //
+    // However, some implementations of AES_cbc_encrypt(), in particular
+    // OpenSSL, will put garbled bytes as an intermediate step during the
+    // operation which will lead to incorrect data being read by other
+    // readers concurrently accessing that page. Incorrect data leads to
+    // crashes.
+    //
+    // We therefore decrypt to a temporary buffer first and then copy the
+    // completely decrypted data after.
+    crypt(mode_Decrypt, pos, m_dst_buffer.get(), src, reinterpret_cast<const char*>(&iv.iv1));
+    memcpy(dst, m_dst_buffer.get(), block_size);
     return true;
 }
 
@@ -307,28 +518,36 @@ void AESCryptor::write(FileDesc fd, off_t pos, const char* src, size_t size) noe
 {
     REALM_ASSERT(size % block_size == 0);
     while (size > 0) {
-        iv_table& iv = get_iv_table(fd, pos);
-
-        memcpy(&iv.iv2, &iv.iv1, 32);
-        do {
-            ++iv.iv1;
-            // 0 is reserved for never-been-used, so bump if we just wrapped around
-            if (iv.iv1 == 0)
+        // The blocks up to the next metadata block are encrypted first, then
+        // their IVs are written in one go, followed by the blocks themselves
+        size_t num_blocks = contiguous_blocks(pos, size / block_size);
+        iv_table* first_iv = &get_iv_table(fd, pos);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            off_t block_pos = pos + off_t(i * block_size);
+            char* dst = m_rw_buffer.get() + i * block_size;
+            iv_table& iv = first_iv[i];
+
+            memcpy(&iv.iv2, &iv.iv1, 32);
+            do {
                 ++iv.iv1;
+                // 0 is reserved for never-been-used, so bump if we just wrapped around
+                if (iv.iv1 == 0)
+                    ++iv.iv1;
+
+                crypt(mode_Encrypt, block_pos, dst, src + i * block_size, reinterpret_cast<const char*>(&iv.iv1));
+                m_hmac.calc(dst, block_size, iv.hmac1);
+                // In the extremely unlikely case that both the old and new versions have
+                // the same hash we won't know which IV to use, so bump the IV until
+                // they're different.
+            } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
+        }
 
-            crypt(mode_Encrypt, pos, m_rw_buffer.get(), src, reinterpret_cast<const char*>(&iv.iv1));
-            calc_hmac(m_rw_buffer.get(), block_size, iv.hmac1, m_hmacKey);
-            // In the extremely unlikely case that both the old and new versions have
-            // the same hash we won't know which IV to use, so bump the IV until
-            // they're different.
-        } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
-
-        check_write(fd, iv_table_pos(pos), &iv, sizeof(iv));
-        check_write(fd, real_offset(pos), m_rw_buffer.get(), block_size);
+        check_write(fd, iv_table_pos(pos), first_iv, num_blocks * sizeof(iv_table));
+        check_write(fd, real_offset(pos), m_rw_buffer.get(), num_blocks * block_size);
 
-        pos += block_size;
-        src += block_size;
-        size -= block_size;
+        pos += off_t(num_blocks * block_size);
+        src += num_blocks * block_size;
+        size -= num_blocks * block_size;
     }
 }
 
@@ -384,49 +603,6 @@ void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* sr
 #endif
 }
 
-void AESCryptor::calc_hmac(const void* src, size_t len, uint8_t* dst, const uint8_t* key) const
-{
-#if REALM_PLATFORM_APPLE
-    CCHmac(kCCHmacAlgSHA224, key, 32, src, len, dst);
-#else
-    uint8_t ipad[64];
-    for (size_t i = 0; i < 32; ++i)
-        ipad[i] = key[i] ^ 0x36;
-    memset(ipad + 32, 0x36, 32);
-
-    uint8_t opad[64] = {0};
-    for (size_t i = 0; i < 32; ++i)
-        opad[i] = key[i] ^ 0x5C;
-    memset(opad + 32, 0x5C, 32);
-
-    // Full hmac operation is sha224(opad + sha224(ipad + data))
-#ifdef _WIN32
-    sha224_state s;
-    sha_init(s);
-    sha_process(s, ipad, 64);
-    sha_process(s, static_cast<const uint8_t*>(src), uint32_t(len));
-    sha_done(s, dst);
-
-    sha_init(s);
-    sha_process(s, opad, 64);
-    sha_process(s, dst, 28); // 28 == SHA224_DIGEST_LENGTH
-    sha_done(s, dst);
-#else
-    SHA256_CTX ctx;
-    SHA224_Init(&ctx);
-    SHA256_Update(&ctx, ipad, 64);
-    SHA256_Update(&ctx, static_cast<const uint8_t*>(src), len);
-    SHA256_Final(dst, &ctx);
-
-    SHA224_Init(&ctx);
-    SHA256_Update(&ctx, opad, 64);
-    SHA256_Update(&ctx, dst, SHA224_DIGEST_LENGTH);
-    SHA256_Final(dst, &ctx);
-#endif
-
-#endif
-}
-
 EncryptedFileMapping::EncryptedFileMapping(SharedFileInfo& file, size_t file_offset, void* addr, size_t size,
                                            File::AccessMode access)
     : m_file(file)
@@ -498,21 +674,65 @@ bool EncryptedFileMapping::copy_up_to_date_page(size_t local_page_ndx) noexcept
     return false;
 }
 
-void EncryptedFileMapping::refresh_page(size_t local_page_ndx)
+void EncryptedFileMapping::refresh_pages(size_t begin, size_t end)
 {
-    REALM_ASSERT_EX(local_page_ndx < m_page_state.size(), local_page_ndx, m_page_state.size());
+    REALM_ASSERT_EX(end <= m_page_state.size(), end, m_page_state.size());
+
+    // Pages which are up to date in another mapping are copied from there,
+    // and each run of the others is read and decrypted with a single call
+    auto read_pages = [&](size_t first, size_t last) {
+        if (first == last)
+            return;
+        m_file.num_page_decryptions += last - first;
+        size_t page_ndx_in_file = first + m_first_page;
+        m_file.cryptor.read(m_file.fd, off_t(page_ndx_in_file << m_page_shift), page_addr(first),
+                            (last - first) << m_page_shift);
+    };
+    size_t run_begin = begin;
+    for (size_t local_page_ndx = begin; local_page_ndx < end; ++local_page_ndx) {
+        if (copy_up_to_date_page(local_page_ndx)) {
+            read_pages(run_begin, local_page_ndx);
+            run_begin = local_page_ndx + 1;
+        }
+    }
+    read_pages(run_begin, end);
 
-    char* addr = page_addr(local_page_ndx);
+    for (size_t local_page_ndx = begin; local_page_ndx < end; ++local_page_ndx) {
+        if (is_not(m_page_state[local_page_ndx], UpToDate | PartiallyUpToDate))
+            m_num_decrypted++;
+        clear(m_page_state[local_page_ndx], PartiallyUpToDate);
+        set(m_page_state[local_page_ndx], UpToDate);
+    }
+}
 
-    if (!copy_up_to_date_page(local_page_ndx)) {
-        size_t page_ndx_in_file = local_page_ndx + m_first_page;
-        m_file.cryptor.read(m_file.fd, off_t(page_ndx_in_file << m_page_shift),
-                            addr, static_cast<size_t>(1ULL << m_page_shift));
+void EncryptedFileMapping::load_pages(size_t begin, size_t end)
+{
+    // The first pages may have been read ahead since the caller looked at them
+    while (begin < end && is(m_page_state[begin], UpToDate))
+        ++begin;
+    if (begin == end)
+        return;
+
+    // Loads which start where the previous one ended read ahead, in windows
+    // which double in size as long as that goes on. Pages read ahead are not
+    // marked as touched, so the reclaimer may take them back if they are
+    // never used.
+    size_t max_read_ahead = read_ahead_pages.load(std::memory_order_relaxed);
+    size_t load_end = end;
+    if (begin == m_sequential_end && max_read_ahead > 0) {
+        m_read_ahead = std::min(m_read_ahead == 0 ? initial_read_ahead : 2 * m_read_ahead, max_read_ahead);
+        size_t limit = std::min(end + m_read_ahead, m_page_state.size());
+        while (load_end < limit && is_not(m_page_state[load_end], UpToDate))
+            ++load_end;
+        for (size_t chunk_ndx = end >> page_to_chunk_shift; chunk_ndx << page_to_chunk_shift < load_end;
+             ++chunk_ndx)
+            m_chunk_dont_scan[chunk_ndx] = 0;
+    }
+    else {
+        m_read_ahead = 0;
     }
-    if (is_not(m_page_state[local_page_ndx], UpToDate | PartiallyUpToDate))
-        m_num_decrypted++;
-    clear(m_page_state[local_page_ndx], PartiallyUpToDate);
-    set(m_page_state[local_page_ndx], UpToDate);
+    refresh_pages(begin, load_end);
+    m_sequential_end = load_end;
 }
 
 void EncryptedFileMapping::write_page(size_t local_page_ndx) noexcept
@@ -654,6 +874,7 @@ void EncryptedFileMapping::reclaim_untouched(size_t& progress_index, size_t& wor
                 clear(m_page_state[page_ndx], UpToDate | PartiallyUpToDate);
                 reclaim_page(page_ndx);
                 m_num_decrypted--;
+                ++m_file.num_page_evictions;
                 done_some_work();
             }
             contiguous_scan = false;
@@ -713,16 +934,23 @@ void EncryptedFileMapping::reclaim_untouched(size_t& progress_index, size_t& wor
 void EncryptedFileMapping::flush() noexcept
 {
     const size_t num_dirty_pages = m_page_state.size();
-    for (size_t local_page_ndx = 0; local_page_ndx < num_dirty_pages; ++local_page_ndx) {
+    size_t local_page_ndx = 0;
+    while (local_page_ndx < num_dirty_pages) {
         if (is_not(m_page_state[local_page_ndx], Dirty)) {
             validate_page(local_page_ndx);
+            ++local_page_ndx;
             continue;
         }
 
+        // Each run of dirty pages is encrypted and written with a single call
+        size_t end = local_page_ndx + 1;
+        while (end < num_dirty_pages && is(m_page_state[end], Dirty))
+            ++end;
         size_t page_ndx_in_file = local_page_ndx + m_first_page;
         m_file.cryptor.write(m_file.fd, off_t(page_ndx_in_file << m_page_shift), page_addr(local_page_ndx),
-                             static_cast<size_t>(1ULL << m_page_shift));
-        clear(m_page_state[local_page_ndx], Dirty);
+                             (end - local_page_ndx) << m_page_shift);
+        for (; local_page_ndx < end; ++local_page_ndx)
+            clear(m_page_state[local_page_ndx], Dirty);
     }
 
     validate();
@@ -798,7 +1026,9 @@ void EncryptedFileMapping::read_barrier(const void* addr, size_t size, Header_to
         if (is_not(ps, Touched))
             set(ps, Touched);
         if (is_not(ps, UpToDate))
-            refresh_page(first_accessed_local_page);
+            load_pages(first_accessed_local_page, first_accessed_local_page + 1);
+        else
+            ++m_file.num_page_hits;
     }
 
     // force the page reclaimer to look into pages in this chunk:
@@ -817,7 +1047,10 @@ void EncryptedFileMapping::read_barrier(const void* addr, size_t size, Header_to
     size_t pages_size = m_page_state.size();
 
     // We already checked first_accessed_local_page above, so we start the loop
-    // at first_accessed_local_page + 1 to check the following page.
+    // at first_accessed_local_page + 1 to check the following page. Runs of
+    // pages which are not up to date are refreshed together.
+    size_t run_begin = 0;
+    size_t run_end = 0;
     for (size_t idx = first_accessed_local_page + 1; idx <= last_idx && idx < pages_size; ++idx) {
 
         // force the page reclaimer to look into pages in this chunk
@@ -828,9 +1061,18 @@ void EncryptedFileMapping::read_barrier(const void* addr, size_t size, Header_to
         PageState& ps = m_page_state[idx];
         if (is_not(ps, Touched))
             set(ps, Touched);
-        if (is_not(ps, UpToDate))
-            refresh_page(idx);
+        if (is_not(ps, UpToDate)) {
+            if (run_end != idx) {
+                load_pages(run_begin, run_end);
+                run_begin = idx;
+            }
+            run_end = idx + 1;
+        }
+        else {
+            ++m_file.num_page_hits;
+        }
     }
+    load_pages(run_begin, run_end);
 }
 
 
@@ -849,6 +1091,8 @@ void EncryptedFileMapping::set(void* new_addr, size_t new_size, size_t new_file_
     size_t num_pages = new_size >> m_page_shift;
 
     m_num_decrypted = 0;
+    m_sequential_end = 0;
+    m_read_ahead = 0;
     m_page_state.clear();
     m_chunk_dont_scan.clear();
 
@@ -95,6 +95,11 @@ private:
     size_t m_first_page;
     size_t m_num_decrypted; // 1 for every page decrypted
 
+    // The page following the last ones loaded, where the next load starts if
+    // the access is in order, and the number of pages currently read ahead
+    size_t m_sequential_end = 0;
+    size_t m_read_ahead = 0;
+
     enum PageState {
         Touched = 1,           // a ref->ptr translation has taken place
         UpToDate = 2,          // the page is fully up to date
@@ -134,7 +139,11 @@ private:
 
     void mark_outdated(size_t local_page_ndx) noexcept;
     bool copy_up_to_date_page(size_t local_page_ndx) noexcept;
-    void refresh_page(size_t local_page_ndx);
+    // Refresh the pages from `begin` up to, but not including, `end`
+    void refresh_pages(size_t begin, size_t end);
+    // Refresh the pages like refresh_pages(), and the ones following them as
+    // well if the pages of the mapping are being accessed in order
+    void load_pages(size_t begin, size_t end);
     void write_page(size_t local_page_ndx) noexcept;
     void write_and_update_all(size_t local_page_ndx, size_t begin_offset, size_t end_offset) noexcept;
     void reclaim_page(size_t page_ndx);
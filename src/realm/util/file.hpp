@@ -376,9 +376,21 @@ public:
         /// the default behavior. An explicit call to sync_map() will
         /// flush the buffers regardless of whether this flag is
         /// specified or not.
-        map_NoSync = 1
+        map_NoSync = 1,
+        /// Read the mapped part of the file into memory when it is mapped,
+        /// instead of on the first access to each page. This makes mapping
+        /// slower, but avoids page faults later on. Ignored for encrypted
+        /// files.
+        map_Populate = 2,
+        /// Ask the system to start reading the mapped part of the file into
+        /// memory in the background when it is mapped. Ignored for encrypted
+        /// files.
+        map_WillNeed = 4
     };
 
+    /// How a memory mapped file is expected to be accessed, see advise().
+    enum Advice { advice_Normal, advice_Random, advice_Sequential };
+
     /// Map this file into memory. The file is mapped as shared
     /// memory. This allows two processes to interact under exatly the
     /// same rules as applies to the interaction via regular memory of
@@ -427,6 +439,13 @@ public:
     /// previously returned by map().
     static void unmap(void* addr, size_t size) noexcept;
 
+    /// Tell the system how the specified address range, which must have
+    /// been returned by map(), is expected to be accessed. Sequential access
+    /// makes the system read further ahead, random access makes it read only
+    /// the pages which are accessed. This is only a hint, and has no effect
+    /// on systems that do not support it.
+    static void advise(void* addr, size_t size, Advice) noexcept;
+
     /// Flush in-kernel buffers to disk. This blocks the caller until
     /// the synchronization operation is complete. The specified
     /// address range must be (a subset of) one that was previously returned by
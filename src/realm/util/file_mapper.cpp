@@ -31,6 +31,7 @@
 #include <realm/util/errno.hpp>
 #include <realm/util/to_string.hpp>
 #include <realm/exceptions.hpp>
+#include <cstdint>
 #include <system_error>
 
 #if REALM_ENABLE_ENCRYPTION
@@ -75,6 +76,26 @@ inline bool is_mmap_memory_error(int err)
     return (err == EAGAIN || err == EMFILE || err == ENOMEM);
 }
 
+// Bring the given page aligned range of a file mapping into memory as requested by File::map_Populate or
+// File::map_WillNeed. Failing to do so only means that the pages are read on first access.
+void prefault(void* addr, size_t size, int map_flags) noexcept
+{
+#ifndef _WIN32
+    if (size == 0)
+        return;
+#ifdef MADV_POPULATE_READ
+    if ((map_flags & realm::util::File::map_Populate) && ::madvise(addr, size, MADV_POPULATE_READ) == 0)
+        return;
+#endif
+    if (map_flags & (realm::util::File::map_Populate | realm::util::File::map_WillNeed))
+        ::madvise(addr, size, MADV_WILLNEED);
+#else
+    static_cast<void>(addr);
+    static_cast<void>(size);
+    static_cast<void>(map_flags);
+#endif
+}
+
 } // Unnamed namespace
 
 using namespace realm;
@@ -300,6 +321,31 @@ decrypted_memory_stats_t get_decrypted_memory_stats()
     return retval;
 }
 
+decrypted_file_stats_t get_decrypted_file_stats(SharedFileInfo& info)
+{
+    UniqueLock lock(mapping_mutex);
+    size_t pages = 0;
+    for (auto& m : info.mappings)
+        pages += m->collect_decryption_count();
+    decrypted_file_stats_t stats;
+    stats.hits = info.num_page_hits;
+    stats.decryptions = info.num_page_decryptions;
+    stats.evictions = info.num_page_evictions;
+    stats.memory_size = pages * page_size();
+    return stats;
+}
+
+void set_decrypted_page_budget(SharedFileInfo& info, size_t bytes)
+{
+    if (bytes == 0)
+        return;
+    size_t pages = std::max<size_t>(bytes / page_size(), 1);
+    UniqueLock lock(mapping_mutex);
+    if (info.page_budget == 0 || pages < info.page_budget)
+        info.page_budget = pages;
+    ensure_reclaimer_thread_runs();
+}
+
 void encryption_note_reader_start(SharedFileInfo& info, const void* reader_id)
 {
     UniqueLock lock(mapping_mutex);
@@ -413,9 +459,24 @@ void reclaim_pages_for_file(SharedFileInfo& info, size_t& work_limit)
     }
 }
 
+// Reclaim pages of the files which have more decrypted pages than their
+// budget. The work limit allows for taking them some way below it, so that
+// they do not hover right at it.
+void reclaim_pages_over_budget() // must be called under lock
+{
+    for (auto& m : mappings_by_file) {
+        SharedFileInfo& info = *m.info;
+        if (info.page_budget == 0 || info.num_decrypted_pages <= info.page_budget)
+            continue;
+        size_t work_limit = info.num_decrypted_pages - info.page_budget + info.page_budget / 8 + 1;
+        reclaim_pages_for_file(info, work_limit);
+    }
+}
+
 // Reclaim pages from all files, limited by a work limit that is derived
 // from a target for the amount of dirty (decrypted) pages. The target is
-// set by the governor function.
+// set by the governor function. Files with a budget of their own are
+// brought within it first.
 void reclaim_pages()
 {
     size_t load;
@@ -433,6 +494,7 @@ void reclaim_pages()
     }
     {
         UniqueLock lock(mapping_mutex);
+        reclaim_pages_over_budget();
         reclaimer_workload = 0;
         reclaimer_target = size_t(target / page_size());
         // Putting the target back into the govenor object will allow the govenor
@@ -627,7 +689,7 @@ void remove_mapping(void* addr, size_t size)
 } // anonymous namespace
 
 void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
-           EncryptedFileMapping*& mapping)
+           EncryptedFileMapping*& mapping, int map_flags)
 {
     if (encryption_key) {
         size = round_up_to_page_size(size);
@@ -637,7 +699,7 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
     }
     else {
         mapping = nullptr;
-        return mmap(fd, size, access, offset, nullptr);
+        return mmap(fd, size, access, offset, nullptr, map_flags);
     }
 }
 
@@ -755,7 +817,8 @@ void* mmap_reserve(FileDesc fd, size_t reservation_size, size_t offset_in_file)
 }
 
 
-void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key)
+void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
+           int map_flags)
 {
 #if REALM_ENABLE_ENCRYPTION
     if (encryption_key) {
@@ -780,9 +843,18 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
                 break;
         }
 
-        void* addr = ::mmap(nullptr, size, prot, MAP_SHARED, fd, offset);
-        if (addr != MAP_FAILED)
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (map_flags & File::map_Populate) {
+            flags |= MAP_POPULATE;
+            map_flags = 0;
+        }
+#endif
+        void* addr = ::mmap(nullptr, size, prot, flags, fd, offset);
+        if (addr != MAP_FAILED) {
+            prefault(addr, size, map_flags);
             return addr;
+        }
 
         int err = errno; // Eliminate any risk of clobbering
         if (is_mmap_memory_error(err)) {
@@ -831,6 +903,46 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
     }
 }
 
+void madvise(void* addr, size_t size, File::Advice advice) noexcept
+{
+#ifndef _WIN32
+    int native_advice = MADV_NORMAL;
+    switch (advice) {
+        case File::advice_Normal:
+            break;
+        case File::advice_Random:
+            native_advice = MADV_RANDOM;
+            break;
+        case File::advice_Sequential:
+            native_advice = MADV_SEQUENTIAL;
+            break;
+    }
+    // Only a hint, so failure is ignored
+    ::madvise(addr, size, native_advice);
+#else
+    static_cast<void>(addr);
+    static_cast<void>(size);
+    static_cast<void>(advice);
+#endif
+}
+
+void madvise_huge_pages(void* addr, size_t size) noexcept
+{
+#ifdef MADV_HUGEPAGE
+    // Only whole huge pages inside the range can be backed by huge pages, so the advice is limited to them
+    const uintptr_t huge_page_size = 2 * 1024 * 1024;
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + huge_page_size - 1) & ~(huge_page_size - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + size) & ~(huge_page_size - 1);
+    if (begin >= end)
+        return;
+    // Only a hint, so failure is ignored
+    ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#else
+    static_cast<void>(addr);
+    static_cast<void>(size);
+#endif
+}
+
 void munmap(void* addr, size_t size)
 {
 #if REALM_ENABLE_ENCRYPTION
@@ -850,7 +962,7 @@ void munmap(void* addr, size_t size)
 }
 
 void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, File::AccessMode a, size_t new_size,
-             const char* encryption_key)
+             const char* encryption_key, int map_flags)
 {
 #if REALM_ENABLE_ENCRYPTION
     if (encryption_key) {
@@ -889,8 +1001,13 @@ void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, F
 #ifdef _GNU_SOURCE
     {
         void* new_addr = ::mremap(old_addr, old_size, new_size, MREMAP_MAYMOVE);
-        if (new_addr != MAP_FAILED)
+        if (new_addr != MAP_FAILED) {
+            // Only the part added to the mapping is brought into memory
+            size_t old_end = round_up_to_page_size(old_size);
+            if (new_size > old_end)
+                prefault(static_cast<char*>(new_addr) + old_end, new_size - old_end, map_flags);
             return new_addr;
+        }
         int err = errno; // Eliminate any risk of clobbering
         // Do not throw here if mremap is declared as "not supported" by the
         // platform Eg. When compiling with GNU libc on OSX, iOS.
@@ -907,7 +1024,7 @@ void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, F
     }
 #endif
 
-    void* new_addr = mmap(fd, new_size, a, file_offset, nullptr);
+    void* new_addr = mmap(fd, new_size, a, file_offset, nullptr, map_flags);
 
 #ifdef _WIN32
     if (!UnmapViewOfFile(old_addr))
@@ -29,15 +29,21 @@
 namespace realm {
 namespace util {
 
-void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key);
+void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
+           int map_flags = 0);
 void* mmap_fixed(FileDesc fd, void* address_request, size_t size, File::AccessMode access, size_t offset,
                  const char* enc_key);
 void* mmap_reserve(FileDesc fd, size_t size, size_t offset);
 void munmap(void* addr, size_t size);
 void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, File::AccessMode a, size_t new_size,
-             const char* encryption_key);
+             const char* encryption_key, int map_flags = 0);
 void msync(FileDesc fd, void* addr, size_t size);
 void* mmap_anon(size_t size);
+// Set the expected access pattern of a mapping, see File::advise()
+void madvise(void* addr, size_t size, File::Advice advice) noexcept;
+// Ask for the anonymous mapping at `addr` to be backed by huge pages, where supported. Only the 2 MB aligned
+// parts of the range are advised, so ranges holding no such part are left alone.
+void madvise_huge_pages(void* addr, size_t size) noexcept;
 
 // A function which may be given to encryption_read_barrier. If present, the read barrier is a
 // a barrier for a full array. If absent, the read barrier is a barrier only for the address
@@ -88,8 +94,35 @@ struct decrypted_memory_stats_t {
 
 decrypted_memory_stats_t get_decrypted_memory_stats();
 
+// The decrypted pages of one encrypted file, across all of its mappings in
+// this process. The counters are totals since the file was first mapped.
+struct decrypted_file_stats_t {
+    uint64_t hits;        // pages a read barrier found already decrypted
+    uint64_t decryptions; // pages decrypted
+    uint64_t evictions;   // pages taken back by the page reclaimer
+    size_t memory_size;   // memory used by the decrypted pages, in bytes
+};
+
 #if REALM_ENABLE_ENCRYPTION
 
+// Set the number of threads which help decrypting long runs of pages, such as
+// those read ahead. By default one less than the number of cores, at most 3.
+// 0 leaves the decryption to the reading thread.
+void set_decryption_threads(unsigned num_threads);
+
+// Set the largest number of pages an encrypted mapping reads ahead when its
+// pages are accessed in order. The default is 32. 0 turns read-ahead off.
+void set_encryption_read_ahead(size_t max_pages);
+
+decrypted_file_stats_t get_decrypted_file_stats(SharedFileInfo& info);
+
+// Have the page reclaimer keep the decrypted pages of the file within
+// `bytes`, independently of the target of the governor. Like for the target,
+// pages are released when they have not been accessed through a full sweep
+// of the reclaimer and no reader which was active before the sweep is left.
+// The smallest budget set for a file applies. 0 sets no budget.
+void set_decrypted_page_budget(SharedFileInfo& info, size_t bytes);
+
 void encryption_note_reader_start(SharedFileInfo& info, const void* reader_id);
 void encryption_note_reader_end(SharedFileInfo& info, const void* reader_id) noexcept;
 
@@ -98,7 +131,7 @@ SharedFileInfo* get_file_info_for_file(File& file);
 // This variant allows the caller to obtain direct access to the encrypted file mapping
 // for optimization purposes.
 void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
-           EncryptedFileMapping*& mapping);
+           EncryptedFileMapping*& mapping, int map_flags = 0);
 void* mmap_fixed(FileDesc fd, void* address_request, size_t size, File::AccessMode access, size_t offset,
                  const char* enc_key, EncryptedFileMapping* mapping);
 
@@ -150,6 +183,14 @@ size_t inline get_num_decrypted_pages()
     return 0;
 }
 
+void inline set_decryption_threads(unsigned)
+{
+}
+
+void inline set_encryption_read_ahead(size_t)
+{
+}
+
 void inline encryption_read_barrier(const void*, size_t, EncryptedFileMapping*, HeaderToSize = nullptr)
 {
 }
@@ -35,6 +35,7 @@
 
 #include <cerrno>
 #include <cstddef>
+#include <stdexcept>
 #include <string>
 
 #include <realm/util/features.h>
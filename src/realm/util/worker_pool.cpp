@@ -0,0 +1,112 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/util/worker_pool.hpp>
+
+using namespace realm::util;
+
+WorkerPool::WorkerPool(unsigned num_threads) noexcept
+    : m_num_threads(num_threads)
+{
+}
+
+WorkerPool::~WorkerPool() noexcept
+{
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+    stop_threads();
+}
+
+void WorkerPool::run(size_t num_parts, FunctionRef<void(size_t)> func)
+{
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+    do_run(num_parts, func); // Throws
+}
+
+bool WorkerPool::try_run(size_t num_parts, FunctionRef<void(size_t)> func)
+{
+    if (m_runner.load(std::memory_order_relaxed) == std::this_thread::get_id())
+        return false;
+    std::unique_lock<std::mutex> run_lock(m_run_mutex, std::try_to_lock);
+    if (!run_lock.owns_lock())
+        return false;
+    do_run(num_parts, func); // Throws
+    return true;
+}
+
+void WorkerPool::do_run(size_t num_parts, FunctionRef<void(size_t)> func)
+{
+    if (m_threads.size() != num_threads()) {
+        stop_threads();
+        start_threads(num_threads()); // Throws
+    }
+
+    m_runner = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_func = &func;
+    m_num_parts = num_parts;
+    m_next_part = 0;
+    m_parts_left = num_parts;
+    m_work_available.notify_all();
+    while (m_next_part < m_num_parts)
+        run_part(lock);
+    m_work_done.wait(lock, [&] {
+        return m_parts_left == 0;
+    });
+    m_func = nullptr;
+    m_runner = std::thread::id();
+}
+
+void WorkerPool::run_part(std::unique_lock<std::mutex>& lock)
+{
+    size_t part = m_next_part++;
+    lock.unlock();
+    (*m_func)(part);
+    lock.lock();
+    if (--m_parts_left == 0)
+        m_work_done.notify_all();
+}
+
+void WorkerPool::start_threads(unsigned num_threads)
+{
+    m_stop = false;
+    for (unsigned i = 0; i < num_threads; ++i) {
+        m_threads.emplace_back([this] { // Throws
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                m_work_available.wait(lock, [&] {
+                    return m_stop || m_next_part < m_num_parts;
+                });
+                if (m_stop)
+                    return;
+                run_part(lock);
+            }
+        });
+    }
+}
+
+void WorkerPool::stop_threads() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_available.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+}
@@ -0,0 +1,90 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_UTIL_WORKER_POOL_HPP
+#define REALM_UTIL_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <realm/util/function_ref.hpp>
+
+namespace realm {
+namespace util {
+
+/// Threads which help a thread with work split into parts. The parts are
+/// picked up by the workers and the calling thread itself, and a run returns
+/// once all of them are done. The workers are started by the first run and
+/// kept until the number of threads is changed or the pool is destroyed.
+/// Only one run is done at a time.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned num_threads) noexcept;
+    ~WorkerPool() noexcept;
+
+    unsigned num_threads() const noexcept
+    {
+        return m_num_threads.load(std::memory_order_relaxed);
+    }
+
+    /// Takes effect with the next run.
+    void set_num_threads(unsigned num_threads) noexcept
+    {
+        m_num_threads = num_threads;
+    }
+
+    /// Call func with each of 0 to num_parts - 1, on the workers and the
+    /// calling thread. func must not throw. Waits for the run of another
+    /// thread to complete first.
+    void run(size_t num_parts, FunctionRef<void(size_t)> func);
+
+    /// Same as run(), but returns false without calling func if another run
+    /// is in progress. Unlike run(), it can be called from a part of a run on
+    /// the same pool.
+    bool try_run(size_t num_parts, FunctionRef<void(size_t)> func);
+
+private:
+    std::atomic<unsigned> m_num_threads;
+    std::mutex m_run_mutex;
+    // The thread doing the current run, which must not try to lock m_run_mutex again
+    std::atomic<std::thread::id> m_runner;
+    std::vector<std::thread> m_threads;
+
+    // Protected by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_work_available;
+    std::condition_variable m_work_done;
+    const FunctionRef<void(size_t)>* m_func = nullptr;
+    size_t m_num_parts = 0;
+    size_t m_next_part = 0;
+    size_t m_parts_left = 0;
+    bool m_stop = false;
+
+    void do_run(size_t num_parts, FunctionRef<void(size_t)> func);
+    void run_part(std::unique_lock<std::mutex>& lock);
+    void start_threads(unsigned num_threads);
+    void stop_threads() noexcept;
+};
+
+} // namespace util
+} // namespace realm
+
+#endif // REALM_UTIL_WORKER_POOL_HPP
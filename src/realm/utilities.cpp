@@ -119,15 +119,36 @@ void cpuid_init()
     }
 #endif
 
+    bool avx2Supported = false;
     if (avxSupported) {
+        // AVX2 is reported in bit 5 of EBX for CPUID leaf 7, sub-leaf 0
+        int cret7;
+#ifdef _MSC_VER
+        __cpuidex(CPUInfo, 7, 0);
+        cret7 = CPUInfo[1];
+#else
+        __asm("mov $7, %%eax; "
+              "xor %%ecx, %%ecx; "
+              "cpuid;"
+              "mov %%ebx, %0;"                 // ebx into b
+              : "=r"(cret7)                    // output
+              :                                // input
+              : "%eax", "%ebx", "%ecx", "%edx" // clobbered register
+              );
+#endif
+        avx2Supported = cret7 & (1 << 5);
+    }
+
+    if (avx2Supported) {
+        avx_support = 1; // AVX2 supported
+    }
+    else if (avxSupported) {
         avx_support = 0; // AVX1 supported
     }
     else {
         avx_support = -1; // No AVX supported
     }
 
-// 1 is reserved for AVX2
-
 #endif
 }
 
@@ -67,7 +67,7 @@ typedef SSIZE_T ssize_t;
 #endif
 
 
-#if defined(REALM_PTR_64) && defined(REALM_X86_OR_X64) && !defined(REALM_WATCHOS)
+#if defined(REALM_PTR_64) && defined(REALM_X86_OR_X64) && !REALM_WATCHOS
 #define REALM_COMPILER_SSE // Compiler supports SSE 4.2 through __builtin_ accessors or back-end assembler
 #define REALM_COMPILER_AVX
 #endif
@@ -92,7 +92,7 @@ REALM_FORCEINLINE bool sseavx()
 
     avx_support = -1: No AVX support
     avx_support = 0: AVX1 supported
-    sse_support = 1: AVX2 supported (not yet implemented for detection in our cpuid_init(), todo)
+    avx_support = 1: AVX2 supported
 
     This lets us test very rapidly at runtime because we just need 1 compare instruction (with 0) to test both for
     SSE 3 and 4.2 by caller (compiler optimizes if calls are concecutive), and can decide branch with ja/jl/je because
@@ -182,6 +182,26 @@ inline int log2(size_t x)
 #endif
 }
 
+// count_trailing_zeros - returns the index of the least significant bit set in x, which must not be 0
+inline size_t count_trailing_zeros(uint64_t x)
+{
+    REALM_ASSERT_DEBUG(x != 0);
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#elif defined(_WIN32) && defined(REALM_PTR_64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, x);
+    return index;
+#else
+    size_t r = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        r++;
+    }
+    return r;
+#endif
+}
+
 // Implementation:
 
 // Safe cast from 64 to 32 bits on 32 bit architecture. Differs from to_ref() by not testing alignment and
@@ -1079,6 +1079,65 @@ struct BenchmarkQueryIntEqualityIndexed : BenchmarkQueryIntEquality {
     }
 };
 
+// Scans an integer column whose leaves all have the given bit width, to track the per-width throughput of the
+// vectorized Array::find() paths.
+template <size_t width>
+struct BenchmarkQueryIntWidth : BenchmarkWithIntsTable {
+    const size_t num_rows = BASE_SIZE * 5;
+    const char* name() const
+    {
+        switch (width) {
+            case 1:
+                return "QueryIntWidth1";
+            case 2:
+                return "QueryIntWidth2";
+            case 4:
+                return "QueryIntWidth4";
+            case 8:
+                return "QueryIntWidth8";
+            case 16:
+                return "QueryIntWidth16";
+            case 32:
+                return "QueryIntWidth32";
+            default:
+                return "QueryIntWidth64";
+        }
+    }
+
+    void before_all(DBRef group)
+    {
+        BenchmarkWithIntsTable::before_all(group);
+        WrtTrans tr(group);
+        TableRef t = tr.get_table(name());
+
+        // Widths below 8 bits are unsigned, the others hold both signs
+        const int64_t max_value = width < 8 ? (int64_t(1) << width) - 1 : int64_t(uint64_t(-1) >> (65 - width));
+        const int64_t min_value = width < 8 ? 0 : -max_value;
+        Random r;
+        for (size_t i = 0; i < num_rows; ++i) {
+            // Make sure every leaf is widened to the full width
+            int64_t val = (i % 256 == 0) ? max_value : r.draw_int<int64_t>(min_value, max_value);
+#ifdef REALM_CLUSTER_IF
+            t->create_object().set(m_col, val);
+#else
+            auto row = t->add_empty_row();
+            t->set_int(m_col, row, val);
+#endif
+        }
+        tr.commit();
+    }
+
+    void operator()(DBRef)
+    {
+        ConstTableRef table = m_table;
+        size_t matches = table->where().greater(m_col, 0).count();
+        matches += table->where().equal(m_col, 1).count();
+        matches += table->where().not_equal(m_col, 1).count();
+        REALM_ASSERT(matches >= num_rows);
+        static_cast<void>(matches);
+    }
+};
+
 struct BenchmarkQuery : BenchmarkWithStrings {
     const char* name() const
     {
@@ -1991,6 +2050,13 @@ int benchmark_common_tasks_main()
     BENCH(BenchmarkQueryChainedOrIntsIndexed);
     BENCH(BenchmarkQueryIntEquality);
     BENCH(BenchmarkQueryIntEqualityIndexed);
+    BENCH(BenchmarkQueryIntWidth<1>);
+    BENCH(BenchmarkQueryIntWidth<2>);
+    BENCH(BenchmarkQueryIntWidth<4>);
+    BENCH(BenchmarkQueryIntWidth<8>);
+    BENCH(BenchmarkQueryIntWidth<16>);
+    BENCH(BenchmarkQueryIntWidth<32>);
+    BENCH(BenchmarkQueryIntWidth<64>);
     BENCH(BenchmarkIntVsDoubleColumns);
     BENCH(BenchmarkQueryStringOverLinks);
     BENCH(BenchmarkQueryTimestampGreaterOverLinks);
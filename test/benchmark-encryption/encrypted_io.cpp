@@ -0,0 +1,137 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+// Measures how fast data is written to and read back from an encrypted file
+// through a mapping, for a range of sizes. Writing covers encrypting the pages
+// and flushing them to the file, reading covers decrypting them again through
+// a new mapping. Also measures the cost per 4 KB block of authenticating it
+// alone, and of encrypting and decrypting it, authentication and I/O
+// included.
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <realm/disable_sync_to_disk.hpp>
+#include <realm/util/aes_cryptor.hpp>
+#include <realm/util/file.hpp>
+#include <realm/util/file_mapper.hpp>
+#include <realm/util/to_string.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/test_path.hpp"
+#include "../util/crypt_key.hpp"
+#include "../util/benchmark_results.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+namespace {
+
+const size_t block_size = 4096;
+const size_t blocks_per_round = 1024;
+
+void bench_blocks(BenchmarkResults& results, int rounds)
+{
+    const uint8_t* key = reinterpret_cast<const uint8_t*>(crypt_key(true));
+    std::unique_ptr<char[]> data(new char[blocks_per_round * block_size]);
+    for (size_t i = 0; i < blocks_per_round * block_size; ++i)
+        data[i] = char(i % 251);
+
+    Timer timer(Timer::type_RealTime);
+    HmacSha224 hmac(key + 32);
+    uint8_t digest[HmacSha224::digest_size];
+    for (int round = 0; round < rounds; ++round) {
+        timer.reset();
+        for (size_t i = 0; i < blocks_per_round; ++i)
+            hmac.calc(data.get() + i * block_size, block_size, digest);
+        results.submit("hmac_block", timer.get_elapsed_time() / blocks_per_round);
+    }
+    results.finish("hmac_block", "HMAC block");
+
+    TestPathGuard path(get_test_path_prefix() + "benchmark_encrypted_blocks");
+    File file(path, File::mode_Write);
+    for (int round = 0; round < rounds; ++round) {
+        AESCryptor cryptor(key);
+        cryptor.set_file_size(off_t(blocks_per_round * block_size));
+        timer.reset();
+        for (size_t i = 0; i < blocks_per_round; ++i)
+            cryptor.write(file.get_descriptor(), off_t(i * block_size), data.get() + i * block_size, block_size);
+        results.submit("encrypt_block", timer.get_elapsed_time() / blocks_per_round);
+
+        AESCryptor reader(key);
+        reader.set_file_size(off_t(blocks_per_round * block_size));
+        timer.reset();
+        for (size_t i = 0; i < blocks_per_round; ++i)
+            reader.read(file.get_descriptor(), off_t(i * block_size), data.get() + i * block_size, block_size);
+        results.submit("decrypt_block", timer.get_elapsed_time() / blocks_per_round);
+    }
+    results.finish("encrypt_block", "Encrypt block");
+    results.finish("decrypt_block", "Decrypt block");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+    // Syncing would dominate the measurements
+    disable_sync_to_disk();
+
+    const size_t sizes[] = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024};
+    const int rounds = 5;
+
+    int max_lead_text_size = 22;
+    std::string results_file_stem = get_test_path_prefix() + "results";
+    BenchmarkResults results(max_lead_text_size, results_file_stem.c_str());
+
+    Timer timer(Timer::type_RealTime);
+    for (size_t size : sizes) {
+        TestPathGuard path(get_test_path_prefix() + "benchmark_encrypted_io_" + to_string(size));
+        std::string write_id = "write_" + to_string(size / 1024) + "k";
+        std::string read_id = "read_" + to_string(size / 1024) + "k";
+        for (int round = 0; round < rounds; ++round) {
+            {
+                File file(path, File::mode_Write);
+                file.set_encryption_key(crypt_key(true));
+                file.resize(size);
+                File::Map<char> map(file, File::access_ReadWrite, size);
+                encryption_read_barrier(map, 0, size);
+                memset(map.get_addr(), 'a' + round, size);
+                timer.reset();
+                encryption_write_barrier(map, 0, size);
+                map.sync();
+                results.submit(write_id.c_str(), timer);
+            }
+            {
+                File file(path, File::mode_Read);
+                file.set_encryption_key(crypt_key(true));
+                File::Map<char> map(file, File::access_ReadOnly, size);
+                timer.reset();
+                encryption_read_barrier(map, 0, size);
+                results.submit(read_id.c_str(), timer);
+            }
+        }
+        results.finish(write_id, "Write " + to_string(size / 1024) + " KB");
+        results.finish(read_id, "Read " + to_string(size / 1024) + " KB");
+    }
+
+    bench_blocks(results, rounds);
+}
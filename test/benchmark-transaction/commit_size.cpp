@@ -0,0 +1,94 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+// Measures the time it takes to commit a write transaction as a function of
+// the amount of data it changed. Only the commit is timed, not the changes.
+
+#include <iostream>
+#include <string>
+
+#include <realm.hpp>
+#include <realm/disable_sync_to_disk.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/test_path.hpp"
+#include "../util/benchmark_results.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+namespace {
+
+const int num_tables = 4;
+const size_t value_size = 256;
+
+// Add `size` bytes of string values, spread evenly over the tables
+void add_data(Transaction& tr, size_t size, size_t round)
+{
+    std::string value(value_size, char('a' + round % 26));
+    size_t objects_per_table = size / value_size / num_tables;
+    for (int i = 0; i < num_tables; ++i) {
+        std::string name = "table_" + to_string(i);
+        TableRef table = tr.get_table(name);
+        ColKey col = table->get_column_key("value");
+        for (size_t j = 0; j < objects_per_table; ++j)
+            table->create_object().set(col, StringData(value));
+    }
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+    // Syncing would dominate the measurements
+    disable_sync_to_disk();
+
+    const size_t commit_sizes[] = {64 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024};
+    const int rounds = 5;
+
+    int max_lead_text_size = 22;
+    std::string results_file_stem = get_test_path_prefix() + "results";
+    BenchmarkResults results(max_lead_text_size, results_file_stem.c_str());
+
+    Timer timer(Timer::type_RealTime);
+    for (size_t size : commit_sizes) {
+        SharedGroupTestPathGuard path("benchmark_commit_size_" + to_string(size));
+        DBRef db = DB::create(path);
+        {
+            auto tr = db->start_write();
+            for (int i = 0; i < num_tables; ++i) {
+                std::string name = "table_" + to_string(i);
+                tr->add_table(name)->add_column(type_String, "value");
+            }
+            tr->commit();
+        }
+
+        std::string id = "commit_" + to_string(size / 1024) + "k";
+        std::string desc = "Commit " + to_string(size / 1024) + " KB";
+        for (int round = 0; round < rounds; ++round) {
+            auto tr = db->start_write();
+            add_data(*tr, size, round);
+            timer.reset();
+            tr->commit();
+            results.submit(id.c_str(), timer);
+        }
+        results.finish(id, desc);
+    }
+}
@@ -0,0 +1,173 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+// Measures write transactions which change objects spread over the whole
+// file, so that most changes copy the arrays they touch (copy-on-write) and
+// the time goes to the slab allocator as much as to the changes themselves.
+// Only the changes are timed, not the commits. Also measures the slab
+// allocator on its own, allocating and freeing blocks of the sizes arrays
+// copied on write typically have.
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/alloc_slab.hpp>
+#include <realm/disable_sync_to_disk.hpp>
+#include <realm/node_header.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/test_path.hpp"
+#include "../util/benchmark_results.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+namespace {
+
+const size_t num_objects = 250000;
+const size_t changes_per_transaction = 2000;
+const int rounds = 25;
+
+// Keep `num_live` blocks allocated, replacing the oldest one by a block of a
+// random size from `sizes` for each step, like a write transaction copying
+// arrays and freeing the originals
+void alloc_and_free(SlabAlloc& alloc, std::mt19937_64& random, const std::vector<size_t>& sizes, size_t num_live,
+                    size_t steps)
+{
+    std::uniform_int_distribution<size_t> random_size(0, sizes.size() - 1);
+    std::vector<MemRef> live;
+    live.reserve(num_live);
+    for (size_t i = 0; i < steps; ++i) {
+        size_t size = sizes[random_size(random)];
+        MemRef mem = alloc.alloc(size);
+        NodeHeader::set_capacity_in_header(size, mem.get_addr());
+        if (live.size() < num_live) {
+            live.push_back(mem);
+            continue;
+        }
+        MemRef& oldest = live[i % num_live];
+        alloc.free_(oldest.get_ref(), oldest.get_addr());
+        oldest = mem;
+    }
+    for (MemRef& mem : live)
+        alloc.free_(mem.get_ref(), mem.get_addr());
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+    // Syncing would dominate the measurements
+    disable_sync_to_disk();
+
+    int max_lead_text_size = 26;
+    std::string results_file_stem = get_test_path_prefix() + "results";
+    BenchmarkResults results(max_lead_text_size, results_file_stem.c_str());
+
+    SharedGroupTestPathGuard path("benchmark_cow_updates");
+    DBRef db = DB::create(path);
+    std::string table_name = "table";
+    {
+        auto tr = db->start_write();
+        TableRef table = tr->add_table(table_name);
+        table->add_column(type_Int, "int");
+        table->add_column(type_String, "str");
+        for (size_t i = 0; i < num_objects; ++i)
+            table->create_object(ObjKey(int64_t(i * 2))).set_all(int64_t(i), "value");
+        tr->commit();
+    }
+
+    std::mt19937_64 random(1234);
+    std::uniform_int_distribution<int64_t> random_key(0, num_objects - 1);
+    Timer timer(Timer::type_RealTime);
+
+    // Each change sets an integer of a random object
+    for (int round = 0; round < rounds; ++round) {
+        auto tr = db->start_write();
+        TableRef table = tr->get_table(table_name);
+        ColKey col = table->get_column_key("int");
+        timer.reset();
+        for (size_t i = 0; i < changes_per_transaction; ++i)
+            table->get_object(ObjKey(random_key(random) * 2)).set(col, int64_t(round));
+        results.submit("cow_set_int", timer);
+        tr->commit();
+    }
+    results.finish("cow_set_int", "Set int, random objects");
+
+    // Each change sets a string of a random object to a longer value, which
+    // also reallocates the string leaf
+    for (int round = 0; round < rounds; ++round) {
+        auto tr = db->start_write();
+        TableRef table = tr->get_table(table_name);
+        ColKey col = table->get_column_key("str");
+        std::string value(size_t(8 + round), 'x');
+        timer.reset();
+        for (size_t i = 0; i < changes_per_transaction; ++i)
+            table->get_object(ObjKey(random_key(random) * 2)).set(col, StringData(value));
+        results.submit("cow_set_string", timer);
+        tr->commit();
+    }
+    results.finish("cow_set_string", "Set string, random objects");
+
+    // Each change inserts an object between two existing ones
+    for (int round = 0; round < rounds; ++round) {
+        auto tr = db->start_write();
+        TableRef table = tr->get_table(table_name);
+        timer.reset();
+        for (size_t i = 0; i < changes_per_transaction; ++i) {
+            ObjKey key(random_key(random) * 2 + 1);
+            if (!table->is_valid(key))
+                table->create_object(key);
+        }
+        results.submit("cow_insert", timer);
+        tr->rollback();
+    }
+    results.finish("cow_insert", "Insert, random positions");
+
+    // Array headers and leaves of up to a few hundred entries
+    std::vector<size_t> small_sizes;
+    for (size_t size = 16; size <= 1000; size += 8)
+        small_sizes.push_back(size);
+    // Mostly full leaves of 1000 entries of up to 64 bits
+    std::vector<size_t> large_sizes;
+    for (size_t size = 1024; size <= 8008; size += 8)
+        large_sizes.push_back(size);
+
+    for (int round = 0; round < rounds; ++round) {
+        SlabAlloc alloc;
+        alloc.attach_empty();
+        timer.reset();
+        alloc_and_free(alloc, random, small_sizes, 2000, 100000);
+        results.submit("alloc_small", timer);
+    }
+    results.finish("alloc_small", "Alloc/free, small blocks");
+
+    for (int round = 0; round < rounds; ++round) {
+        SlabAlloc alloc;
+        alloc.attach_empty();
+        timer.reset();
+        alloc_and_free(alloc, random, large_sizes, 2000, 100000);
+        results.submit("alloc_large", timer);
+    }
+    results.finish("alloc_large", "Alloc/free, large blocks");
+}
@@ -314,6 +314,63 @@ TEST(Alloc_Fuzzy)
     }
 }
 
+
+TEST(Alloc_SmallBlockLists)
+{
+    SlabAlloc alloc;
+    alloc.attach_empty();
+
+    MemRef mr1 = alloc.alloc(64);
+    MemRef mr2 = alloc.alloc(64);
+    MemRef mr3 = alloc.alloc(64);
+    set_capacity(mr1.get_addr(), 64);
+    set_capacity(mr2.get_addr(), 64);
+    set_capacity(mr3.get_addr(), 64);
+
+    // A freed block is reused by the next allocation of its size
+    alloc.free_(mr2.get_ref(), mr2.get_addr());
+    MemRef mr4 = alloc.alloc(64);
+    CHECK_EQUAL(mr2.get_ref(), mr4.get_ref());
+    set_capacity(mr4.get_addr(), 64);
+
+    // Neighbouring free blocks are merged, also when they are small, so the
+    // space of two blocks and the BetweenBlocks separating them is reused
+    alloc.free_(mr1.get_ref(), mr1.get_addr());
+    alloc.free_(mr4.get_ref(), mr4.get_addr());
+    MemRef mr5 = alloc.alloc(136);
+    CHECK_EQUAL(mr1.get_ref(), mr5.get_ref());
+    set_capacity(mr5.get_addr(), 136);
+    alloc.free_(mr5.get_ref(), mr5.get_addr());
+    alloc.free_(mr3.get_ref(), mr3.get_addr());
+
+    // Sizes on both sides of the limit for the small lists
+    std::vector<MemRef> refs;
+    for (int iter = 0; iter < 20000; ++iter) {
+        if (refs.size() < 100 && (refs.empty() || rand() % 100 > 45)) {
+            size_t size = (rand() % 256 + 2) * 8;
+            MemRef r = alloc.alloc(size);
+            set_capacity(r.get_addr(), size);
+            memset(r.get_addr() + 3, static_cast<char>(r.get_ref() >> 3), size - 3);
+            refs.push_back(r);
+        }
+        else {
+            size_t entry = rand() % refs.size();
+            MemRef r = refs[entry];
+            size_t size = get_capacity(r.get_addr());
+            bool intact = true;
+            for (size_t c = 3; c < size; ++c)
+                intact = intact && r.get_addr()[c] == static_cast<char>(r.get_ref() >> 3);
+            CHECK(intact);
+            alloc.free_(r.get_ref(), r.get_addr());
+            refs.erase(refs.begin() + entry);
+        }
+    }
+    for (MemRef& r : refs)
+        alloc.free_(r.get_ref(), r.get_addr());
+
+    // SlabAlloc destructor will verify that all is free'd
+}
+
 namespace {
 
 class TestSlabAlloc : public SlabAlloc
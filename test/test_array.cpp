@@ -1006,6 +1006,84 @@ TEST(Array_find_sse)
 }
 
 
+namespace {
+
+template <class Cond>
+void check_find_all_actions(TestContext& test_context, const Array& a, const std::vector<int64_t>& values,
+                            int64_t value)
+{
+    Cond c;
+    size_t expected_first = not_found;
+    size_t expected_count = 0;
+    uint64_t expected_sum = 0; // Wrap around on overflow like the 64-bit leaves do
+    int64_t expected_min = std::numeric_limits<int64_t>::max();
+    int64_t expected_max = std::numeric_limits<int64_t>::min();
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (c(values[i], value)) {
+            if (expected_first == not_found)
+                expected_first = i;
+            ++expected_count;
+            expected_sum += uint64_t(values[i]);
+            expected_min = std::min(expected_min, values[i]);
+            expected_max = std::max(expected_max, values[i]);
+        }
+    }
+
+    CHECK_EQUAL(expected_first, a.find_first<Cond>(value));
+
+    QueryState<int64_t> count_state(act_Count);
+    a.find<Cond>(act_Count, value, 0, npos, 0, &count_state);
+    CHECK_EQUAL(int64_t(expected_count), count_state.m_state);
+
+    QueryState<int64_t> sum_state(act_Sum);
+    a.find<Cond>(act_Sum, value, 0, npos, 0, &sum_state);
+    CHECK_EQUAL(expected_sum, uint64_t(sum_state.m_state));
+
+    QueryState<int64_t> min_state(act_Min);
+    a.find<Cond>(act_Min, value, 0, npos, 0, &min_state);
+    CHECK_EQUAL(expected_min, min_state.m_state);
+
+    QueryState<int64_t> max_state(act_Max);
+    a.find<Cond>(act_Max, value, 0, npos, 0, &max_state);
+    CHECK_EQUAL(expected_max, max_state.m_state);
+}
+
+} // anonymous namespace
+
+// Compares find results against a naive scan for every width handled by the SIMD paths (see find_sse() and
+// find_avx2()). The leaf sizes vary so that the scalar loops before and after the aligned area are exercised too.
+TEST(Array_FindSimdAllWidths)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t limits[] = {1, 3, 15, 127, 32767, 2147483647LL, 9223372036854775807LL};
+
+    for (int64_t limit : limits) {
+        for (size_t offset = 0; offset < 5; ++offset) {
+            Array a(Allocator::get_default());
+            a.create(Array::type_Normal);
+            std::vector<int64_t> values;
+
+            // Force the width of the leaf, even when the random values happen to be small
+            a.add(limit);
+            values.push_back(limit);
+            for (size_t i = 0; i < 300 + offset; ++i) {
+                int64_t v = random.draw_int<int64_t>(limit == 1 ? 0 : -limit, limit);
+                a.add(v);
+                values.push_back(v);
+            }
+
+            for (int64_t value : {int64_t(0), values[values.size() / 2], limit / 2, -(limit / 2)}) {
+                check_find_all_actions<Equal>(test_context, a, values, value);
+                check_find_all_actions<NotEqual>(test_context, a, values, value);
+                check_find_all_actions<Greater>(test_context, a, values, value);
+                check_find_all_actions<Less>(test_context, a, values, value);
+            }
+            a.destroy();
+        }
+    }
+}
+
+
 TEST(Array_Greater)
 {
     Array a(Allocator::get_default());
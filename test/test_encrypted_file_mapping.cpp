@@ -22,8 +22,13 @@
 // should be updated.
 #if defined(TEST_ENCRYPTED_FILE_MAPPING) && !defined(_WIN32)
 
+#include <cstring>
+#include <memory>
+#include <thread>
+
 #include <realm/util/aes_cryptor.hpp>
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/file_mapper.hpp>
 
 #include "test.hpp"
 
@@ -184,5 +189,122 @@ TEST(EncryptedFile_LargePages)
     close(fd);
 }
 
+TEST(EncryptedFile_MultipleMetadataBlocks)
+{
+    TEST_PATH(path);
+
+    // 64 blocks share a block of IVs, so this spans four of them
+    const size_t block_size = 4096;
+    const size_t num_blocks = 200;
+    const size_t first_block = 10;
+    std::unique_ptr<char[]> data(new char[num_blocks * block_size]);
+    for (size_t i = 0; i < num_blocks * block_size; ++i)
+        data[i] = static_cast<char>(i % 251);
+    std::unique_ptr<char[]> buffer(new char[(first_block + num_blocks) * block_size]);
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t((first_block + num_blocks) * block_size));
+        cryptor.write(fd, off_t(first_block * block_size), data.get(), num_blocks * block_size);
+        CHECK(cryptor.read(fd, off_t(first_block * block_size), buffer.get(), num_blocks * block_size));
+        CHECK(memcmp(buffer.get(), data.get(), num_blocks * block_size) == 0);
+    }
+    {
+        // A new cryptor reads the IVs from the file. The blocks which were
+        // never written are left alone, but the rest are still read.
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t((first_block + num_blocks) * block_size));
+        memset(buffer.get(), 'x', first_block * block_size);
+        CHECK_NOT(cryptor.read(fd, 0, buffer.get(), (first_block + num_blocks) * block_size));
+        for (size_t i = 0; i < first_block * block_size; ++i) {
+            if (buffer[i] != 'x') {
+                CHECK_EQUAL(buffer[i], 'x');
+                break;
+            }
+        }
+        CHECK(memcmp(buffer.get() + first_block * block_size, data.get(), num_blocks * block_size) == 0);
+    }
+    close(fd);
+}
+
+TEST(EncryptedFile_ParallelDecryption)
+{
+    TEST_PATH(path);
+
+    const size_t block_size = 4096;
+    const size_t num_blocks = 150;
+    std::unique_ptr<char[]> data(new char[num_blocks * block_size]);
+    for (size_t i = 0; i < num_blocks * block_size; ++i)
+        data[i] = static_cast<char>(i % 253);
+    std::unique_ptr<char[]> buffer(new char[num_blocks * block_size]);
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(num_blocks * block_size));
+        // Written twice so that there is a previous IV to fall back on
+        cryptor.write(fd, 0, data.get(), num_blocks * block_size);
+        cryptor.write(fd, 0, data.get(), num_blocks * block_size);
+    }
+    for (unsigned num_threads : {0, 1, 3, 7}) {
+        set_decryption_threads(num_threads);
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(num_blocks * block_size));
+        memset(buffer.get(), 0, num_blocks * block_size);
+        CHECK(cryptor.read(fd, 0, buffer.get(), num_blocks * block_size));
+        CHECK(memcmp(buffer.get(), data.get(), num_blocks * block_size) == 0);
+        // and again with a cryptor which already has the IVs and its helpers
+        memset(buffer.get(), 0, num_blocks * block_size);
+        CHECK(cryptor.read(fd, 0, buffer.get(), num_blocks * block_size));
+        CHECK(memcmp(buffer.get(), data.get(), num_blocks * block_size) == 0);
+    }
+
+    // Corrupted data is still detected when another thread decrypts it
+    char garbage[block_size];
+    memset(garbage, 0x55, block_size);
+    CHECK_EQUAL(pwrite(fd, garbage, block_size, 4096 * 60), ssize_t(block_size));
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(num_blocks * block_size));
+        CHECK_THROW(cryptor.read(fd, 0, buffer.get(), num_blocks * block_size), DecryptionFailed);
+    }
+    unsigned cores = std::thread::hardware_concurrency();
+    set_decryption_threads(cores > 1 ? std::min(cores, 4U) - 1 : 0);
+    close(fd);
+}
+
+TEST(EncryptedFile_HmacSha224)
+{
+    // Test cases 1 and 2 of RFC 4231. Keys shorter than 32 bytes are padded
+    // with zeroes by HMAC itself, so padding them here gives the same result.
+    struct {
+        uint8_t key[32];
+        const char* data;
+        uint8_t hmac[HmacSha224::digest_size];
+    } cases[] = {
+        {{0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+          0x0b, 0x0b},
+         "Hi There",
+         {0x89, 0x6f, 0xb1, 0x12, 0x8a, 0xbb, 0xdf, 0x19, 0x68, 0x32, 0x10, 0x7c, 0xd4, 0x9d,
+          0xf3, 0x3f, 0x47, 0xb4, 0xb1, 0x16, 0x99, 0x12, 0xba, 0x4f, 0x53, 0x68, 0x4b, 0x22}},
+        {{'J', 'e', 'f', 'e'},
+         "what do ya want for nothing?",
+         {0xa3, 0x0e, 0x01, 0x09, 0x8b, 0xc6, 0xdb, 0xbf, 0x45, 0x69, 0x0f, 0x3a, 0x7e, 0x9e,
+          0x6d, 0x0f, 0x8b, 0xbe, 0xa2, 0xa3, 0x9e, 0x61, 0x48, 0x00, 0x8f, 0xd0, 0x5e, 0x44}},
+    };
+    for (auto& c : cases) {
+        HmacSha224 hmac(c.key);
+        uint8_t digest[HmacSha224::digest_size];
+        // Twice, as the keyed state is reused
+        for (int i = 0; i < 2; ++i) {
+            hmac.calc(c.data, strlen(c.data), digest);
+            CHECK(memcmp(digest, c.hmac, sizeof(digest)) == 0);
+            CHECK(hmac.check(c.data, strlen(c.data), c.hmac));
+        }
+        CHECK_NOT(hmac.check(c.data, strlen(c.data) - 1, c.hmac));
+    }
+}
+
 #endif // REALM_ENABLE_ENCRYPTION
 #endif // TEST_ENCRYPTED_FILE_MAPPING
@@ -174,6 +174,96 @@ TEST(File_MapMultiplePages)
     }
 }
 
+
+TEST(File_MapPrefault)
+{
+    const size_t count = 4096 / sizeof(size_t) * 16;
+    const size_t size = count * sizeof(size_t);
+
+    TEST_PATH(path);
+    {
+        File f(path, File::mode_Write);
+        f.resize(2 * size);
+        File::Map<size_t> map(f, File::access_ReadWrite, 2 * size);
+        for (size_t i = 0; i < 2 * count; ++i)
+            map.get_addr()[i] = i;
+    }
+    for (int flags : {int(File::map_Populate), int(File::map_WillNeed)}) {
+        File f(path, File::mode_Read);
+        File::Map<size_t> map(f, File::access_ReadOnly, size, flags);
+        File::advise(map.get_addr(), size, File::advice_Random);
+        CHECK_EQUAL(map.get_addr()[count - 1], count - 1);
+        // Growing the mapping brings in the part added to it
+        map.remap(f, File::access_ReadOnly, 2 * size, flags);
+        File::advise(map.get_addr(), 2 * size, File::advice_Sequential);
+        for (size_t i = 0; i < 2 * count; ++i) {
+            CHECK_EQUAL(map.get_addr()[i], i);
+            if (map.get_addr()[i] != i)
+                return;
+        }
+    }
+}
+
+#if REALM_ENABLE_ENCRYPTION
+TEST(File_MapReadAhead)
+{
+    const size_t num_pages = 128;
+    const size_t per_page = page_size() / sizeof(size_t);
+    const size_t count = num_pages * per_page;
+    const size_t size = count * sizeof(size_t);
+
+    TEST_PATH(path);
+    {
+        File f(path, File::mode_Write);
+        f.set_encryption_key(crypt_key(true));
+        f.resize(size);
+        File::Map<size_t> map(f, File::access_ReadWrite, size);
+        realm::util::encryption_read_barrier(map, 0, count);
+        for (size_t i = 0; i < count; ++i)
+            map.get_addr()[i] = i;
+        realm::util::encryption_write_barrier(map, 0, count);
+    }
+
+    File f(path, File::mode_Read);
+    f.set_encryption_key(crypt_key(true));
+    auto read_page = [&](File::Map<size_t>& map, size_t page) {
+        size_t i = page * per_page;
+        realm::util::encryption_read_barrier(map, i);
+        CHECK_EQUAL(map.get_addr()[i], i);
+    };
+    {
+        // Pages read backwards are decrypted one by one
+        File::Map<size_t> map(f, File::access_ReadOnly, size);
+        for (size_t page = num_pages; page > num_pages - 16; --page)
+            read_page(map, page - 1);
+        CHECK_EQUAL(map.get_encrypted_mapping()->collect_decryption_count(), 16);
+    }
+    {
+        // Pages read in order are decrypted along with the ones following them
+        File::Map<size_t> map(f, File::access_ReadOnly, size);
+        for (size_t page = 0; page < 16; ++page)
+            read_page(map, page);
+        CHECK_GREATER(map.get_encrypted_mapping()->collect_decryption_count(), 16);
+        CHECK_LESS_EQUAL(map.get_encrypted_mapping()->collect_decryption_count(), 16 + 32);
+        for (size_t i = 0; i < count; ++i) {
+            realm::util::encryption_read_barrier(map, i);
+            CHECK_EQUAL(map.get_addr()[i], i);
+            if (map.get_addr()[i] != i)
+                break;
+        }
+        CHECK_EQUAL(map.get_encrypted_mapping()->collect_decryption_count(), num_pages);
+    }
+    {
+        set_encryption_read_ahead(0);
+        File::Map<size_t> map(f, File::access_ReadOnly, size);
+        for (size_t page = 0; page < 16; ++page)
+            read_page(map, page);
+        CHECK_EQUAL(map.get_encrypted_mapping()->collect_decryption_count(), 16);
+        set_encryption_read_ahead(32);
+    }
+}
+#endif
+
 TEST(File_ReaderAndWriter)
 {
     const size_t count = 4096 / sizeof(size_t) * 256 * 2;
@@ -0,0 +1,509 @@
+/*************************************************************************
+ *
+ * Copyright 2020 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_INDEX_ORDERED
+
+#include <realm.hpp>
+#include <realm/history.hpp>
+#include <realm/index_ordered.hpp>
+#include "test.hpp"
+#include "util/random.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+using unit_test::TestContext;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+
+namespace {
+
+// Check that the index holds exactly the values of the column, in order
+void check_index(TestContext& test_context, const Table& table, ColKey col)
+{
+    const OrderedIndex* index = table.get_ordered_index(col);
+    CHECK(index);
+    if (!index)
+        return;
+    CHECK_EQUAL(index->size(), table.size());
+    for (size_t i = 0; i < index->size(); i++) {
+        ConstObj obj = table.get_object(index->get_key(i));
+        CHECK_EQUAL(obj.get_any(col), index->get_value(i));
+        if (i > 0) {
+            int c = index->get_value(i - 1).compare(index->get_value(i));
+            CHECK(c < 0 || (c == 0 && index->get_key(i - 1) < index->get_key(i)));
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST(IndexOrdered_Maintenance)
+{
+    Table table;
+    auto col_int = table.add_column(type_Int, "int", true);
+    auto col_float = table.add_column(type_Float, "float", true);
+    auto col_double = table.add_column(type_Double, "double");
+    auto col_date = table.add_column(type_Timestamp, "date", true);
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    for (int i = 0; i < 300; i++) {
+        Obj obj = table.create_object();
+        obj.set(col_int, random.draw_int<int64_t>(-50, 50));
+        obj.set(col_float, float(random.draw_int<int>(0, 100)) / 4);
+        obj.set(col_double, double(random.draw_int<int>(-100, 100)));
+        if (random.draw_int<int>(0, 9) == 0)
+            obj.set_null(col_date);
+        else
+            obj.set(col_date, Timestamp(random.draw_int<int64_t>(0, 100), random.draw_int<int32_t>(0, 2)));
+    }
+
+    table.add_search_index(col_int, Table::IndexType::Ordered);
+    table.add_search_index(col_float, Table::IndexType::Ordered);
+    table.add_search_index(col_double, Table::IndexType::Ordered);
+    table.add_search_index(col_date, Table::IndexType::Ordered);
+    CHECK(table.has_ordered_index(col_int));
+    CHECK(!table.has_search_index(col_int));
+    for (auto col : {col_int, col_float, col_double, col_date})
+        check_index(test_context, table, col);
+
+    // Only numeric and timestamp columns can have an ordered index
+    auto col_str = table.add_column(type_String, "str");
+    CHECK_THROW(table.add_search_index(col_str, Table::IndexType::Ordered), LogicError);
+
+    for (int i = 0; i < 300; i++) {
+        Obj obj = table.get_object(random.draw_int<size_t>(0, table.size() - 1));
+        switch (random.draw_int<int>(0, 6)) {
+            case 0:
+                obj.set(col_int, random.draw_int<int64_t>(-50, 50));
+                break;
+            case 1:
+                if (!obj.is_null(col_int))
+                    obj.add_int(col_int, 3);
+                break;
+            case 2:
+                obj.set_null(col_int);
+                break;
+            case 3:
+                obj.set(col_float, float(random.draw_int<int>(0, 100)) / 4);
+                break;
+            case 4:
+                obj.set(col_double, double(random.draw_int<int>(-100, 100)));
+                break;
+            case 5:
+                obj.set(col_date, Timestamp(random.draw_int<int64_t>(0, 100), 0));
+                break;
+            case 6:
+                obj.remove();
+                table.create_object().set(col_int, 7).set(col_date, Timestamp(7, 7));
+                break;
+        }
+    }
+    for (auto col : {col_int, col_float, col_double, col_date})
+        check_index(test_context, table, col);
+
+    table.remove_search_index(col_float, Table::IndexType::Ordered);
+    CHECK(!table.has_ordered_index(col_float));
+    table.remove_column(col_double);
+    check_index(test_context, table, col_int);
+    check_index(test_context, table, col_date);
+    table.verify();
+
+    table.clear();
+    CHECK_EQUAL(table.get_ordered_index(col_int)->size(), 0);
+    table.create_object().set(col_int, 5);
+    check_index(test_context, table, col_int);
+    check_index(test_context, table, col_date);
+}
+
+TEST(IndexOrdered_Bounds)
+{
+    // Enough entries for the trees to have several leaves, and runs of equal values crossing their borders
+    Table table;
+    auto col = table.add_column(type_Int, "int", true);
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    size_t n = 5 * REALM_MAX_BPNODE_SIZE + 17;
+    for (size_t i = 0; i < n; i++)
+        table.create_object().set(col, random.draw_int<int64_t>(0, int64_t(n / 50)));
+    table.add_search_index(col, Table::IndexType::Ordered);
+    check_index(test_context, table, col);
+
+    const OrderedIndex* index = table.get_ordered_index(col);
+    for (int64_t v = -1; v <= int64_t(n / 50) + 1; v++) {
+        size_t lower = 0;
+        while (lower < index->size() && index->get_value(lower).get_int() < v)
+            lower++;
+        size_t upper = lower;
+        while (upper < index->size() && index->get_value(upper).get_int() == v)
+            upper++;
+        CHECK_EQUAL(index->lower_bound(Mixed(v)), lower);
+        CHECK_EQUAL(index->upper_bound(Mixed(v)), upper);
+    }
+
+    // Inserting and erasing keeps the entries ordered by value and key
+    for (int i = 0; i < 500; i++)
+        table.get_object(random.draw_int<size_t>(0, table.size() - 1)).set(col, random.draw_int<int64_t>(0, 10));
+    for (int i = 0; i < 500; i++)
+        table.get_object(random.draw_int<size_t>(0, table.size() - 1)).remove();
+    check_index(test_context, table, col);
+}
+
+TEST(IndexOrdered_Queries)
+{
+    Table table;
+    // The same values with and without an index
+    auto col_indexed = table.add_column(type_Int, "indexed", true);
+    auto col_plain = table.add_column(type_Int, "plain", true);
+    auto col_date_indexed = table.add_column(type_Timestamp, "date_indexed");
+    auto col_date_plain = table.add_column(type_Timestamp, "date_plain");
+    auto col_float_indexed = table.add_column(type_Float, "float_indexed", true);
+    auto col_float_plain = table.add_column(type_Float, "float_plain", true);
+    auto col_double_indexed = table.add_column(type_Double, "double_indexed");
+    auto col_double_plain = table.add_column(type_Double, "double_plain");
+    auto col_weight = table.add_column(type_Int, "weight");
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    for (int i = 0; i < 3000; i++) {
+        Obj obj = table.create_object();
+        if (i % 100 == 0) {
+            obj.set_null(col_indexed);
+            obj.set_null(col_plain);
+        }
+        else {
+            int64_t v = random.draw_int<int64_t>(0, 1000);
+            obj.set(col_indexed, v);
+            obj.set(col_plain, v);
+        }
+        Timestamp t(random.draw_int<int64_t>(0, 1000), 0);
+        obj.set(col_date_indexed, t);
+        obj.set(col_date_plain, t);
+        // NaNs, which no comparison matches, and nulls are ordered before all numbers by the index
+        float f = i % 150 == 0 ? std::numeric_limits<float>::quiet_NaN() : random.draw_int<int>(0, 1000) / 4.0f;
+        if (i % 100 == 0) {
+            obj.set_null(col_float_indexed);
+            obj.set_null(col_float_plain);
+        }
+        else {
+            obj.set(col_float_indexed, f);
+            obj.set(col_float_plain, f);
+        }
+        double d = i % 150 == 0 ? std::numeric_limits<double>::quiet_NaN() : random.draw_int<int>(-500, 500) / 2.0;
+        obj.set(col_double_indexed, d);
+        obj.set(col_double_plain, d);
+        obj.set(col_weight, i);
+    }
+    table.add_search_index(col_indexed, Table::IndexType::Ordered);
+    table.add_search_index(col_date_indexed, Table::IndexType::Ordered);
+    table.add_search_index(col_float_indexed, Table::IndexType::Ordered);
+    table.add_search_index(col_double_indexed, Table::IndexType::Ordered);
+
+    auto check_same = [&](Query q1, Query q2) {
+        CHECK_EQUAL(q1.count(), q2.count());
+        TableView tv1 = q1.find_all();
+        TableView tv2 = q2.find_all();
+        CHECK_EQUAL(tv1.size(), tv2.size());
+        bool same = tv1.size() == tv2.size();
+        for (size_t i = 0; same && i < tv1.size(); i++)
+            same = tv1.get_key(i) == tv2.get_key(i);
+        CHECK(same);
+        CHECK_EQUAL(q1.sum_int(col_weight), q2.sum_int(col_weight));
+        CHECK_EQUAL(q1.find_all(5, 2000, 10).size(), q2.find_all(5, 2000, 10).size());
+    };
+
+    for (int64_t v : {-1, 0, 5, 500, 995, 1000, 1001}) {
+        check_same(table.where().greater(col_indexed, v), table.where().greater(col_plain, v));
+        check_same(table.where().greater_equal(col_indexed, v), table.where().greater_equal(col_plain, v));
+        check_same(table.where().less(col_indexed, v), table.where().less(col_plain, v));
+        check_same(table.where().less_equal(col_indexed, v), table.where().less_equal(col_plain, v));
+        check_same(table.where().equal(col_indexed, v), table.where().equal(col_plain, v));
+        // Together with a condition which is tested for each object found through the index
+        check_same(table.where().less(col_indexed, v).equal(col_plain, v - 1),
+                   table.where().less(col_plain, v).equal(col_plain, v - 1));
+
+        Timestamp t(v, 0);
+        check_same(table.where().greater(col_date_indexed, t), table.where().greater(col_date_plain, t));
+        check_same(table.where().less_equal(col_date_indexed, t), table.where().less_equal(col_date_plain, t));
+        check_same(table.where().equal(col_date_indexed, t), table.where().equal(col_date_plain, t));
+
+        float f = v / 4.0f;
+        check_same(table.where().greater(col_float_indexed, f), table.where().greater(col_float_plain, f));
+        check_same(table.where().less(col_float_indexed, f), table.where().less(col_float_plain, f));
+        check_same(table.where().less_equal(col_float_indexed, f), table.where().less_equal(col_float_plain, f));
+        check_same(table.where().equal(col_float_indexed, f), table.where().equal(col_float_plain, f));
+        double d = v / 2.0 - 250.25;
+        check_same(table.where().greater_equal(col_double_indexed, d),
+                   table.where().greater_equal(col_double_plain, d));
+        check_same(table.where().less(col_double_indexed, d), table.where().less(col_double_plain, d));
+        check_same(table.where().between(col_double_indexed, d, d + 5),
+                   table.where().between(col_double_plain, d, d + 5));
+    }
+    check_same(table.where().between(col_float_indexed, 100.0f, 101.5f),
+               table.where().between(col_float_plain, 100.0f, 101.5f));
+    check_same(table.where().equal(col_float_indexed, null()), table.where().equal(col_float_plain, null()));
+    float nan_f = std::numeric_limits<float>::quiet_NaN();
+    check_same(table.where().less(col_float_indexed, nan_f), table.where().less(col_float_plain, nan_f));
+    check_same(table.where().equal(col_float_indexed, nan_f), table.where().equal(col_float_plain, nan_f));
+    double nan_d = std::numeric_limits<double>::quiet_NaN();
+    check_same(table.where().greater(col_double_indexed, nan_d), table.where().greater(col_double_plain, nan_d));
+    // The objects found through the index are tested again, so also check that its ranges leave out the NaNs
+    auto range = table.get_ordered_index(col_float_indexed)->find_range(OrderedIndex::Relation::less, Mixed(10.0f));
+    CHECK_EQUAL(range.second - range.first, table.where().less(col_float_plain, 10.0f).count());
+    check_same(table.where().equal(col_indexed, null()), table.where().equal(col_plain, null()));
+    check_same(table.where().greater(col_indexed, 990).less(col_indexed, 995),
+               table.where().greater(col_plain, 990).less(col_plain, 995));
+}
+
+TEST(IndexOrdered_Sort)
+{
+    Table table;
+    auto col_indexed = table.add_column(type_Double, "indexed", true);
+    auto col_plain = table.add_column(type_Double, "plain", true);
+    auto col_int = table.add_column(type_Int, "int");
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    for (int i = 0; i < 1000; i++) {
+        Obj obj = table.create_object();
+        if (i % 50 == 0) {
+            obj.set_null(col_indexed);
+            obj.set_null(col_plain);
+        }
+        else {
+            // Plenty of equal values to check that the sort is stable
+            double v = random.draw_int<int>(0, 100) / 2.0;
+            obj.set(col_indexed, v);
+            obj.set(col_plain, v);
+        }
+        obj.set(col_int, i % 3);
+    }
+    table.add_search_index(col_indexed, Table::IndexType::Ordered);
+
+    auto check_same = [&](TableView tv1, TableView tv2) {
+        CHECK_EQUAL(tv1.size(), tv2.size());
+        bool same = tv1.size() == tv2.size();
+        for (size_t i = 0; same && i < tv1.size(); i++)
+            same = tv1.get_key(i) == tv2.get_key(i);
+        CHECK(same);
+    };
+
+    for (bool ascending : {true, false}) {
+        TableView tv1 = table.where().find_all();
+        TableView tv2 = table.where().find_all();
+        tv1.sort(col_indexed, ascending);
+        tv2.sort(col_plain, ascending);
+        check_same(tv1, tv2);
+
+        tv1 = table.where().not_equal(col_int, 0).find_all();
+        tv2 = table.where().not_equal(col_int, 0).find_all();
+        tv1.sort(col_indexed, ascending);
+        tv2.sort(col_plain, ascending);
+        check_same(tv1, tv2);
+
+        // Sorting on more than one column can not be done through the index
+        tv1 = table.where().find_all();
+        tv2 = table.where().find_all();
+        tv1.sort(SortDescriptor({{col_int}, {col_indexed}}, {true, ascending}));
+        tv2.sort(SortDescriptor({{col_int}, {col_plain}}, {true, ascending}));
+        check_same(tv1, tv2);
+
+        // With a limit, the index is only walked until enough objects are found
+        for (size_t limit : {0, 1, 25, 500, 2000}) {
+            DescriptorOrdering ordering1;
+            ordering1.append_sort(SortDescriptor({{col_indexed}}, {ascending}));
+            ordering1.append_limit(limit);
+            DescriptorOrdering ordering2;
+            ordering2.append_sort(SortDescriptor({{col_plain}}, {ascending}));
+            ordering2.append_limit(limit);
+            tv1 = table.where().not_equal(col_int, 1).find_all(ordering1);
+            tv2 = table.where().not_equal(col_int, 1).find_all(ordering2);
+            check_same(tv1, tv2);
+            CHECK_EQUAL(tv1.get_num_results_excluded_by_limit(), tv2.get_num_results_excluded_by_limit());
+        }
+    }
+}
+
+TEST(IndexOrdered_Transactions)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ColKey col;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        DBRef db = DB::create(*hist);
+        auto rt = db->start_read();
+        {
+            auto wt = db->start_write();
+            auto table = wt->add_table("table");
+            col = table->add_column(type_Int, "int");
+            for (int i = 0; i < 100; i++)
+                table->create_object().set(col, 100 - i);
+            wt->commit();
+        }
+        {
+            auto wt = db->start_write();
+            wt->get_table("table")->add_search_index(col, Table::IndexType::Ordered);
+            wt->commit();
+        }
+        rt->advance_read();
+        auto table = rt->get_table("table");
+        CHECK(table->has_ordered_index(col));
+        CHECK_EQUAL(table->where().less(col, 3).count(), 2);
+
+        // Changes are seen by readers and undone by rollback
+        {
+            auto wt = db->start_write();
+            wt->get_table("table")->create_object().set(col, 1);
+            wt->commit();
+        }
+        rt->advance_read();
+        check_index(test_context, *table, col);
+        CHECK_EQUAL(table->where().less(col, 3).count(), 3);
+        {
+            auto wt = db->start_write();
+            auto t = wt->get_table("table");
+            t->create_object().set(col, 0);
+            t->remove_search_index(col, Table::IndexType::Ordered);
+            CHECK(!t->has_ordered_index(col));
+            wt->rollback();
+        }
+        {
+            auto wt = db->start_write();
+            auto t = wt->get_table("table");
+            t->get_object(0).set(col, -5);
+            check_index(test_context, *t, col);
+            wt->commit();
+        }
+        rt->advance_read();
+        check_index(test_context, *table, col);
+    }
+
+    // The index survives reopening the file
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    auto rt = db->start_read();
+    auto table = rt->get_table("table");
+    CHECK(table->has_ordered_index(col));
+    check_index(test_context, *table, col);
+    CHECK_EQUAL(table->where().less(col, 3).count(), 4);
+    rt->verify();
+
+    auto wt = db->start_write();
+    wt->get_table("table")->remove_column(col);
+    wt->verify();
+    wt->commit();
+}
+
+TEST(IndexOrdered_FileFormatAndRollback)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col = table->add_column(type_Int, "int");
+        for (int i = 0; i < 100; i++)
+            table->create_object().set(col, i % 10);
+        wt->commit();
+    }
+    // Files without ordered indexes keep file format 10
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*db->start_read()), 10);
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    DBRef db_2 = DB::create(*hist_2);
+    auto rt = db->start_read();
+    auto table = rt->get_table("table");
+
+    // Creating the index can be rolled back, along with the file format
+    rt->promote_to_write();
+    table->add_search_index(col, Table::IndexType::Ordered);
+    table->create_object().set(col, 3);
+    CHECK(table->has_ordered_index(col));
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*rt), 11);
+    rt->rollback_and_continue_as_read();
+    CHECK(!table->has_ordered_index(col));
+    CHECK(!table->get_ordered_index(col));
+    rt->promote_to_write();
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*rt), 10);
+    rt->rollback_and_continue_as_read();
+
+    // The accessors follow the index across commits which keep the
+    // transaction open
+    rt->promote_to_write();
+    table->add_search_index(col, Table::IndexType::Ordered);
+    rt->commit_and_continue_as_read();
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*db->start_read()), 11);
+    {
+        // Other participants of the session commit the raised file format as well
+        auto wt = db_2->start_write();
+        CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*wt), 11);
+        wt->get_table("table")->create_object().set(col, 30);
+        wt->commit();
+        db_2 = nullptr;
+    }
+    for (int i = 0; i < 10; i++) {
+        rt->promote_to_write();
+        table->create_object().set(col, 20 - i);
+        rt->commit_and_continue_as_read();
+        check_index(test_context, *table, col);
+    }
+    CHECK_EQUAL(table->where().greater(col, 10).count(), 11);
+
+    // Removing the search index leaves the ordered index in place
+    rt->promote_to_write();
+    table->add_search_index(col);
+    table->remove_search_index(col);
+    CHECK(!table->has_search_index(col));
+    CHECK(table->has_ordered_index(col));
+    table->remove_search_index(col, Table::IndexType::Ordered);
+    CHECK(!table->has_ordered_index(col));
+    rt->rollback_and_continue_as_read();
+    CHECK(table->has_ordered_index(col));
+    check_index(test_context, *table, col);
+    rt->verify();
+    rt = nullptr;
+    db = nullptr;
+
+    // A new session keeps the raised file format
+    db = DB::create(*hist);
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*db->start_read()), 11);
+    CHECK(db->start_read()->get_table("table")->has_ordered_index(col));
+}
+
+#endif // TEST_INDEX_ORDERED
@@ -133,6 +133,63 @@ TEST(Transactions_Frozen)
 }
 
 
+TEST(Transactions_SharedFrozen)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef db = DB::create(path);
+    ColKey col;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("my_table");
+        col = table->add_column(type_Int, "my_col_1");
+        for (int j = 0; j < 100; ++j)
+            table->create_object().set(col, j);
+        wt->commit();
+    }
+
+    // Concurrent requests for the latest version share one transaction
+    TransactionRef first = db->start_shared_frozen();
+    CHECK(first->is_frozen());
+    const int num_threads = 10;
+    Transaction* shared[num_threads];
+    std::thread workers[num_threads];
+    for (int j = 0; j < num_threads; ++j) {
+        workers[j] = std::thread([&, j] {
+            auto frozen = db->start_shared_frozen();
+            shared[j] = frozen.get();
+            CHECK_EQUAL(frozen->get_table("my_table")->sum_int(col), 4950);
+        });
+    }
+    for (int j = 0; j < num_threads; ++j)
+        workers[j].join();
+    for (int j = 0; j < num_threads; ++j)
+        CHECK_EQUAL(shared[j], first.get());
+
+    // Closing a shared transaction does not end it for the other callers
+    db->start_shared_frozen()->close();
+    CHECK(first->is_attached());
+    CHECK_EQUAL(first->get_table("my_table")->size(), 100);
+
+    // A new version gets a new transaction, while the old one can still be asked for by version
+    {
+        auto wt = db->start_write();
+        wt->get_table("my_table")->create_object().set(col, 100);
+        wt->commit();
+    }
+    TransactionRef second = db->start_shared_frozen();
+    CHECK_NOT_EQUAL(second.get(), first.get());
+    CHECK_EQUAL(second->get_table("my_table")->size(), 101);
+    CHECK_EQUAL(db->start_shared_frozen(first->get_version_of_current_transaction()).get(), first.get());
+    CHECK_EQUAL(first->get_table("my_table")->size(), 100);
+
+    // Once released, the next request for the version starts a new transaction
+    auto version = second->get_version_of_current_transaction();
+    second.reset();
+    TransactionRef third = db->start_shared_frozen(version);
+    CHECK_EQUAL(third->get_table("my_table")->size(), 101);
+    CHECK_EQUAL(db->start_shared_frozen().get(), third.get());
+}
+
 
 TEST(Transactions_ConcurrentFrozenTableGetByName)
 {
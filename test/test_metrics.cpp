@@ -1088,6 +1088,83 @@ NONCONCURRENT_TEST_IF(Metrics_NumDecryptedPagesWithEncryption, REALM_ENABLE_ENCR
     realm::util::set_page_reclaim_governor_to_default(); // the remainder of the test suite should use the default
 }
 
+TEST_IF(Metrics_EncryptedFileStats, REALM_ENABLE_ENCRYPTION)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBOptions options(crypt_key(true));
+    options.enable_metrics = true;
+    options.metrics_buffer_size = 10;
+    auto sg = DB::create(*hist, options);
+    std::string table_name = "table";
+
+    {
+        auto tr = sg->start_write();
+        auto table = tr->add_table(table_name);
+        auto col = table->add_column(type_String, "str");
+        std::string value(100, 'a');
+        for (int i = 0; i < 1000; ++i)
+            table->create_object().set(col, StringData(value));
+        tr->commit();
+    }
+    {
+        auto rt = sg->start_read();
+        rt->get_table(table_name)->warm_up();
+    }
+
+    std::unique_ptr<Metrics::TransactionInfoList> transactions = sg->get_metrics()->take_transactions();
+    CHECK_EQUAL(transactions->size(), 2);
+    const EncryptedFileStats& stats = transactions->at(1).get_encrypted_file_stats();
+    CHECK_GREATER(stats.page_decryptions, 0);
+    CHECK_GREATER(stats.page_hits, 0);
+    CHECK_GREATER(stats.decrypted_size, 0);
+}
+
+TEST_IF(Metrics_DecryptedPageBudget, REALM_ENABLE_ENCRYPTION)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBOptions options(crypt_key(true));
+    options.enable_metrics = true;
+    options.metrics_buffer_size = 10;
+    options.decrypted_page_budget = 4 * util::page_size();
+    auto sg = DB::create(*hist, options);
+    std::string table_name = "table";
+    size_t data_size = 256 * util::page_size();
+
+    {
+        auto tr = sg->start_write();
+        auto table = tr->add_table(table_name);
+        auto col = table->add_column(type_String, "str");
+        std::string value(1000, 'a');
+        for (size_t i = 0; i < data_size / value.size(); ++i)
+            table->create_object().set(col, StringData(value));
+        tr->commit();
+    }
+
+    {
+        auto rt = sg->start_read();
+        rt->get_table(table_name)->warm_up();
+    }
+
+    // The budget is enforced by the page reclaimer, which runs once a second
+    // and releases the pages which were not accessed since its last sweep
+    size_t decrypted_size = data_size;
+    size_t evictions = 0;
+    for (int i = 0; i < 100 && decrypted_size >= data_size / 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        {
+            auto rt = sg->start_read();
+        }
+        std::unique_ptr<Metrics::TransactionInfoList> transactions = sg->get_metrics()->take_transactions();
+        EncryptedFileStats stats = transactions->at(transactions->size() - 1).get_encrypted_file_stats();
+        decrypted_size = stats.decrypted_size;
+        evictions = stats.page_evictions;
+    }
+    CHECK_LESS(decrypted_size, data_size / 2);
+    CHECK_GREATER(evictions, data_size / 2 / util::page_size());
+}
+
 TEST(Metrics_MemoryChecks)
 {
     SHARED_GROUP_TEST_PATH(path);
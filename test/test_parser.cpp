@@ -3397,4 +3397,81 @@ TEST(Parser_TimestampNullable)
 }
 
 
+TEST(Parser_PredicateCache)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    TableRef other = g.add_table("other");
+    ColKey int_col = table->add_column(type_Int, "int");
+    other->add_column(type_Int, "int");
+    for (int64_t i = 0; i < 10; ++i) {
+        table->create_object().set(int_col, i);
+    }
+
+    query_builder::PredicateCache cache(3);
+    query_builder::AnyContext ctx;
+    auto count = [&](TableRef t, std::string predicate, util::Any* args, size_t num_args) {
+        query_builder::ArgumentConverter<util::Any, query_builder::AnyContext> converter(ctx, args, num_args);
+        Query q = t->where();
+        query_builder::apply_predicate(q, predicate, converter, cache);
+        return q.count();
+    };
+
+    // The same predicate is only parsed once and bound to different arguments
+    util::Any args[] = {int64_t(3)};
+    CHECK_EQUAL(count(table, "int > $0", args, 1), 6);
+    args[0] = int64_t(7);
+    CHECK_EQUAL(count(table, "int > $0", args, 1), 2);
+    CHECK_EQUAL(cache.hits(), 1);
+    CHECK_EQUAL(cache.misses(), 1);
+    CHECK_EQUAL(cache.size(), 1);
+
+    // Parse results do not depend on the table
+    CHECK_EQUAL(count(other, "int > $0", args, 1), 0);
+    CHECK_EQUAL(cache.hits(), 2);
+    CHECK_EQUAL(cache.size(), 1);
+
+    // The least recently used predicate is evicted
+    CHECK_EQUAL(count(table, "int == 1", nullptr, 0), 1);
+    CHECK_EQUAL(count(table, "int < 5", nullptr, 0), 5);
+    CHECK_EQUAL(count(table, "int > $0", args, 1), 2);
+    CHECK_EQUAL(count(table, "int != 2", nullptr, 0), 9);
+    CHECK_EQUAL(cache.size(), 3);
+    CHECK_EQUAL(cache.hits(), 3);
+    CHECK_EQUAL(cache.misses(), 4);
+    CHECK_EQUAL(count(table, "int == 1", nullptr, 0), 1);
+    CHECK_EQUAL(cache.misses(), 5);
+
+    // Key paths are resolved against the current schema each time a predicate is applied
+    table->rename_column(int_col, "renamed");
+    CHECK_THROW_ANY(count(table, "int > $0", args, 1));
+    CHECK_EQUAL(cache.hits(), 4);
+    CHECK_EQUAL(count(table, "renamed > $0", args, 1), 2);
+
+    // Sort, distinct, limit and include clauses are applied to a DescriptorOrdering
+    std::string ordered = "renamed > $0 SORT(renamed DESC) LIMIT(2)";
+    args[0] = int64_t(3);
+    {
+        query_builder::ArgumentConverter<util::Any, query_builder::AnyContext> converter(ctx, args, 1);
+        Query q = table->where();
+        DescriptorOrdering ordering;
+        query_builder::apply_predicate(q, ordering, ordered, converter, cache);
+        TableView tv = q.find_all(ordering);
+        CHECK_EQUAL(tv.size(), 2);
+        CHECK_EQUAL(tv.get(0).get<Int>(int_col), 9);
+        CHECK_EQUAL(tv.get(1).get<Int>(int_col), 8);
+    }
+    // and are not dropped silently where there is none to apply them to
+    CHECK_THROW(count(table, ordered, args, 1), std::logic_error);
+
+    // Invalid predicates are not cached
+    size_t size = cache.size();
+    CHECK_THROW_ANY(cache.parse("int >"));
+    CHECK_EQUAL(cache.size(), size);
+
+    cache.clear();
+    CHECK_EQUAL(cache.size(), 0);
+}
+
+
 #endif // TEST_PARSER
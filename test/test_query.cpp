@@ -3857,6 +3857,37 @@ TEST(Query_FindWithDescriptorOrdering)
 }
 
 
+TEST(Query_FindWithSortAndLimit)
+{
+    Table table;
+    auto col_int = table.add_column(type_Int, "int");
+    auto col_str = table.add_column(type_String, "str", true);
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int i = 0; i < 500; i++) {
+        // Plenty of equal values to check that the result is the same as a stable sort
+        table.create_object().set(col_int, random.draw_int<int64_t>(0, 20)).set(col_str, i % 7 ? "A" : "B");
+    }
+
+    // A limit after a sort only orders the first entries, which must be the same as the ones a full sort finds
+    for (size_t limit : {0, 1, 10, 100, 249, 250, 499, 500, 1000}) {
+        for (bool ascending : {true, false}) {
+            DescriptorOrdering ordering;
+            ordering.append_sort(SortDescriptor({{col_int}, {col_str}}, {ascending, !ascending}));
+            TableView full = table.where().find_all(ordering);
+            ordering.append_limit(limit);
+            TableView limited = table.where().find_all(ordering);
+
+            size_t expected_size = std::min(limit, table.size());
+            CHECK_EQUAL(limited.size(), expected_size);
+            CHECK_EQUAL(limited.get_num_results_excluded_by_limit(), table.size() - expected_size);
+            for (size_t i = 0; i < limited.size(); ++i) {
+                CHECK_EQUAL(limited.get_key(i), full.get_key(i));
+            }
+        }
+    }
+}
+
+
 TEST(Query_FindWithDescriptorOrderingOverTableviewSync)
 {
     Group g;
@@ -3068,6 +3068,75 @@ TEST(Query_OperatorsOverLink)
     CHECK_EQUAL(k2, tv.get_key(1));
 }
 
+TEST(Query_OperatorsOverManyRows)
+{
+    Group group;
+    TableRef table = group.add_table("table");
+    auto col_a = table->add_column(type_Int, "a", true);
+    auto col_b = table->add_column(type_Int, "b");
+    auto col_d = table->add_column(type_Double, "d");
+
+    // Enough rows to span several clusters and several chunks per cluster, with every 7th value of `a` null
+    const size_t num_rows = 3000;
+    std::vector<ObjKey> keys;
+    for (size_t i = 0; i < num_rows; i++) {
+        Obj obj = table->create_object();
+        if (i % 7)
+            obj.set(col_a, int64_t((i * 7919) % 101) - 50);
+        obj.set(col_b, int64_t((i * 104729) % 97) - 48);
+        obj.set(col_d, double(i % 13) / 2);
+        keys.push_back(obj.get_key());
+    }
+
+    auto check = [&](Query q, std::function<bool(ConstObj&)> pred) {
+        std::vector<ObjKey> expected;
+        for (auto& o : *table) {
+            if (pred(o))
+                expected.push_back(o.get_key());
+        }
+        TableView tv = q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); i++)
+            CHECK_EQUAL(tv.get_key(i), expected[i]);
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected.empty() ? null_key : expected[0]);
+        // Matching single objects must give the same result as scanning
+        for (size_t i = 0; i < num_rows; i += 97) {
+            ConstObj obj = table->get_object(keys[i]);
+            CHECK_EQUAL(q.eval_object(obj), pred(obj));
+        }
+    };
+
+    auto a = table->column<Int>(col_a);
+    auto b = table->column<Int>(col_b);
+    auto d = table->column<Double>(col_d);
+
+    check(a * 2 + b > 10, [&](ConstObj& o) {
+        auto v = o.get<util::Optional<int64_t>>(col_a);
+        return v && *v * 2 + o.get<int64_t>(col_b) > 10;
+    });
+    check(3 - a <= b, [&](ConstObj& o) {
+        auto v = o.get<util::Optional<int64_t>>(col_a);
+        return v && 3 - *v <= o.get<int64_t>(col_b);
+    });
+    check(b * 2 == a - 4, [&](ConstObj& o) {
+        auto v = o.get<util::Optional<int64_t>>(col_a);
+        return v && o.get<int64_t>(col_b) * 2 == *v - 4;
+    });
+    check(a + 1 == null(), [&](ConstObj& o) {
+        return o.is_null(col_a);
+    });
+    check(d * 2 < b, [&](ConstObj& o) {
+        return o.get<double>(col_d) * 2 < o.get<int64_t>(col_b);
+    });
+    check(10 > b, [&](ConstObj& o) {
+        return 10 > o.get<int64_t>(col_b);
+    });
+    check(b != 1000, [&](ConstObj&) {
+        return true;
+    });
+}
+
 TEST(Query_CompareLinkedColumnVsColumn)
 {
     Group group;
@@ -4950,6 +5019,64 @@ TEST(Query_IntOrQueryOptimisation)
     CHECK_EQUAL(q.count(), 3);
 }
 
+TEST(Query_WideOr)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col_a = table->add_column(type_Int, "a");
+    auto col_b = table->add_column(type_Int, "b", true);
+    auto col_s = table->add_column(type_String, "s");
+    auto col_d = table->add_column(type_Double, "d");
+
+    std::vector<ObjKey> keys;
+    for (int64_t i = 0; i < 3000; i++) {
+        auto obj = table->create_object();
+        obj.set(col_a, i % 101);
+        if (i % 5)
+            obj.set(col_b, i % 37);
+        std::string str = std::to_string(i % 11);
+        obj.set(col_s, StringData(str));
+        obj.set(col_d, double(i % 53));
+        keys.push_back(obj.get_key());
+    }
+    auto a = table->column<Int>(col_a);
+    auto b = table->column<Int>(col_b);
+    auto s = table->column<String>(col_s);
+    auto d = table->column<Double>(col_d);
+
+    // The conditions are on different columns, so they are not combined into fewer conditions
+    Query q = a == 7 || b == 3 || s == "5" || d > 51. || (a == 50 && b == null()) || b == 36;
+    auto pred = [&](ConstObj& o) {
+        auto bv = o.get<util::Optional<int64_t>>(col_b);
+        int64_t av = o.get<int64_t>(col_a);
+        return av == 7 || bv == int64_t(3) || o.get<String>(col_s) == "5" || o.get<double>(col_d) > 51. ||
+               (av == 50 && !bv) || bv == int64_t(36);
+    };
+
+    std::vector<ObjKey> expected;
+    for (auto& o : *table) {
+        if (pred(o))
+            expected.push_back(o.get_key());
+    }
+    CHECK_EQUAL(q.count(), expected.size());
+    TableView tv = q.find_all();
+    CHECK_EQUAL(tv.size(), expected.size());
+    for (size_t i = 0; i < tv.size() && i < expected.size(); i++)
+        CHECK_EQUAL(tv.get_key(i), expected[i]);
+    CHECK_EQUAL(q.find(), expected[0]);
+
+    // Limits stop the search in the middle of the bitmap
+    tv = q.find_all(0, size_t(-1), 10);
+    CHECK_EQUAL(tv.size(), 10);
+    CHECK_EQUAL(tv.get_key(9), expected[9]);
+
+    // Single objects are checked without evaluating the conditions for the whole cluster
+    for (size_t i = 0; i < keys.size(); i += 13) {
+        ConstObj obj = table->get_object(keys[i]);
+        CHECK_EQUAL(q.eval_object(obj), pred(obj));
+    }
+}
+
 TEST_IF(Query_IntOrQueryPerformance, TEST_DURATION > 0)
 {
     using std::chrono::duration_cast;
@@ -5313,4 +5440,319 @@ TEST(Query_NotImmediatelyBeforeKnownRange)
     CHECK_EQUAL(q.count(), 1);
 }
 
+TEST(Query_ParallelOnFrozen)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_int, col_int_null, col_double, col_float, col_date;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_int_null = table->add_column(type_Int, "int_null", true);
+        col_double = table->add_column(type_Double, "double");
+        col_float = table->add_column(type_Float, "float");
+        col_date = table->add_column(type_Timestamp, "date");
+        Random random(random_int<unsigned long>()); // Seed from slow global generator
+        for (int i = 0; i < 20000; ++i) {
+            Obj obj = table->create_object();
+            obj.set(col_int, random.draw_int<int64_t>(-1000, 1000));
+            if (i % 7)
+                obj.set(col_int_null, random.draw_int<int64_t>(-1000, 1000));
+            obj.set(col_double, double(random.draw_int<int>(-1000, 1000)) / 4);
+            obj.set(col_float, float(random.draw_int<int>(-1000, 1000)) / 4);
+            obj.set(col_date, Timestamp(random.draw_int<int64_t>(0, 100000), 0));
+        }
+        wt->commit();
+    }
+
+    auto frozen = db->start_frozen();
+    auto table = frozen->get_table("table");
+    auto make_queries = [&] {
+        std::vector<Query> queries;
+        queries.push_back(table->where().greater(col_int, 100));
+        queries.push_back(table->where().greater(col_int, 100).less(col_double, 50.0));
+        queries.push_back(table->where().equal(col_int, 5).Or().greater(col_float, 200.f).Or().equal(col_int_null, 3));
+        queries.push_back(table->column<Int>(col_int) > table->column<Double>(col_double));
+        queries.push_back(table->where().equal(col_int, 1234));
+        return queries;
+    };
+
+    auto serial = make_queries();
+    auto parallel = make_queries();
+    for (size_t i = 0; i < serial.size(); ++i) {
+        Query& q1 = serial[i];
+        Query& q2 = parallel[i].set_threads(4);
+
+        CHECK_EQUAL(q1.count(), q2.count());
+
+        TableView tv1 = q1.find_all();
+        TableView tv2 = q2.find_all();
+        CHECK_EQUAL(tv1.size(), tv2.size());
+        for (size_t j = 0; j < tv1.size() && j < tv2.size(); ++j)
+            CHECK_EQUAL(tv1.get_key(j), tv2.get_key(j));
+
+        CHECK_EQUAL(q1.sum_int(col_int), q2.sum_int(col_int));
+        CHECK_EQUAL(q1.sum_int(col_int_null), q2.sum_int(col_int_null));
+        CHECK_EQUAL(q1.sum_double(col_double), q2.sum_double(col_double));
+        CHECK_EQUAL(q1.sum_float(col_float), q2.sum_float(col_float));
+
+        size_t cnt1 = 0, cnt2 = 0;
+        CHECK_EQUAL(q1.average_int(col_int_null, &cnt1), q2.average_int(col_int_null, &cnt2));
+        CHECK_EQUAL(cnt1, cnt2);
+        CHECK_EQUAL(q1.average_double(col_double, &cnt1), q2.average_double(col_double, &cnt2));
+        CHECK_EQUAL(cnt1, cnt2);
+
+        ObjKey k1, k2;
+        CHECK_EQUAL(q1.maximum_int(col_int, &k1), q2.maximum_int(col_int, &k2));
+        CHECK_EQUAL(k1, k2);
+        CHECK_EQUAL(q1.minimum_int(col_int_null, &k1), q2.minimum_int(col_int_null, &k2));
+        CHECK_EQUAL(k1, k2);
+        CHECK_EQUAL(q1.maximum_double(col_double, &k1), q2.maximum_double(col_double, &k2));
+        CHECK_EQUAL(k1, k2);
+        CHECK_EQUAL(q1.minimum_float(col_float, &k1), q2.minimum_float(col_float, &k2));
+        CHECK_EQUAL(k1, k2);
+    }
+
+    ObjKey k1, k2;
+    CHECK_EQUAL(serial[0].maximum_timestamp(col_date, &k1), parallel[0].maximum_timestamp(col_date, &k2));
+    CHECK_EQUAL(k1, k2);
+}
+
+TEST(Query_PlanConditions)
+{
+    Table table;
+    auto col_small = table.add_column(type_Int, "small");
+    auto col_wide = table.add_column(type_Int, "wide");
+    auto col_opt = table.add_column(type_Int, "opt", true);
+    auto col_str = table.add_column(type_String, "str");
+
+    std::vector<ObjKey> keys;
+    table.create_objects(5000, keys);
+    size_t expected = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        int64_t small = i % 10;
+        int64_t wide = int64_t(i) * 1000;
+        Obj obj = table.get_object(keys[i]);
+        obj.set(col_small, small).set(col_wide, wide).set(col_str, (i % 3) ? "foo" : "bar");
+        if (i % 7)
+            obj.set(col_opt, int64_t(i % 7));
+        if (small > 2 && wide < 1000000 && i % 3 == 0)
+            expected++;
+    }
+
+    // No value in the leaves of 'small' can be 100, so that condition must be tested first
+    Query q1 = table.where().greater(col_small, 2).equal(col_str, "bar").equal(col_small, 100);
+    std::string plan = q1.get_plan_description();
+    CHECK(plan.find("small == 100") == 0);
+    CHECK_EQUAL(std::count(plan.begin(), plan.end(), '\n'), 3);
+    CHECK_EQUAL(q1.count(), 0);
+    CHECK_EQUAL(q1.get_plan_description(), plan);
+
+    // The plan is made again once the table has changed
+    for (auto key : keys)
+        table.get_object(key).set(col_small, 100);
+    plan = q1.get_plan_description();
+    CHECK(plan.find("str") == 0);
+    CHECK_EQUAL(q1.count(), keys.size() / 3 + 1);
+    for (size_t i = 0; i < keys.size(); i++)
+        table.get_object(keys[i]).set(col_small, int64_t(i % 10));
+
+    // The order chosen must not change the result
+    Query q2 = table.where().greater(col_small, 2).less(col_wide, 1000000).equal(col_str, "bar");
+    CHECK_EQUAL(q2.count(), expected);
+    TableView tv = q2.find_all();
+    CHECK_EQUAL(tv.size(), expected);
+    for (size_t i = 1; i < tv.size(); i++)
+        CHECK_LESS(tv.get_key(i - 1), tv.get_key(i));
+    CHECK_EQUAL(q2.sum_int(col_small), table.where().equal(col_str, "bar").greater(col_small, 2)
+                                           .less(col_wide, 1000000).sum_int(col_small));
+
+    Query q3 = table.where().not_equal(col_opt, 100).equal(col_small, 3).equal(col_opt, null());
+    size_t expected_null = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i % 10 == 3 && i % 7 == 0)
+            expected_null++;
+    }
+    CHECK_EQUAL(q3.count(), expected_null);
+
+    // A query assigned other conditions plans them anew
+    Query q4 = table.where().greater(col_small, 2).equal(col_str, "bar").equal(col_small, 100);
+    CHECK_EQUAL(q4.count(), 0);
+    q4 = q2;
+    CHECK_EQUAL(q4.get_plan_description(), q2.get_plan_description());
+    CHECK_EQUAL(q4.count(), expected);
+
+    // Queries on an empty table have nothing to sample
+    Table empty;
+    auto col = empty.add_column(type_Int, "int");
+    CHECK_EQUAL(empty.where().equal(col, 1).greater(col, 0).count(), 0);
+}
+
+TEST(Query_ZoneMaps)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_int, col_int_null, col_date;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_int_null = table->add_column(type_Int, "int_null", true);
+        col_date = table->add_column(type_Timestamp, "date", true);
+        // Increasing values, like in a time series
+        for (int64_t i = 0; i < 10000; ++i) {
+            Obj obj = table->create_object();
+            obj.set(col_int, i);
+            if (i % 1000 < 500)
+                obj.set(col_int_null, i / 10);
+            if (i % 3)
+                obj.set(col_date, Timestamp(i, int32_t(i % 2)));
+        }
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    auto check_queries = [&](ConstTableRef table) {
+        std::vector<Query> queries;
+        queries.push_back(table->where().greater(col_int, 9000));
+        queries.push_back(table->where().less(col_int, 10));
+        queries.push_back(table->where().between(col_int, 4000, 4100));
+        queries.push_back(table->where().equal(col_int, 5000));
+        queries.push_back(table->where().not_equal(col_int, 5000).less(col_int, 2000));
+        queries.push_back(table->where().equal(col_int_null, null()).greater(col_int, 8000));
+        queries.push_back(table->where().not_equal(col_int_null, null()).less(col_int, 1000));
+        queries.push_back(table->where().greater(col_int_null, 900));
+        queries.push_back(table->where().equal(col_int_null, 300));
+        queries.push_back(table->where().greater(col_date, Timestamp(9900, 0)));
+        queries.push_back(table->where().less_equal(col_date, Timestamp(5, 1)));
+        queries.push_back(table->where().equal(col_date, Timestamp(7001, 1)));
+        queries.push_back(table->where().equal(col_date, Timestamp(7001, 0)));
+        queries.push_back(table->where().equal(col_date, Timestamp()).greater_equal(col_int, 9995));
+        queries.push_back(table->where().greater(col_int, 20000));
+
+        for (auto& q : queries) {
+            // Also initializes the query for eval_object()
+            size_t count = q.count();
+            std::vector<ObjKey> expected;
+            for (auto obj : *table) {
+                if (q.eval_object(obj))
+                    expected.push_back(obj.get_key());
+            }
+            CHECK_EQUAL(count, expected.size());
+            TableView tv = q.find_all();
+            CHECK_EQUAL(tv.size(), expected.size());
+            for (size_t i = 0; i < tv.size() && i < expected.size(); i++)
+                CHECK_EQUAL(tv.get_key(i), expected[i]);
+            CHECK_EQUAL(q.find(), expected.empty() ? ObjKey() : expected[0]);
+            int64_t sum = 0;
+            for (auto key : expected)
+                sum += table->get_object(key).get<int64_t>(col_int);
+            CHECK_EQUAL(q.sum_int(col_int), sum);
+        }
+    };
+
+    check_queries(rt->get_table("table"));
+    check_queries(db->start_frozen()->get_table("table"));
+
+    // Change values in the middle of the table, both in write transactions and from another
+    // transaction, and check that the summaries are kept up to date
+    for (int64_t round = 0; round < 3; round++) {
+        {
+            auto wt = db->start_write();
+            auto table = wt->get_table("table");
+            for (int64_t i = 4000; i < 4050; ++i) {
+                Obj obj = table->get_object(size_t(i + round));
+                obj.set(col_int, obj.get<int64_t>(col_int) + 20000);
+                obj.set_null(col_int_null);
+                obj.set(col_date, Timestamp(-i, 0));
+            }
+            table->create_object().set(col_int, 15000 + round);
+            wt->commit();
+        }
+        rt->advance_read();
+        check_queries(rt->get_table("table"));
+    }
+
+    rt->promote_to_write();
+    auto table = rt->get_table("table");
+    check_queries(table);
+    table->get_object(size_t(100)).set(col_int, 30000);
+    table->get_object(size_t(9999)).remove();
+    check_queries(table);
+    rt->commit_and_continue_as_read();
+    check_queries(rt->get_table("table"));
+}
+
+TEST(Query_ZoneMapsEmptyLeaf)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    {
+        auto wt = db->start_write();
+        for (auto name : {"never_filled", "emptied", "cleared"}) {
+            auto table = wt->add_table(name);
+            table->add_column(type_Int, "int");
+            table->add_column(type_Int, "int_null", true);
+            table->add_column(type_Timestamp, "date", true);
+        }
+        for (auto name : {"emptied", "cleared"}) {
+            auto table = wt->get_table(name);
+            auto col_int = table->get_column_key("int");
+            auto col_int_null = table->get_column_key("int_null");
+            auto col_date = table->get_column_key("date");
+            for (int64_t i = 0; i < 2000; ++i) {
+                Obj obj = table->create_object();
+                obj.set(col_int, i);
+                if (i % 2)
+                    obj.set(col_int_null, i);
+                obj.set(col_date, Timestamp(i, 0));
+            }
+        }
+        wt->commit();
+    }
+    {
+        // Removing the objects one by one leaves the root as an empty leaf
+        auto wt = db->start_write();
+        auto table = wt->get_table("emptied");
+        while (table->size())
+            table->remove_object(table->begin()->get_key());
+        wt->get_table("cleared")->clear();
+        wt->commit();
+    }
+
+    auto check_queries = [&](ConstTableRef table) {
+        CHECK_EQUAL(table->size(), 0);
+        auto col_int = table->get_column_key("int");
+        auto col_int_null = table->get_column_key("int_null");
+        auto col_date = table->get_column_key("date");
+        std::vector<Query> queries;
+        queries.push_back(table->where());
+        queries.push_back(table->where().greater(col_int, 10));
+        queries.push_back(table->where().less_equal(col_int, std::numeric_limits<int64_t>::max()));
+        queries.push_back(table->where().greater_equal(col_int, std::numeric_limits<int64_t>::min()));
+        queries.push_back(table->where().not_equal(col_int, 5));
+        queries.push_back(table->where().equal(col_int_null, null()));
+        queries.push_back(table->where().not_equal(col_int_null, null()));
+        queries.push_back(table->where().not_equal(col_int_null, 3));
+        queries.push_back(table->where().not_equal(col_date, Timestamp(1, 0)));
+        queries.push_back(table->where().less(col_date, Timestamp(10, 0)));
+        for (auto& q : queries) {
+            CHECK_EQUAL(q.count(), 0);
+            CHECK_EQUAL(q.find_all().size(), 0);
+            CHECK_EQUAL(q.find(), ObjKey());
+        }
+    };
+
+    auto rt = db->start_read();
+    auto frozen = db->start_frozen();
+    for (auto name : {"never_filled", "emptied", "cleared"}) {
+        check_queries(rt->get_table(name));
+        check_queries(frozen->get_table(name));
+    }
+}
+
 #endif // TEST_QUERY
@@ -23,6 +23,7 @@
 #include <streambuf>
 #include <fstream>
 #include <tuple>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <thread>
@@ -1449,6 +1450,529 @@ TEST(Shared_WriterThreads)
 }
 
 
+TEST(Shared_GroupCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_group_commit = true;
+    const int thread_count = 8;
+    const int commit_count = 50;
+    {
+        DBRef sg = DB::create(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            auto t = wt.add_table("test");
+            auto col = t->add_column(type_Int, "value");
+            for (int i = 0; i < thread_count; ++i)
+                t->create_object(ObjKey(i)).set(col, 0);
+            wt.commit();
+        }
+
+        // Concurrent writers get their commits synced together
+        Thread threads[thread_count];
+        for (int i = 0; i < thread_count; ++i) {
+            threads[i].start([&sg, i] {
+                for (int j = 0; j < commit_count; ++j) {
+                    WriteTransaction wt(sg);
+                    auto t = wt.get_table("test");
+                    t->get_object(ObjKey(i)).add_int(t->get_column_key("value"), 1);
+                    wt.commit();
+                }
+            });
+        }
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].join();
+
+        // A commit which was left to a waiting writer is made durable even if that writer rolls back, without
+        // committing another version
+        auto tr = sg->start_write();
+        Thread thread;
+        thread.start([&sg] {
+            auto tr2 = sg->start_write();
+            millisleep(100);
+            tr2->rollback();
+        });
+        millisleep(100); // Let the thread wait for the write lock
+        auto t = tr->get_table("test");
+        t->get_object(ObjKey(0)).add_int(t->get_column_key("value"), 1);
+        DB::version_type version = tr->commit();
+        thread.join();
+        CHECK_EQUAL(sg->get_version_of_latest_snapshot(), version);
+    }
+
+    // A new session reads the latest version from the file
+    DBRef sg = DB::create(path, false, options);
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto t = rt.get_table("test");
+    auto col = t->get_column_key("value");
+    CHECK_EQUAL(t->get_object(ObjKey(0)).get<Int>(col), commit_count + 1);
+    for (int i = 1; i < thread_count; ++i)
+        CHECK_EQUAL(t->get_object(ObjKey(i)).get<Int>(col), commit_count);
+}
+
+TEST(Shared_GroupCommitConcurrent)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_group_commit = true;
+    const int commit_count = 100;
+    {
+        DBRef sg = DB::create(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            auto t = wt.add_table("test");
+            auto col = t->add_column(type_Int, "value");
+            for (int i = 0; i < 2; ++i)
+                t->create_object(ObjKey(i)).set(col, 0);
+            wt.commit();
+        }
+
+        // Two threads committing at the same time each leave syncing to the other one in turn. Neither of them
+        // takes the write lock again to sync its own commit.
+        std::atomic<int> ready{0};
+        Thread threads[2];
+        for (int i = 0; i < 2; ++i) {
+            threads[i].start([&, i] {
+                for (int j = 0; j < commit_count; ++j) {
+                    ready++;
+                    while (ready < 2 * (j + 1))
+                        std::this_thread::yield();
+                    auto tr = sg->start_write();
+                    auto t = tr->get_table("test");
+                    t->get_object(ObjKey(i)).add_int(t->get_column_key("value"), 1);
+                    DB::version_type version = tr->commit();
+                    CHECK_LESS_EQUAL(version, sg->get_version_of_latest_snapshot());
+                }
+            });
+        }
+        for (int i = 0; i < 2; ++i)
+            threads[i].join();
+
+        // A commit left to a writer which waits for that commit to return does not deadlock
+        auto tr = sg->start_write();
+        std::atomic<bool> committed{false};
+        Thread thread;
+        thread.start([&] {
+            auto tr2 = sg->start_write();
+            while (!committed)
+                millisleep(1);
+            auto t = tr2->get_table("test");
+            t->get_object(ObjKey(1)).add_int(t->get_column_key("value"), 1);
+            tr2->commit();
+        });
+        millisleep(100); // Let the thread wait for the write lock
+        auto t = tr->get_table("test");
+        t->get_object(ObjKey(0)).add_int(t->get_column_key("value"), 1);
+        tr->commit();
+        committed = true;
+        thread.join();
+    }
+
+    // A new session reads the latest version from the file
+    DBRef sg = DB::create(path, false, options);
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto t = rt.get_table("test");
+    auto col = t->get_column_key("value");
+    for (int i = 0; i < 2; ++i)
+        CHECK_EQUAL(t->get_object(ObjKey(i)).get<Int>(col), commit_count + 1);
+}
+
+TEST(Shared_CommitAsync)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const int commit_count = 20;
+    {
+        DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg);
+            wt.add_table("test")->add_column(type_Int, "value");
+            wt.commit();
+        }
+
+        std::vector<std::pair<DB::version_type, std::future<DB::version_type>>> commits;
+        for (int i = 0; i < commit_count; ++i) {
+            auto tr = sg->start_write();
+            auto t = tr->get_table("test");
+            t->create_object().set(t->get_column_key("value"), i);
+            DB::version_type version = tr->get_version_of_current_transaction().version + 1;
+            commits.emplace_back(version, tr->commit_async());
+        }
+        for (auto& commit : commits)
+            CHECK_EQUAL(commit.second.get(), commit.first);
+
+        // Commits made right before closing are still made durable
+        auto tr = sg->start_write();
+        auto t = tr->get_table("test");
+        t->create_object().set(t->get_column_key("value"), commit_count);
+        auto last = tr->commit_async();
+        sg->close();
+        CHECK(last.get() > commits.back().first);
+    }
+
+    // A new session reads the latest version from the file
+    DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto t = rt.get_table("test");
+    CHECK_EQUAL(t->size(), commit_count + 1);
+    CHECK_EQUAL(t->sum_int(t->get_column_key("value")), commit_count * (commit_count + 1) / 2);
+}
+
+TEST(Shared_CommitAsyncWithoutDeferredSync)
+{
+    // Encrypted files and durability levels other than Full never leave syncing to the sync thread, so the
+    // commits are durable once commit_async() returns
+    std::vector<DBOptions> options = {DBOptions(DBOptions::Durability::MemOnly, crypt_key())};
+#if REALM_ENABLE_ENCRYPTION
+    options.push_back(DBOptions(crypt_key(true)));
+#endif
+    for (auto& opt : options) {
+        SHARED_GROUP_TEST_PATH(path);
+        DBRef sg = DB::create(path, false, opt);
+        for (int i = 0; i < 5; ++i) {
+            auto tr = sg->start_write();
+            auto t = tr->get_table("test");
+            if (!t)
+                t = tr->add_table("test");
+            t->create_object();
+            DB::version_type version = tr->get_version_of_current_transaction().version + 1;
+            auto durable = tr->commit_async();
+            CHECK(durable.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+            CHECK_EQUAL(durable.get(), version);
+        }
+    }
+}
+
+TEST(Shared_ReadLocksWhileRingbufferGrows)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const int thread_count = 4;
+    const int commit_count = 200;
+    DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg);
+        wt.add_table("test")->add_column(type_Int, "value");
+        wt.get_table("test")->create_object(ObjKey(0));
+        wt.commit();
+    }
+
+    // Readers keep starting transactions without the DB mutex while the ringbuffer is remapped
+    std::atomic<bool> done{false};
+    Thread threads[thread_count];
+    for (int i = 0; i < thread_count; ++i) {
+        threads[i].start([&] {
+            int64_t last = 0;
+            while (!done) {
+                auto rt = sg->start_read();
+                auto t = rt->get_table("test");
+                int64_t value = t->get_object(ObjKey(0)).get<Int>(t->get_column_key("value"));
+                CHECK_GREATER_EQUAL(value, last);
+                last = value;
+            }
+        });
+    }
+
+    // Every version is kept alive, which makes the ringbuffer grow
+    std::vector<TransactionRef> pinned;
+    for (int i = 1; i <= commit_count; ++i) {
+        WriteTransaction wt(sg);
+        auto t = wt.get_table("test");
+        t->get_object(ObjKey(0)).set(t->get_column_key("value"), i);
+        wt.commit();
+        pinned.push_back(sg->start_read());
+    }
+    done = true;
+    for (int i = 0; i < thread_count; ++i)
+        threads[i].join();
+
+    for (int i = 0; i < commit_count; ++i) {
+        auto t = pinned[i]->get_table("test");
+        CHECK_EQUAL(t->get_object(ObjKey(0)).get<Int>(t->get_column_key("value")), i + 1);
+    }
+    CHECK_GREATER_EQUAL(sg->get_number_of_versions(), commit_count);
+    pinned.clear();
+
+    // All read locks are released again
+    {
+        WriteTransaction wt(sg);
+        wt.commit();
+    }
+    CHECK_LESS_EQUAL(sg->get_number_of_versions(), 2);
+}
+
+TEST(Shared_ReadLocksReleasedWhileClosing)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const int thread_count = 4;
+    const int reads_per_thread = 200;
+    for (int round = 0; round < 10; ++round) {
+        DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+        if (round == 0) {
+            WriteTransaction wt(sg);
+            wt.add_table("test")->add_column(type_Int, "value");
+            wt.commit();
+        }
+
+        // Read locks are released without the DB mutex while the DB is closed with open read transactions
+        std::vector<TransactionRef> reads[thread_count];
+        for (int i = 0; i < thread_count; ++i) {
+            for (int j = 0; j < reads_per_thread; ++j)
+                reads[i].push_back(sg->start_read());
+        }
+        std::atomic<int> started{0};
+        Thread threads[thread_count];
+        for (int i = 0; i < thread_count; ++i) {
+            threads[i].start([&, i] {
+                ++started;
+                for (auto& rt : reads[i])
+                    rt->end_read();
+            });
+        }
+        while (started < thread_count)
+            std::this_thread::yield();
+        sg->close(true);
+        CHECK(!sg->is_attached());
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].join();
+    }
+
+    // The session ended cleanly, and the file opens again
+    DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+    auto rt = sg->start_read();
+    CHECK(rt->has_table("test"));
+}
+
+TEST(Shared_WriteAheadLog)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(copy_path);
+    DBOptions options;
+    options.enable_write_ahead_log = true;
+    const int commit_count = 20;
+    auto selected_file_format = [](const std::string& p) {
+        char header[24];
+        File(p).read(header, sizeof header);
+        return int(uint8_t(header[20 + (header[23] & 1)]));
+    };
+    {
+        DBRef sg = DB::create(path, false, options);
+        WriteTransaction wt(sg);
+        wt.add_table("test")->add_column(type_Int, "value");
+        wt.commit();
+    }
+    // Closing checkpoints the log
+    CHECK_EQUAL(File(std::string(path) + ".wal").get_size(), 0);
+
+    {
+        DBRef sg = DB::create(path, false, options);
+        for (int i = 0; i < commit_count; ++i) {
+            WriteTransaction wt(sg);
+            auto t = wt.get_table("test");
+            t->create_object().set(t->get_column_key("value"), i);
+            wt.commit();
+            // The state of the file after a crash, where nothing but the mark of the file and the log was synced
+            // since the last checkpoint
+            if (i == 0)
+                File::copy(path, copy_path);
+        }
+        CHECK(File(std::string(path) + ".wal").get_size() > 0);
+        File::copy(std::string(path) + ".wal", std::string(copy_path) + ".wal");
+
+        // The file is marked, so that it is not read without the log. Cores which do not know the mark find a file
+        // format version they do not support.
+        CHECK_THROW(Group(std::string(path)), InvalidDatabase);
+        CHECK_GREATER(selected_file_format(path), 11);
+        {
+            // Participants joining the session still see the actual version
+            DBRef sg_2 = DB::create(path, false, options);
+            CHECK_EQUAL(sg_2->start_read()->get_table("test")->size(), commit_count);
+        }
+
+        // Sessions must agree on the use of the log
+        CHECK_LOGIC_ERROR(DB::create(path, false, DBOptions()), LogicError::mixed_durability);
+    }
+
+    // The log is applied when the file is opened again
+    auto check = [&](DBRef sg) {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        auto t = rt.get_table("test");
+        CHECK_EQUAL(t->size(), commit_count);
+        CHECK_EQUAL(t->sum_int(t->get_column_key("value")), commit_count * (commit_count - 1) / 2);
+    };
+    check(DB::create(copy_path));
+    CHECK_EQUAL(File(std::string(copy_path) + ".wal").get_size(), 0);
+    CHECK_EQUAL(selected_file_format(copy_path), 10);
+    check(DB::create(path, false, options));
+    {
+        Group g(path);
+        CHECK_EQUAL(g.get_table("test")->size(), commit_count);
+    }
+
+    // The sync thread checkpoints the log once it is large enough
+    options.write_ahead_log_checkpoint_size = 1;
+    DBRef sg = DB::create(path, false, options);
+    {
+        WriteTransaction wt(sg);
+        auto t = wt.get_table("test");
+        t->create_object().set(t->get_column_key("value"), commit_count);
+        wt.commit();
+    }
+    File log(std::string(path) + ".wal");
+    for (int i = 0; i < 1000 && log.get_size() > 0; ++i)
+        millisleep(10);
+    CHECK_EQUAL(log.get_size(), 0);
+}
+
+TEST(Shared_WriteAheadLogStale)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(other_path);
+    SHARED_GROUP_TEST_PATH(stale_log_path);
+    DBOptions options;
+    options.enable_write_ahead_log = true;
+    std::string log_path = std::string(path) + ".wal";
+    {
+        DBRef sg = DB::create(path, false, options);
+        WriteTransaction wt(sg);
+        auto t = wt.add_table("test");
+        auto col = t->add_column(type_Int, "value");
+        for (int i = 0; i < 100; ++i)
+            t->create_object().set(col, i);
+        wt.commit();
+    }
+    {
+        // A log which still holds commits, left next to the file
+        DBRef sg = DB::create(path, false, options);
+        WriteTransaction wt(sg);
+        auto t = wt.get_table("test");
+        t->create_object().set(t->get_column_key("value"), 100);
+        wt.commit();
+        File::copy(log_path, stale_log_path);
+    }
+    {
+        DBRef sg = DB::create(other_path, false, DBOptions());
+        WriteTransaction wt(sg);
+        auto t = wt.add_table("other");
+        auto col = t->add_column(type_String, "name");
+        for (int i = 0; i < 10; ++i)
+            t->create_object().set(col, "other");
+        wt.commit();
+    }
+
+    // The file is replaced by another one, like when it is restored from a backup, and the stale log is put back
+    File::copy(other_path, path);
+    File::copy(stale_log_path, log_path);
+    CHECK(File(log_path).get_size() > 0);
+
+    // The log is not applied to a file which is not marked as having commits in it
+    {
+        DBRef sg = DB::create(path, false, options);
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        CHECK(!rt.has_table("test"));
+        CHECK_EQUAL(rt.get_table("other")->size(), 10);
+    }
+    CHECK_EQUAL(File(log_path).get_size(), 0);
+    {
+        Group g(path);
+        CHECK_EQUAL(g.get_table("other")->size(), 10);
+    }
+}
+
+TEST_IF(Shared_WriteAheadLogCommitFailure, _impl::SimulatedFailure::is_enabled())
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(copy_path);
+    DBOptions options;
+    options.enable_write_ahead_log = true;
+    DBRef sg = DB::create(path, false, options);
+    {
+        WriteTransaction wt(sg);
+        wt.add_table("test")->add_column(type_Int, "value");
+        wt.commit();
+    }
+    sg->close();
+    sg = DB::create(path, false, options);
+
+    auto add = [&](int64_t value) {
+        WriteTransaction wt(sg);
+        auto t = wt.get_table("test");
+        t->create_object().set(t->get_column_key("value"), value);
+        wt.commit();
+    };
+    add(1);
+    // The file as left by a crash, marked as having commits in the log
+    File::copy(path, copy_path);
+    uint64_t log_size = File(std::string(path) + ".wal").get_size();
+    {
+        // The record is written, but the log is not synced
+        using sf = _impl::SimulatedFailure;
+        sf::OneShotPrimeGuard pg(sf::write_ahead_log__sync);
+        CHECK_THROW(add(100), sf);
+    }
+    // The record of the failed commit is cut off again
+    CHECK_EQUAL(File(std::string(path) + ".wal").get_size(), log_size);
+    add(2);
+    add(3);
+    File::copy(std::string(path) + ".wal", std::string(copy_path) + ".wal");
+
+    // The commits made after the failed one are replayed
+    DBRef sg_2 = DB::create(copy_path);
+    ReadTransaction rt(sg_2);
+    auto t = rt.get_table("test");
+    CHECK_EQUAL(t->size(), 3);
+    CHECK_EQUAL(t->sum_int(t->get_column_key("value")), 6);
+}
+
+TEST(Shared_LargeCommit)
+{
+    // Large enough for the leaves to be copied into the file by more than one thread
+    SHARED_GROUP_TEST_PATH(path);
+    const int table_count = 4;
+    const size_t object_count = 2000;
+    std::string blob(1024, 'x');
+    auto blob_value = [&](size_t i) {
+        std::string value = blob;
+        value[i % value.size()] = char('a' + i % 26);
+        return value;
+    };
+    {
+        DBRef sg = DB::create(path);
+        WriteTransaction wt(sg);
+        for (int t = 0; t < table_count; ++t) {
+            std::string name = "table_" + util::to_string(t);
+            auto table = wt.add_table(name);
+            auto col_int = table->add_column(type_Int, "int");
+            auto col_string = table->add_column(type_String, "string");
+            for (size_t i = 0; i < object_count; ++i) {
+                std::string value = blob_value(i);
+                table->create_object().set(col_int, int64_t(i * t)).set(col_string, StringData(value));
+            }
+        }
+        wt.commit();
+    }
+
+    DBRef sg = DB::create(path);
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    for (int t = 0; t < table_count; ++t) {
+        std::string name = "table_" + util::to_string(t);
+        auto table = rt.get_table(name);
+        CHECK_EQUAL(table->size(), object_count);
+        auto col_int = table->get_column_key("int");
+        auto col_string = table->get_column_key("string");
+        size_t i = 0;
+        for (auto& obj : *table) {
+            CHECK_EQUAL(obj.get<int64_t>(col_int), int64_t(i * t));
+            CHECK_EQUAL(obj.get<StringData>(col_string), blob_value(i));
+            ++i;
+        }
+    }
+}
+
 #if !REALM_ENABLE_ENCRYPTION && defined(ENABLE_ROBUST_AGAINST_DEATH_DURING_WRITE)
 // this unittest has issues that has not been fully understood, but could be
 // related to interaction between posix robust mutexes and the fork() system call.
@@ -1584,6 +2108,206 @@ TEST(Shared_SpaceOveruse)
 }
 
 
+TEST(Shared_FreeListsKeptBetweenCommits)
+{
+    // The free lists are carried over from one commit of a DB to the next,
+    // unless another DB has committed in between
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef sg_1 = DB::create(path);
+    DBRef sg_2 = DB::create(path);
+    std::deque<TransactionRef> readers;
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    size_t expected_size = 0;
+    for (int i = 0; i < 300; ++i) {
+        DBRef sg = (i % 10 == 9) ? sg_2 : sg_1;
+        WriteTransaction wt(sg);
+        wt.get_group().verify();
+        auto table = wt.get_or_add_table("table");
+        if (table->get_column_count() == 0)
+            table->add_column(type_String, "text");
+        auto col = table->get_column_key("text");
+        int n = random.draw_int<int>(0, 100);
+        for (int j = 0; j < n; ++j)
+            table->create_object().set(col, std::string(random.draw_int<size_t>(0, 200), 'x'));
+        expected_size += n;
+        if (expected_size > 0) {
+            int m = random.draw_int<int>(0, 50);
+            for (int j = 0; j < m && expected_size > 0; ++j) {
+                table->remove_object(table->get_object(random.draw_int<size_t>(0, expected_size - 1)).get_key());
+                --expected_size;
+            }
+        }
+        wt.commit();
+
+        // Hold on to some versions, so that the space they use is locked for a while
+        if (i % 7 == 0)
+            readers.push_back(sg_1->start_read());
+        if (readers.size() > 3 || (i % 11 == 0 && !readers.empty()))
+            readers.pop_front();
+    }
+    readers.clear();
+
+    ReadTransaction rt(sg_1);
+    rt.get_group().verify();
+    CHECK_EQUAL(rt.get_table("table")->size(), expected_size);
+}
+
+
+TEST(Shared_IncrementalCompaction)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options;
+    options.incremental_compaction_budget = 64 * 1024;
+    DBRef sg = DB::create(path, false, options);
+    // Compaction does not need the DB to be the only session participant
+    DBRef sg_2 = DB::create(path, false, options);
+    const size_t object_count = 10000;
+    auto fill = [&](const char* name) {
+        WriteTransaction wt(sg);
+        auto table = wt.add_table(name);
+        auto col = table->add_column(type_String, "text");
+        for (size_t i = 0; i < object_count; ++i)
+            table->create_object().set(col, std::string(100 + i % 100, 'a' + i % 26));
+        wt.commit();
+    };
+    fill("first");
+    // The second table is written after the first one, at the end of the file
+    fill("second");
+    {
+        WriteTransaction wt(sg);
+        wt.get_group().remove_table("first");
+        wt.add_table("counter")->add_column(type_Int, "value");
+        wt.get_table("counter")->create_object();
+        wt.commit();
+    }
+    size_t initial_size = size_t(File(path).get_size());
+
+    // Ordinary commits move the second table to the space of the first, and cut the file short
+    for (int i = 0; i < 200; ++i) {
+        WriteTransaction wt(i % 2 ? sg : sg_2);
+        auto counter = wt.get_table("counter");
+        counter->begin()->set(counter->get_column_key("value"), i);
+        wt.commit();
+    }
+    size_t final_size = size_t(File(path).get_size());
+    CHECK_LESS(final_size, initial_size * 3 / 4);
+
+    // Both sessions no longer map the part of the file that was cut off
+    for (DBRef db : {sg, sg_2}) {
+        ReadTransaction rt(db);
+        auto& alloc = static_cast<SlabAlloc&>(_impl::GroupFriend::get_alloc(rt.get_group()));
+        CHECK_LESS_EQUAL(alloc.get_baseline(), final_size);
+    }
+
+    // The file grows again from its new end
+    std::swap(sg, sg_2);
+    fill("third");
+    std::swap(sg, sg_2);
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    for (const char* name : {"second", "third"}) {
+        auto table = rt.get_table(name);
+        CHECK_EQUAL(table->size(), object_count);
+        auto col = table->get_column_key("text");
+        size_t i = 0;
+        for (auto& obj : *table) {
+            CHECK_EQUAL(obj.get<String>(col), std::string(100 + i % 100, 'a' + i % 26));
+            ++i;
+        }
+    }
+}
+
+
+TEST(Shared_FileGrowthAhead)
+{
+    const size_t room = 1024 * 1024;
+    auto add_objects = [](DBRef sg, size_t count) {
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        auto col = table->get_column_key("text");
+        for (size_t i = 0; i < count; ++i)
+            table->create_object().set(col, std::string(200, 'x'));
+        wt.commit();
+    };
+    auto create = [](DBRef sg) {
+        WriteTransaction wt(sg);
+        wt.add_table("table")->add_column(type_String, "text");
+        wt.commit();
+    };
+
+    // Without growth ahead, commits adding data extend the file themselves
+    {
+        SHARED_GROUP_TEST_PATH(path);
+        DBRef sg = DB::create(path);
+        create(sg);
+        for (int i = 0; i < 10; ++i)
+            add_objects(sg, 100);
+        CHECK_GREATER(sg->get_file_growth_stats().commit_extensions, 0);
+        CHECK_EQUAL(sg->get_file_growth_stats().background_extensions, 0);
+    }
+
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options;
+    options.file_growth_ahead = room;
+    DBRef sg = DB::create(path, false, options);
+    create(sg);
+    // The background thread extends the file after the first commit, without waiting for the write lock
+    {
+        auto wt = sg->start_write();
+        for (int i = 0; i < 500 && sg->get_file_growth_stats().background_extensions == 0; ++i)
+            millisleep(10);
+        CHECK_GREATER(sg->get_file_growth_stats().background_extensions, 0);
+        wt->rollback();
+    }
+    CHECK_GREATER_EQUAL(size_t(File(path).get_size()), room);
+
+    // Commits writing less than the room do not have to extend the file
+    uint64_t commit_extensions = sg->get_file_growth_stats().commit_extensions;
+    for (int i = 0; i < 10; ++i)
+        add_objects(sg, 100);
+    CHECK_EQUAL(sg->get_file_growth_stats().commit_extensions, commit_extensions);
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    CHECK_EQUAL(rt.get_table("table")->size(), 1000);
+}
+
+
+TEST(Shared_MappingHints)
+{
+    for (auto prefault : {DBOptions::Prefault::WillNeed, DBOptions::Prefault::Populate}) {
+        SHARED_GROUP_TEST_PATH(path);
+        DBOptions options;
+        options.prefault = prefault;
+        options.advise_random_access = true;
+        options.use_huge_pages = true;
+        DBRef sg = DB::create(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            auto table = wt.add_table("table");
+            auto col = table->add_column(type_String, "text");
+            for (size_t i = 0; i < 10000; ++i)
+                table->create_object().set(col, std::string(100, 'a' + i % 26));
+            wt.commit();
+        }
+        CHECK(sg->compact());
+        // A second DB maps the file grown by the first one
+        DBRef sg_2 = DB::create(path, false, options);
+        ReadTransaction rt(sg_2);
+        rt.get_group().verify();
+        auto table = rt.get_table("table");
+        CHECK_EQUAL(table->size(), 10000);
+        auto col = table->get_column_key("text");
+        size_t i = 0;
+        for (auto& obj : *table) {
+            CHECK_EQUAL(obj.get<String>(col), std::string(100, 'a' + i % 26));
+            ++i;
+        }
+    }
+}
+
+
 TEST(Shared_Notifications)
 {
     // Create a new shared db
@@ -5060,4 +5060,45 @@ TEST(Table_IteratorRandomAccess)
     CHECK_EQUAL(keys[1], iter->get_key());
 }
 
+TEST(Table_WarmUp)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef db = DB::create(path, false, DBOptions(crypt_key()));
+    ColKey col_int;
+    ColKey col_str;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_str = table->add_column(type_String, "str");
+        for (int64_t i = 0; i < 10000; ++i)
+            table->create_object().set(col_int, i).set(col_str, util::to_string(i));
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    auto table = rt->get_table("table");
+    size_t int_size = table->warm_up(col_int);
+    size_t str_size = table->warm_up(col_str);
+    size_t table_size = table->warm_up();
+    CHECK_GREATER(int_size, 10000);
+    CHECK_GREATER(str_size, 10000);
+    CHECK_GREATER(table_size, int_size + str_size);
+    // Reading it again reads the same
+    CHECK_EQUAL(table->warm_up(col_int), int_size);
+
+    int64_t i = 0;
+    for (auto& obj : *table) {
+        CHECK_EQUAL(obj.get<Int>(col_int), i);
+        CHECK_EQUAL(obj.get<StringData>(col_str), util::to_string(i));
+        ++i;
+    }
+
+    Table other;
+    other.add_column(type_Int, "a");
+    other.add_column(type_Int, "b");
+    ColKey missing = other.add_column(type_Int, "c");
+    CHECK_THROW(table->warm_up(missing), InvalidKey);
+}
+
 #endif // TEST_TABLE
@@ -26,6 +26,7 @@
 #include <cwchar>
 
 #include <realm.hpp>
+#include <realm/history.hpp>
 
 #include "util/misc.hpp"
 
@@ -2918,4 +2919,207 @@ TEST(TableView_TimestampMaxRemoveRow)
     CHECK_EQUAL(tv.maximum_timestamp(col_date), Timestamp(8, 0));
 }
 
+TEST(TableView_IncrementalSync)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_value;
+    ColKey col_name;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_value = table->add_column(type_Int, "value", true);
+        col_name = table->add_column(type_String, "name");
+        for (int i = 0; i < 500; i++)
+            table->create_object().set(col_value, i % 100).set(col_name, std::string(1, char('a' + i % 26)));
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+    SortDescriptor sort({{col_value}, {col_name}}, {false, true});
+    auto make_views = [&] {
+        std::vector<TableView> views;
+        views.push_back(table->where().greater(col_value, 40).find_all());
+        views.push_back(table->where().less(col_value, 70).find_all());
+        views.back().sort(sort);
+        views.push_back(table->where().equal(col_value, null()).Or().equal(col_name, "q").find_all());
+        views.back().sort(col_name, false);
+        return views;
+    };
+    std::vector<TableView> views = make_views();
+    for (auto& tv : views) {
+        tv.set_incremental_sync(true);
+        CHECK(tv.get_incremental_sync());
+    }
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int round = 0; round < 20; round++) {
+        {
+            auto wt = db->start_write();
+            auto t = wt->get_table("table");
+            for (int i = 0; i < 10; i++) {
+                Obj obj = t->get_object(random.draw_int<size_t>(0, t->size() - 1));
+                switch (random.draw_int<int>(0, 4)) {
+                    case 0:
+                        obj.set(col_value, random.draw_int<int64_t>(0, 100));
+                        break;
+                    case 1:
+                        obj.set_null(col_value);
+                        break;
+                    case 2:
+                        obj.set(col_name, "q");
+                        break;
+                    case 3:
+                        obj.remove();
+                        break;
+                    case 4:
+                        t->create_object().set(col_value, random.draw_int<int64_t>(0, 100)).set(col_name, "q");
+                        break;
+                }
+            }
+            wt->commit();
+        }
+        rt->advance_read();
+        std::vector<TableView> expected = make_views();
+        for (size_t v = 0; v < views.size(); v++) {
+            CHECK(!views[v].is_in_sync());
+            views[v].sync_if_needed();
+            CHECK(views[v].is_in_sync());
+            CHECK_EQUAL(views[v].size(), expected[v].size());
+            bool same = views[v].size() == expected[v].size();
+            for (size_t i = 0; same && i < views[v].size(); i++)
+                same = views[v].get_key(i) == expected[v].get_key(i);
+            CHECK(same);
+        }
+    }
+
+    // A change of the schema makes the views sync in full
+    {
+        auto wt = db->start_write();
+        auto t = wt->get_table("table");
+        t->add_column(type_Int, "other");
+        t->get_object(0).set(col_value, 45);
+        wt->commit();
+    }
+    rt->advance_read();
+    std::vector<TableView> expected = make_views();
+    for (size_t v = 0; v < views.size(); v++) {
+        views[v].sync_if_needed();
+        CHECK_EQUAL(views[v].size(), expected[v].size());
+    }
+}
+
+TEST(TableView_IncrementalSyncSorted)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_value;
+    ColKey col_name;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_value = table->add_column(type_Double, "value", true);
+        col_name = table->add_column(type_String, "name", true);
+        for (int i = 0; i < 2000; i++)
+            table->create_object().set(col_value, double(i % 50)).set(col_name, std::string(1, char('a' + i % 7)));
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+    auto make_views = [&] {
+        std::vector<TableView> views;
+        views.push_back(table->where().find_all());
+        views.back().sort(SortDescriptor({{col_value}, {col_name}}, {false, true}));
+        views.push_back(table->where().greater(col_value, 10.0).find_all());
+        views.back().sort(col_name);
+        return views;
+    };
+    std::vector<TableView> views = make_views();
+    for (auto& tv : views)
+        tv.set_incremental_sync(true);
+    // A copy is kept up to date on its own
+    views.push_back(views[0]);
+
+    auto check_views = [&] {
+        std::vector<TableView> expected = make_views();
+        expected.push_back(expected[0]);
+        for (size_t v = 0; v < views.size(); v++) {
+            CHECK(!views[v].is_in_sync());
+            views[v].sync_if_needed();
+            CHECK(views[v].is_in_sync());
+            CHECK_EQUAL(views[v].size(), expected[v].size());
+            bool same = views[v].size() == expected[v].size();
+            for (size_t i = 0; same && i < views[v].size(); i++)
+                same = views[v].get_key(i) == expected[v].get_key(i);
+            CHECK(same);
+        }
+    };
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int round = 0; round < 20; round++) {
+        {
+            // Move a few objects to the other end of the sort, and in between objects with equal values
+            auto wt = db->start_write();
+            auto t = wt->get_table("table");
+            for (int i = 0; i < 5; i++) {
+                Obj obj = t->get_object(random.draw_int<size_t>(0, t->size() - 1));
+                switch (random.draw_int<int>(0, 3)) {
+                    case 0:
+                        obj.set(col_value, 49.0 - obj.get<util::Optional<double>>(col_value).value_or(0));
+                        break;
+                    case 1:
+                        obj.set_null(col_name);
+                        break;
+                    case 2:
+                        obj.remove();
+                        break;
+                    case 3:
+                        t->create_object().set(col_value, double(random.draw_int<int>(0, 50)));
+                        break;
+                }
+            }
+            wt->commit();
+        }
+        rt->advance_read();
+        check_views();
+    }
+
+    // Large change sets rerun the query and sort the result again
+    {
+        auto wt = db->start_write();
+        auto t = wt->get_table("table");
+        for (auto& obj : *t)
+            obj.set(col_value, double(random.draw_int<int>(0, 50)));
+        wt->commit();
+    }
+    rt->advance_read();
+    check_views();
+
+    // A view given another sort is sorted again, and then patched in its new order
+    DescriptorOrdering ordering;
+    ordering.append_sort(SortDescriptor({{col_value}}));
+    TableView& tv = views[1];
+    tv.apply_descriptor_ordering(ordering);
+    {
+        auto wt = db->start_write();
+        auto t = wt->get_table("table");
+        for (int i = 0; i < 5; i++)
+            t->get_object(random.draw_int<size_t>(0, t->size() - 1)).set(col_value, double(i * 10));
+        wt->commit();
+    }
+    rt->advance_read();
+    tv.sync_if_needed();
+    TableView expected = table->where().greater(col_value, 10.0).find_all();
+    expected.sort(col_value);
+    CHECK_EQUAL(tv.size(), expected.size());
+    bool same = tv.size() == expected.size();
+    for (size_t i = 0; same && i < tv.size(); i++)
+        same = tv.get_key(i) == expected.get_key(i);
+    CHECK(same);
+}
+
 #endif // TEST_TABLE_VIEW
@@ -40,6 +40,7 @@
 #include <realm/util/thread.hpp>
 #include <realm/util/interprocess_condvar.hpp>
 #include <realm/util/interprocess_mutex.hpp>
+#include <realm/util/worker_pool.hpp>
 
 #include <iostream>
 #include "test.hpp"
@@ -1018,6 +1019,35 @@ TEST_IF(Thread_CondvarAtomicWaitUnlock, !running_with_valgrind && TEST_DURATION
     }
 }
 
+TEST(Thread_WorkerPool)
+{
+    WorkerPool pool(3);
+    for (int run = 0; run < 10; ++run) {
+        std::atomic<int> parts_done[20] = {};
+        pool.run(20, [&](size_t part) {
+            ++parts_done[part];
+        });
+        for (auto& done : parts_done)
+            CHECK_EQUAL(done.load(), 1);
+    }
+
+    // A part cannot start a run on the same pool, but runs its work itself
+    pool.set_num_threads(1);
+    std::atomic<int> nested(0);
+    std::atomic<int> refused(0);
+    pool.run(2, [&](size_t) {
+        if (!pool.try_run(2, [&](size_t) { ++nested; }))
+            ++refused;
+    });
+    CHECK_EQUAL(refused.load(), 2);
+    CHECK_EQUAL(nested.load(), 0);
+
+    pool.set_num_threads(0);
+    size_t sum = 0;
+    CHECK(pool.try_run(4, [&](size_t part) { sum += part; }));
+    CHECK_EQUAL(sum, 6);
+}
+
 #ifdef _WIN32
 TEST(Thread_Win32InterprocessBackslashes)
 {